@@ -0,0 +1,76 @@
+/*
+ * Замеры вывода списка книг:
+ * - endl - построчно через operator<< со сбросом потока (std::endl) после каждой строки,
+ *   как выводились списки до появления ui::Renderer;
+ * - text, tsv, jsonl - ui::Renderer в соответствующем формате.
+ * Вывод идёт в /dev/null через std::ofstream, поэтому каждый сброс потока - системный вызов write,
+ * как при выводе в канал или файл. items_per_second - число выведенных строк.
+ * Выбор замеров: --benchmark_filter='^render/'
+ */
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/domain/author.h"
+#include "../src/ui/renderer.h"
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t ROWS = 10'000;
+
+struct Row {
+    std::string id;
+    std::string title;
+    std::string author_name;
+    int publication_year = 0;
+};
+
+const std::vector<Row>& GetRows() {
+    static const std::vector<Row> rows = [] {
+        std::vector<Row> rows;
+        rows.reserve(ROWS);
+        for (size_t i = 0; i < ROWS; ++i) {
+            rows.push_back({domain::BookId::New().ToString(), "Book "s + std::to_string(i),
+                            "Author "s + std::to_string(i / 10), static_cast<int>(1800 + i % 200)});
+        }
+        return rows;
+    }();
+    return rows;
+}
+
+void PrintWithEndl(benchmark::State& state) {
+    const auto& rows = GetRows();
+    std::ofstream out{"/dev/null"};
+    for (auto _ : state) {
+        size_t index = 1;
+        for (const auto& row : rows) {
+            out << index++ << " " << row.title << " by " << row.author_name << ", " << row.publication_year
+                << std::endl;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ROWS);
+}
+
+void Render(benchmark::State& state, ui::OutputFormat format) {
+    const auto& rows = GetRows();
+    std::ofstream out{"/dev/null"};
+    for (auto _ : state) {
+        ui::Renderer renderer{out, format};
+        size_t index = 1;
+        for (const auto& row : rows) {
+            renderer.BookRow(index++, row.id, row.title, row.author_name, row.publication_year);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ROWS);
+}
+
+}  // namespace
+
+BENCHMARK(PrintWithEndl)->Name("render/ShowBooks/endl");
+BENCHMARK_CAPTURE(Render, text, ui::OutputFormat::TEXT)->Name("render/ShowBooks/text");
+BENCHMARK_CAPTURE(Render, tsv, ui::OutputFormat::TSV)->Name("render/ShowBooks/tsv");
+BENCHMARK_CAPTURE(Render, jsonl, ui::OutputFormat::JSON_LINES)->Name("render/ShowBooks/jsonl");
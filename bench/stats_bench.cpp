@@ -0,0 +1,39 @@
+/*
+ * Замеры накладных расходов статистики времени выполнения на одну операцию:
+ * - clock - только два вызова steady_clock::now(), без которых замер невозможен;
+ * - ScopedTimer - замер и запись в гистограмму, в том числе из нескольких потоков в одну метрику.
+ * Выбор замеров: --benchmark_filter='^stats/'
+ */
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+#include "../src/stats/stats.h"
+
+using namespace std::literals;
+
+namespace {
+
+void ReadClock(benchmark::State& state) {
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        benchmark::DoNotOptimize(start);
+        auto stop = std::chrono::steady_clock::now();
+        benchmark::DoNotOptimize(stop);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void RecordScopedTimer(benchmark::State& state) {
+    auto& metric = stats::GetMetric("bench/ScopedTimer"sv);
+    for (auto _ : state) {
+        stats::ScopedTimer timer{metric};
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(ReadClock)->Name("stats/clock");
+BENCHMARK(RecordScopedTimer)->Name("stats/ScopedTimer")->ThreadRange(1, 4);
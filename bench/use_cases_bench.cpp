@@ -0,0 +1,814 @@
+/*
+ * Замеры производительности операций app::UseCases на каталогах из 1 тыс., 100 тыс. и 1 млн книг.
+ * Хранилища:
+ * - memory - модуль хранения в памяти процесса;
+ * - postgres - СУБД по адресу из переменной окружения BOOKYPEDIA_DB_URL
+ *   (замеры выполняются, только если она задана). ВНИМАНИЕ: данные в базе заменяются тестовым каталогом,
+ *   поэтому база с авторами или книгами используется, только если задана BOOKYPEDIA_BENCH_ALLOW_TRUNCATE=1.
+ * postgres/Startup - создание модуля хранения при актуальной схеме (время запуска приложения).
+ * postgres-schema1 - операции, которые ускоряют миграции 2 и 3, на той же базе без их внешних ключей
+ *   и индексов: замеры "до" для сравнения с postgres. Книги автора удаляются, как до каскадных
+ *   внешних ключей, отдельными запросами. После замеров схема восстанавливается миграциями.
+ * Сценарии используют группу команд и снимок хранилища так же, как bookypedia::Application,
+ * а каждую запись выполняют, как команда View, в единице работы (app::WorkScope).
+ * Для каждой операции кроме пропускной способности (items_per_second) выводятся
+ * медиана и 99-й перцентиль задержки (p50_us, p99_us).
+ * Результаты в формате JSON для сравнения версий:
+ *   bench --benchmark_out=result.json --benchmark_out_format=json
+ * Отдельные замеры выбираются фильтром, например --benchmark_filter='^memory/.+/1000/'
+ */
+#include <benchmark/benchmark.h>
+#include <pqxx/pqxx>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <span>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "../src/app/use_cases_impl.h"
+#include "../src/memory/memory.h"
+#include "../src/postgres/migrations.h"
+#include "../src/postgres/postgres.h"
+
+using namespace std::literals;
+using pqxx::operator"" _zv;
+
+namespace {
+
+constexpr const char DB_URL_ENV_NAME[]{"BOOKYPEDIA_DB_URL"};
+constexpr const char ALLOW_TRUNCATE_ENV_NAME[]{"BOOKYPEDIA_BENCH_ALLOW_TRUNCATE"};
+constexpr size_t CATALOG_SIZES[]{1'000, 100'000, 1'000'000};
+constexpr size_t BOOKS_PER_AUTHOR = 10;
+constexpr size_t SEED_BATCH_SIZE = 10'000;
+constexpr size_t SAMPLE_SIZE = 256;
+constexpr size_t PAGE_SIZE = 50;
+
+enum class Backend { MEMORY, POSTGRES, POSTGRES_SCHEMA_1 };
+
+std::string SeedAuthorName(size_t author) {
+    return "Author "s + std::to_string(author);
+}
+
+/* Две книги подряд - издания одного названия */
+std::string SeedBookTitle(size_t book) {
+    return "Book "s + std::to_string(book / 2);
+}
+
+domain::CatalogRecord MakeRecord(size_t book) {
+    return {SeedAuthorName(book / BOOKS_PER_AUTHOR), SeedBookTitle(book), 1800 + book % 200,
+            {"tag "s + std::to_string(book % 100), "genre "s + std::to_string(book % 7)}};
+}
+
+/* Заполненное хранилище и выборка существующих авторов и книг для запросов */
+class Catalog {
+public:
+    Catalog(Backend backend, size_t size)
+        : backend_{backend}
+        , size_{size} {
+        if (backend == Backend::MEMORY) {
+            memory_db_ = std::make_unique<memory::Database>();
+            use_cases_ = std::make_unique<app::UseCasesImpl>(memory_db_->GetAuthors(), memory_db_->GetBooks(),
+                                                             &memory_db_->GetCommandBatch(),
+                                                             &memory_db_->GetReadSnapshot());
+            Seed(memory_db_->GetBooks());
+        } else {
+            db_ = std::make_unique<postgres::Database>(std::getenv(DB_URL_ENV_NAME), 1);
+            use_cases_ = std::make_unique<app::UseCasesImpl>(db_->GetAuthors(), db_->GetBooks(), &db_->GetCommandBatch(),
+                                                             &db_->GetReadSnapshot());
+            {
+                auto connection = db_->GetConnectionPool().GetConnection();
+                pqxx::work work{*connection};
+                work.exec("TRUNCATE book_tags, books, authors;"sv);
+                work.commit();
+            }
+            Seed(db_->GetBooks());
+            Analyze();
+        }
+        Sample();
+        if (backend == Backend::POSTGRES_SCHEMA_1) {
+            DowngradeSchema();
+            Analyze();
+        }
+    }
+
+    Catalog(const Catalog&) = delete;
+    Catalog& operator=(const Catalog&) = delete;
+
+    /* Схема восстанавливается так же, как при запуске приложения */
+    ~Catalog() {
+        if (backend_ != Backend::POSTGRES_SCHEMA_1) {
+            return;
+        }
+        try {
+            auto connection = db_->GetConnectionPool().GetConnection();
+            postgres::MigrateSchema(*connection);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to restore the database schema: "sv << e.what() << std::endl;
+        }
+    }
+
+    bool Is(Backend backend, size_t size) const {
+        return backend_ == backend && size_ == size;
+    }
+
+    app::UseCases& GetUseCases() {
+        return *use_cases_;
+    }
+
+    postgres::Database& GetDatabase() {
+        return *db_;
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+    const std::string& AuthorId(size_t i) const {
+        return author_ids_[i % author_ids_.size()];
+    }
+
+    const std::string& AuthorName(size_t i) const {
+        return author_names_[i % author_names_.size()];
+    }
+
+    const domain::BookWithAuthor& Book(size_t i) const {
+        return books_[i % books_.size()];
+    }
+
+private:
+    void Seed(domain::BookRepository& books) {
+        std::vector<domain::CatalogRecord> batch;
+        batch.reserve(SEED_BATCH_SIZE);
+        for (size_t book = 0; book < size_; ++book) {
+            batch.push_back(MakeRecord(book));
+            if (batch.size() == SEED_BATCH_SIZE) {
+                books.Import(batch);
+                batch.clear();
+            }
+        }
+        if (!batch.empty()) {
+            books.Import(batch);
+        }
+    }
+
+    void Analyze() {
+        auto connection = db_->GetConnectionPool().GetConnection();
+        pqxx::nontransaction work{*connection};
+        work.exec("ANALYZE authors, books, book_tags;"sv);
+    }
+
+    /* Схема версии 1: без внешних ключей миграции 2 и индексов миграции 3. Версии от 2 и выше
+     * забываются, чтобы MigrateSchema применила их снова (миграция 4 повторяется без изменений) */
+    void DowngradeSchema() {
+        auto connection = db_->GetConnectionPool().GetConnection();
+        pqxx::work work{*connection};
+        work.exec(R"(
+ALTER TABLE book_tags DROP CONSTRAINT IF EXISTS book_tags_book_id_fkey;
+ALTER TABLE books DROP CONSTRAINT IF EXISTS books_author_id_fkey;
+DROP INDEX IF EXISTS books_author_id_idx, books_title_idx, book_tags_book_id_idx, book_tags_tag_idx;
+DELETE FROM schema_version WHERE version >= 2;
+)"sv);
+        work.commit();
+    }
+
+    /* Случайные, но одинаковые от запуска к запуску авторы и книги со всего каталога */
+    void Sample() {
+        std::mt19937_64 random{size_};
+        std::uniform_int_distribution<size_t> book_distribution{0, size_ - 1};
+        for (size_t i = 0; i < SAMPLE_SIZE; ++i) {
+            const size_t book = book_distribution(random);
+            author_names_.push_back(SeedAuthorName(book / BOOKS_PER_AUTHOR));
+            author_ids_.push_back(use_cases_->GetAuthorID(author_names_.back()));
+            auto editions = use_cases_->ShowBookFullInfoByTitle(SeedBookTitle(book));
+            books_.push_back(std::move(editions.front()));
+        }
+    }
+
+    Backend backend_;
+    size_t size_;
+    std::unique_ptr<memory::Database> memory_db_;
+    std::unique_ptr<postgres::Database> db_;
+    std::unique_ptr<app::UseCasesImpl> use_cases_;
+    std::vector<std::string> author_ids_;
+    std::vector<std::string> author_names_;
+    std::vector<domain::BookWithAuthor> books_;
+};
+
+/* Каталог заполняется при первом замере с данными хранилищем и размером.
+ * Замеры зарегистрированы так, что каталог пересоздаётся только при смене хранилища или размера */
+Catalog& GetCatalog(Backend backend, size_t size) {
+    static std::unique_ptr<Catalog> catalog;
+    if (!catalog || !catalog->Is(backend, size)) {
+        catalog.reset();
+        catalog = std::make_unique<Catalog>(backend, size);
+    }
+    return *catalog;
+}
+
+/* Замер задержки отдельных вызовов. Время подготовки и уборки между вызовами
+ * в результат не попадает (UseManualTime) */
+class LatencyRecorder {
+public:
+    explicit LatencyRecorder(benchmark::State& state)
+        : state_{state} {
+    }
+
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    ~LatencyRecorder() {
+        if (latencies_.empty()) {
+            return;
+        }
+        std::sort(latencies_.begin(), latencies_.end());
+        state_.counters["p50_us"] = Percentile(0.50);
+        state_.counters["p99_us"] = Percentile(0.99);
+        state_.SetItemsProcessed(static_cast<int64_t>(state_.iterations()));
+    }
+
+    template <typename Fn>
+    void Measure(Fn&& fn) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        state_.SetIterationTime(elapsed.count());
+        latencies_.push_back(elapsed.count());
+    }
+
+private:
+    double Percentile(double p) const {
+        const size_t index = static_cast<size_t>(p * static_cast<double>(latencies_.size() - 1));
+        return latencies_[index] * 1e6;
+    }
+
+    benchmark::State& state_;
+    std::vector<double> latencies_;
+};
+
+/* Поток вывода, отбрасывающий данные: экспорт замеряется без записи на диск */
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+};
+
+/* Запись в единице работы, как в командах View: изменения записываются в хранилище при Commit */
+template <typename Fn>
+void Write(app::UseCases& use_cases, Fn&& fn) {
+    app::WorkScope work{use_cases};
+    fn();
+    work.Commit();
+}
+
+domain::BookPageCursor MakeBookPageCursor(const domain::BookWithAuthor& book) {
+    return {book.GetBook().GetTitle(), book.GetAuthorName(), book.GetBook().GetPublicationYear(),
+            book.GetBook().GetId()};
+}
+
+/* ---------------------------- Author ---------------------------- */
+
+void AddAuthor(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        domain::AuthorId id;
+        latency.Measure([&] {
+            Write(use_cases, [&] {
+                id = use_cases.AddAuthor("Bench author"s);
+            });
+        });
+        Write(use_cases, [&] {
+            use_cases.DeleteAuthorByID(id.ToString());
+        });
+    }
+}
+
+void GetAuthorName(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& id = catalog.AuthorId(i++);
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.GetAuthorName(id));
+        });
+    }
+}
+
+void GetAuthorID(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& name = catalog.AuthorName(i++);
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.GetAuthorID(name));
+        });
+    }
+}
+
+void ShowAuthors(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowAuthors());
+        });
+    }
+}
+
+void ShowAuthorsPage(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::optional<std::string> after = catalog.AuthorName(i++);
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowAuthorsPage(after, PAGE_SIZE));
+        });
+    }
+}
+
+/* Удаляется автор с BOOKS_PER_AUTHOR книгами: в замер входит каскадное удаление книг и тегов */
+template <bool ByName>
+void DeleteAuthor(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        std::string id;
+        Write(use_cases, [&] {
+            id = use_cases.AddAuthor("Bench author"s).ToString();
+            for (size_t book = 0; book < BOOKS_PER_AUTHOR; ++book) {
+                use_cases.AddBook(id, "Bench book"s, 2000 + book, {"bench"s});
+            }
+        });
+        latency.Measure([&] {
+            Write(use_cases, [&] {
+                if constexpr (ByName) {
+                    use_cases.DeleteAuthorByName("Bench author"s);
+                } else {
+                    use_cases.DeleteAuthorByID(id);
+                }
+            });
+        });
+    }
+}
+
+/* Удаление автора до каскадных внешних ключей: теги, книги и автор удалялись отдельными запросами
+ * в одной транзакции. Выполняется на схеме версии 1, где каскада нет */
+template <bool ByName>
+void DeleteAuthorWithoutCascade(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    auto& pool = catalog.GetDatabase().GetConnectionPool();
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        std::string id;
+        Write(use_cases, [&] {
+            id = use_cases.AddAuthor("Bench author"s).ToString();
+            for (size_t book = 0; book < BOOKS_PER_AUTHOR; ++book) {
+                use_cases.AddBook(id, "Bench book"s, 2000 + book, {"bench"s});
+            }
+        });
+        latency.Measure([&] {
+            auto connection = pool.GetConnection();
+            pqxx::work work{*connection};
+            if constexpr (ByName) {
+                const std::string name = "Bench author"s;
+                work.exec_params(R"(
+DELETE FROM book_tags
+WHERE book_id IN (
+    SELECT id FROM books
+    WHERE author_id IN (
+        SELECT id FROM authors
+        WHERE name = $1
+    )
+);)"_zv, name);
+                work.exec_params(R"(
+DELETE FROM books
+WHERE author_id IN (
+    SELECT id FROM authors
+    WHERE name = $1
+);)"_zv, name);
+                work.exec_params("DELETE FROM authors WHERE name = $1;"_zv, name);
+            } else {
+                work.exec_params(R"(
+DELETE FROM book_tags
+WHERE book_id IN (
+    SELECT id FROM books
+    WHERE author_id = $1
+);)"_zv, id);
+                work.exec_params("DELETE FROM books WHERE author_id = $1;"_zv, id);
+                work.exec_params("DELETE FROM authors WHERE id = $1;"_zv, id);
+            }
+            work.commit();
+        });
+    }
+}
+
+template <bool ByName>
+void EditAuthor(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    std::string id;
+    Write(use_cases, [&] {
+        id = use_cases.AddAuthor("Bench author"s).ToString();
+        for (size_t book = 0; book < BOOKS_PER_AUTHOR; ++book) {
+            use_cases.AddBook(id, "Bench book"s, 2000 + book, {});
+        }
+    });
+    LatencyRecorder latency{state};
+    bool renamed = false;
+    for (auto _ : state) {
+        const std::string old_name = renamed ? "Renamed bench author"s : "Bench author"s;
+        const std::string new_name = renamed ? "Bench author"s : "Renamed bench author"s;
+        latency.Measure([&] {
+            Write(use_cases, [&] {
+                if constexpr (ByName) {
+                    use_cases.EditAuthorByName(old_name, new_name);
+                } else {
+                    use_cases.EditAuthorByID(id, new_name);
+                }
+            });
+        });
+        renamed = !renamed;
+    }
+    Write(use_cases, [&] {
+        use_cases.DeleteAuthorByID(id);
+    });
+}
+
+/* ---------------------------- Book ---------------------------- */
+
+void AddBook(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    std::string author_id;
+    Write(use_cases, [&] {
+        author_id = use_cases.AddAuthor("Bench author"s).ToString();
+    });
+    const std::vector tags{"bench"s, "tag 1"s, "genre 1"s};
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        latency.Measure([&] {
+            Write(use_cases, [&] {
+                use_cases.AddBook(author_id, "Bench book"s, 2000, tags);
+            });
+        });
+    }
+    Write(use_cases, [&] {
+        use_cases.DeleteAuthorByID(author_id);
+    });
+}
+
+void DeleteBook(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    std::string author_id;
+    Write(use_cases, [&] {
+        author_id = use_cases.AddAuthor("Bench author"s).ToString();
+    });
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        Write(use_cases, [&] {
+            use_cases.AddBook(author_id, "Bench book"s, 2000, {"bench"s});
+        });
+        const std::string id = use_cases.ShowAuthorBooks(author_id).front().GetId().ToString();
+        latency.Measure([&] {
+            Write(use_cases, [&] {
+                use_cases.DeleteBook(id);
+            });
+        });
+    }
+    Write(use_cases, [&] {
+        use_cases.DeleteAuthorByID(author_id);
+    });
+}
+
+void EditBook(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& book = catalog.Book(i++).GetBook();
+        const std::string id = book.GetId().ToString();
+        const std::string author_id = book.GetAuthorId().ToString();
+        latency.Measure([&] {
+            Write(use_cases, [&] {
+                use_cases.EditBook(id, author_id, book.GetTitle(), book.GetPublicationYear(), book.GetTags());
+            });
+        });
+    }
+}
+
+void ShowAllBooks(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowAllBooks());
+        });
+    }
+}
+
+void ShowAllBooksWithAuthors(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowAllBooksWithAuthors(true));
+        });
+    }
+}
+
+void ShowAuthorBooks(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& author_id = catalog.AuthorId(i++);
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowAuthorBooks(author_id));
+        });
+    }
+}
+
+void ShowBookInfoByID(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string id = catalog.Book(i++).GetBook().GetId().ToString();
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowBookInfoByID(id));
+        });
+    }
+}
+
+void ShowBookInfoByTitle(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& title = catalog.Book(i++).GetBook().GetTitle();
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowBookInfoByTitle(title));
+        });
+    }
+}
+
+void ShowBookFullInfoByID(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string id = catalog.Book(i++).GetBook().GetId().ToString();
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowBookFullInfoByID(id));
+        });
+    }
+}
+
+void ShowBookFullInfoByTitle(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& title = catalog.Book(i++).GetBook().GetTitle();
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowBookFullInfoByTitle(title));
+        });
+    }
+}
+
+/* Страницы начинаются со случайных книг каталога, а не только с первой */
+void ShowBooksPage(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::optional<domain::BookPageCursor> after = MakeBookPageCursor(catalog.Book(i++));
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowBooksPage(after, PAGE_SIZE));
+        });
+    }
+}
+
+void ShowAuthorBooksPage(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& author_id = catalog.AuthorId(i++);
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowAuthorBooksPage(author_id, std::nullopt, PAGE_SIZE));
+        });
+    }
+}
+
+/* Первая страница книг с тегом: каждый "tag N" есть у 1% каталога */
+void ShowBooksByTag(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string tag = "tag "s + std::to_string(i++ % 100);
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowBooksByTag(tag, std::nullopt, PAGE_SIZE));
+        });
+    }
+}
+
+/* Пересечение тегов: у книги book есть "tag book % 100" и "genre book % 7" */
+void ShowBooksByAllTags(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::vector tags{"tag "s + std::to_string(i % 100), "genre "s + std::to_string(i % 7)};
+        ++i;
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ShowBooksByTags(tags, domain::TagMatch::ALL, std::nullopt, PAGE_SIZE));
+        });
+    }
+}
+
+/* Запросом служит название случайной книги: находятся и похожие названия других книг */
+void SearchBooks(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    LatencyRecorder latency{state};
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& query = catalog.Book(i++).GetBook().GetTitle();
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.SearchBooks(query, std::nullopt, PAGE_SIZE));
+        });
+    }
+}
+
+/* Импортируется пакет из 1000 книг одного автора, после замера автор с книгами удаляется */
+void ImportCatalog(benchmark::State& state, Catalog& catalog) {
+    constexpr size_t IMPORT_SIZE = 1'000;
+    auto& use_cases = catalog.GetUseCases();
+    std::ostringstream csv;
+    csv << "author,title,publication_year,tags\n"sv;
+    for (size_t book = 0; book < IMPORT_SIZE; ++book) {
+        csv << "Bench author,Imported book "sv << book << ',' << 2000 + book % 20 << ",bench;imported\n"sv;
+    }
+    const std::string text = csv.str();
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        std::istringstream input{text};
+        latency.Measure([&] {
+            use_cases.ImportCatalog(input, app::CatalogFormat::CSV, IMPORT_SIZE);
+        });
+        Write(use_cases, [&] {
+            use_cases.DeleteAuthorByName("Bench author"s);
+        });
+    }
+    state.counters["books_per_second"] = benchmark::Counter(
+            static_cast<double>(state.iterations() * IMPORT_SIZE), benchmark::Counter::kIsRate);
+}
+
+void ExportCatalog(benchmark::State& state, Catalog& catalog) {
+    auto& use_cases = catalog.GetUseCases();
+    NullBuffer buffer;
+    std::ostream output{&buffer};
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        latency.Measure([&] {
+            benchmark::DoNotOptimize(use_cases.ExportCatalog(output, app::CatalogFormat::CSV));
+        });
+    }
+    state.counters["books_per_second"] = benchmark::Counter(
+            static_cast<double>(state.iterations() * catalog.GetSize()), benchmark::Counter::kIsRate);
+}
+
+/* Запуск с актуальной схемой: подключение и проверка версии схемы (каталог не нужен) */
+void StartupWithUpToDateSchema(benchmark::State& state) {
+    const char* db_url = std::getenv(DB_URL_ENV_NAME);
+    postgres::Database{db_url, 1};
+    LatencyRecorder latency{state};
+    for (auto _ : state) {
+        latency.Measure([&] {
+            postgres::Database db{db_url, 1};
+            benchmark::DoNotOptimize(&db);
+        });
+    }
+}
+
+using Operation = void (*)(benchmark::State&, Catalog&);
+
+/* Операция, создающая ключи UUIDv7: новые строки добавляются в конец индекса первичного ключа,
+ * а не в случайные его страницы. Каталог заполнен случайными ключами v4 */
+template <Operation operation>
+void WithTimeOrderedIds(benchmark::State& state, Catalog& catalog) {
+    util::SetUUIDVersion(util::UUIDVersion::TIME_ORDERED);
+    operation(state, catalog);
+    util::SetUUIDVersion(util::UUIDVersion::RANDOM);
+}
+
+struct NamedOperation {
+    const char* name;
+    Operation operation;
+};
+
+constexpr NamedOperation OPERATIONS[]{
+    {"AddAuthor", AddAuthor},
+    {"GetAuthorName", GetAuthorName},
+    {"GetAuthorID", GetAuthorID},
+    {"ShowAuthors", ShowAuthors},
+    {"ShowAuthorsPage", ShowAuthorsPage},
+    {"DeleteAuthorByID", DeleteAuthor<false>},
+    {"DeleteAuthorByName", DeleteAuthor<true>},
+    {"EditAuthorByID", EditAuthor<false>},
+    {"EditAuthorByName", EditAuthor<true>},
+    {"AddBook", AddBook},
+    {"DeleteBook", DeleteBook},
+    {"EditBook", EditBook},
+    {"ShowAllBooks", ShowAllBooks},
+    {"ShowAllBooksWithAuthors", ShowAllBooksWithAuthors},
+    {"ShowAuthorBooks", ShowAuthorBooks},
+    {"ShowBookInfoByID", ShowBookInfoByID},
+    {"ShowBookInfoByTitle", ShowBookInfoByTitle},
+    {"ShowBookFullInfoByID", ShowBookFullInfoByID},
+    {"ShowBookFullInfoByTitle", ShowBookFullInfoByTitle},
+    {"ShowBooksPage", ShowBooksPage},
+    {"ShowAuthorBooksPage", ShowAuthorBooksPage},
+    {"ShowBooksByTag", ShowBooksByTag},
+    {"ShowBooksByTags", ShowBooksByAllTags},
+    {"SearchBooks", SearchBooks},
+    {"ImportCatalog", ImportCatalog},
+    {"AddBookV7", WithTimeOrderedIds<AddBook>},
+    {"ImportCatalogV7", WithTimeOrderedIds<ImportCatalog>},
+    {"ExportCatalog", ExportCatalog},
+};
+
+/* Операции, которые ускоряют внешние ключи и индексы миграций 2 и 3 */
+constexpr NamedOperation SCHEMA_1_OPERATIONS[]{
+    {"DeleteAuthorByID", DeleteAuthorWithoutCascade<false>},
+    {"DeleteAuthorByName", DeleteAuthorWithoutCascade<true>},
+    {"ShowAuthorBooks", ShowAuthorBooks},
+    {"ShowAuthorBooksPage", ShowAuthorBooksPage},
+    {"ShowBookInfoByTitle", ShowBookInfoByTitle},
+    {"ShowBooksByTag", ShowBooksByTag},
+};
+
+/* Каталог в базе можно заменить, если это явно разрешено или в ней нет ни авторов, ни книг */
+bool CanReplaceDatabaseCatalog(const char* db_url) {
+    if (const char* allow = std::getenv(ALLOW_TRUNCATE_ENV_NAME); allow && allow == "1"sv) {
+        return true;
+    }
+    pqxx::connection connection{db_url};
+    pqxx::nontransaction read{connection};
+    try {
+        return !read.query_value<bool>(
+                "SELECT EXISTS (SELECT 1 FROM authors) OR EXISTS (SELECT 1 FROM books)");
+    } catch (const pqxx::undefined_table&) {
+        return true;
+    }
+}
+
+void RegisterBenchmarks(Backend backend, std::string_view backend_name,
+                        std::span<const NamedOperation> operations = OPERATIONS) {
+    for (size_t size : CATALOG_SIZES) {
+        for (const auto& [name, operation] : operations) {
+            const std::string benchmark_name = std::string{backend_name} + '/' + name + '/' + std::to_string(size);
+            benchmark::RegisterBenchmark(benchmark_name.c_str(), [backend, size, operation](benchmark::State& state) {
+                operation(state, GetCatalog(backend, size));
+            })->UseManualTime()->Unit(benchmark::kMicrosecond);
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+    RegisterBenchmarks(Backend::MEMORY, "memory"sv);
+    if (const char* db_url = std::getenv(DB_URL_ENV_NAME)) {
+        if (!CanReplaceDatabaseCatalog(db_url)) {
+            std::cerr << DB_URL_ENV_NAME << " points to a database with data that the benchmarks would delete. "sv
+                      << "Use an empty database or set "sv << ALLOW_TRUNCATE_ENV_NAME << "=1"sv << std::endl;
+            return EXIT_FAILURE;
+        }
+        RegisterBenchmarks(Backend::POSTGRES, "postgres"sv);
+        benchmark::RegisterBenchmark("postgres/Startup", StartupWithUpToDateSchema)
+                ->UseManualTime()
+                ->Unit(benchmark::kMillisecond);
+        // После Startup: на схеме версии 1 создание модуля хранения применяло бы миграции
+        RegisterBenchmarks(Backend::POSTGRES_SCHEMA_1, "postgres-schema1"sv, SCHEMA_1_OPERATIONS);
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+}
@@ -0,0 +1,129 @@
+/*
+ * Замеры преобразования идентификаторов между util::TaggedUUID и текстом:
+ * - boost - прежний путь через std::string, boost::uuids::to_string и string_generator;
+ * - traits - pqxx::string_traits из модуля хранения, без выделения памяти.
+ * Строка результата запроса о книге содержит два идентификатора (книги и автора),
+ * поэтому items_per_second - число разобранных или записанных строк.
+ * Создание идентификаторов (uuid/New/...): boost_per_call - прежний генератор, создаваемый на каждый вызов,
+ * random и time_ordered - TaggedUUID::New() в режимах util::UUIDVersion.
+ * Выбор замеров: --benchmark_filter='^uuid/'
+ */
+#include <benchmark/benchmark.h>
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/string_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/domain/author.h"
+#include "../src/postgres/tagged_uuid_traits.h"
+
+namespace {
+
+constexpr size_t ROWS = 1'024;
+
+struct RowIds {
+    std::string book_id;
+    std::string author_id;
+};
+
+std::vector<RowIds> MakeRows() {
+    std::vector<RowIds> rows;
+    rows.reserve(ROWS);
+    for (size_t i = 0; i < ROWS; ++i) {
+        rows.push_back({domain::BookId::New().ToString(), domain::AuthorId::New().ToString()});
+    }
+    return rows;
+}
+
+template <typename Id>
+Id BoostFromString(std::string_view field) {
+    // Так читалось поле до появления string_traits: field.as<std::string>(), затем разбор
+    const std::string text{field};
+    return Id{boost::uuids::string_generator()(text.begin(), text.end())};
+}
+
+void DecodeRowBoost(benchmark::State& state) {
+    const auto rows = MakeRows();
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& row = rows[i++ % ROWS];
+        benchmark::DoNotOptimize(BoostFromString<domain::BookId>(row.book_id));
+        benchmark::DoNotOptimize(BoostFromString<domain::AuthorId>(row.author_id));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void DecodeRowTraits(benchmark::State& state) {
+    const auto rows = MakeRows();
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& row = rows[i++ % ROWS];
+        benchmark::DoNotOptimize(pqxx::string_traits<domain::BookId>::from_string(row.book_id));
+        benchmark::DoNotOptimize(pqxx::string_traits<domain::AuthorId>::from_string(row.author_id));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+std::vector<domain::Book> MakeBooks() {
+    std::vector<domain::Book> books;
+    books.reserve(ROWS);
+    for (size_t i = 0; i < ROWS; ++i) {
+        books.emplace_back(domain::BookId::New(), domain::AuthorId::New(), std::string{}, 0);
+    }
+    return books;
+}
+
+void EncodeParamsBoost(benchmark::State& state) {
+    const auto books = MakeBooks();
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& book = books[i++ % ROWS];
+        benchmark::DoNotOptimize(boost::uuids::to_string(*book.GetId()));
+        benchmark::DoNotOptimize(boost::uuids::to_string(*book.GetAuthorId()));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void EncodeParamsTraits(benchmark::State& state) {
+    const auto books = MakeBooks();
+    std::array<char, util::detail::UUID_STRING_SIZE + 1> buffer;
+    size_t i = 0;
+    for (auto _ : state) {
+        const auto& book = books[i++ % ROWS];
+        benchmark::DoNotOptimize(pqxx::string_traits<domain::BookId>::to_buf(
+                buffer.data(), buffer.data() + buffer.size(), book.GetId()));
+        benchmark::DoNotOptimize(pqxx::string_traits<domain::AuthorId>::to_buf(
+                buffer.data(), buffer.data() + buffer.size(), book.GetAuthorId()));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void NewBoostPerCall(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(boost::uuids::random_generator()());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void NewTaggedUUID(benchmark::State& state, util::UUIDVersion version) {
+    util::SetUUIDVersion(version);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(domain::BookId::New());
+    }
+    util::SetUUIDVersion(util::UUIDVersion::RANDOM);
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(DecodeRowBoost)->Name("uuid/DecodeRow/boost");
+BENCHMARK(DecodeRowTraits)->Name("uuid/DecodeRow/traits");
+BENCHMARK(EncodeParamsBoost)->Name("uuid/EncodeParams/boost");
+BENCHMARK(EncodeParamsTraits)->Name("uuid/EncodeParams/traits");
+BENCHMARK(NewBoostPerCall)->Name("uuid/New/boost_per_call");
+BENCHMARK_CAPTURE(NewTaggedUUID, random, util::UUIDVersion::RANDOM)->Name("uuid/New/random");
+BENCHMARK_CAPTURE(NewTaggedUUID, time_ordered, util::UUIDVersion::TIME_ORDERED)->Name("uuid/New/time_ordered");
@@ -0,0 +1,56 @@
+#include "async_runner.h"
+
+#include <stdexcept>
+
+namespace app {
+
+AsyncRunner::AsyncRunner(size_t threads) {
+    if (threads == 0) {
+        throw std::invalid_argument("Async runner needs at least one thread");
+    }
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] {
+            Run();
+        });
+    }
+}
+
+AsyncRunner::~AsyncRunner() {
+    {
+        std::lock_guard lock{mutex_};
+        stopping_ = true;
+    }
+    cond_var_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void AsyncRunner::Enqueue(std::function<void()> task) {
+    {
+        std::lock_guard lock{mutex_};
+        tasks_.push_back(std::move(task));
+    }
+    cond_var_.notify_one();
+}
+
+/* Исключения задач сохраняются в их std::future (packaged_task), поэтому поток их не видит */
+void AsyncRunner::Run() {
+    std::unique_lock lock{mutex_};
+    for (;;) {
+        cond_var_.wait(lock, [this] {
+            return stopping_ || !tasks_.empty();
+        });
+        if (tasks_.empty()) {
+            return;
+        }
+        auto task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+}  // namespace app
@@ -0,0 +1,96 @@
+/*
+ * Выполнение обращений к UseCases в фоновых потоках.
+ * Пока запрос выполняется, вызывающий поток выводит результаты предыдущего запроса
+ * или ждёт ввода пользователя. Каждая операция модуля хранения берёт своё соединение из пула,
+ * поэтому независимые запросы выполняются одновременно, каждый на своём соединении.
+ * Синхронный интерфейс UseCases не меняется: фоновые задачи вызывают его же.
+ * Задачи не должны выполняться внутри группы команд (CommandBatch): фоновый поток
+ * работает вне её транзакции и не видит её изменений.
+ */
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace app {
+
+/* Результат фоновой задачи. При разрушении дожидается её завершения: задача обычно использует
+ * ссылки на объекты вызывающей функции, которые не должны разрушиться раньше неё */
+template <typename T>
+class Pending {
+public:
+    Pending() = default;
+    explicit Pending(std::future<T> future) noexcept
+        : future_{std::move(future)} {
+    }
+
+    Pending(Pending&&) = default;
+    Pending& operator=(Pending&& other) noexcept {
+        Wait();
+        future_ = std::move(other.future_);
+        return *this;
+    }
+
+    ~Pending() {
+        Wait();
+    }
+
+    bool IsValid() const noexcept {
+        return future_.valid();
+    }
+
+    /* Результат задачи или её исключение */
+    T Get() {
+        return future_.get();
+    }
+
+    /* Дожидается завершения задачи, не забирая результат */
+    void Wait() const noexcept {
+        if (future_.valid()) {
+            future_.wait();
+        }
+    }
+
+private:
+
+    std::future<T> future_;
+};
+
+class AsyncRunner {
+public:
+    explicit AsyncRunner(size_t threads);
+
+    AsyncRunner(const AsyncRunner&) = delete;
+    AsyncRunner& operator=(const AsyncRunner&) = delete;
+
+    /* Выполняет принятые задачи и останавливает потоки */
+    ~AsyncRunner();
+
+    template <typename Task>
+    Pending<std::invoke_result_t<Task>> Submit(Task task) {
+        auto packaged = std::make_shared<std::packaged_task<std::invoke_result_t<Task>()>>(std::move(task));
+        Pending<std::invoke_result_t<Task>> result{packaged->get_future()};
+        Enqueue([packaged] {
+            (*packaged)();
+        });
+        return result;
+    }
+
+private:
+    void Enqueue(std::function<void()> task);
+    void Run();
+
+    std::mutex mutex_;
+    std::condition_variable cond_var_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace app
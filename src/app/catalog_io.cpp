@@ -0,0 +1,284 @@
+#include "catalog_io.h"
+
+#include <algorithm>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/json.hpp>
+#include <istream>
+#include <ostream>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace app {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t MAX_NAME_LENGTH = 100;
+constexpr size_t MAX_TAG_LENGTH = 30;
+constexpr char CSV_TAGS_DELIMITER = ';';
+constexpr std::string_view CSV_HEADER = "author,title,publication_year,tags"sv;
+
+/* Нормализация тега так же, как при вводе тегов вручную:
+ * пробелы по краям удаляются, повторяющиеся пробелы внутри схлопываются */
+std::string NormalizeTag(std::string_view raw_tag) {
+    std::string tag;
+    tag.reserve(raw_tag.size());
+    for (const char c : raw_tag) {
+        if (c != ' ' || (!tag.empty() && tag.back() != ' ')) {
+            tag += c;
+        }
+    }
+    boost::algorithm::trim(tag);
+    if (tag.length() > MAX_TAG_LENGTH) {
+        tag.resize(MAX_TAG_LENGTH);
+        boost::algorithm::trim(tag);
+    }
+    return tag;
+}
+
+/* Пустые теги и дубликаты удаляются, оставшиеся упорядочиваются */
+std::vector<std::string> NormalizeTags(const std::vector<std::string_view>& raw_tags) {
+    std::set<std::string> tags;
+    for (const auto raw_tag : raw_tags) {
+        if (std::string tag = NormalizeTag(raw_tag); !tag.empty()) {
+            tags.insert(std::move(tag));
+        }
+    }
+    return {tags.begin(), tags.end()};
+}
+
+/* Разбор строки CSV по RFC 4180: поля в кавычках могут содержать разделители,
+ * кавычка внутри такого поля удваивается */
+std::vector<std::string> SplitCSVLine(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        const char c = line[i];
+        if (quoted) {
+            if (c == '"') {
+                if (i + 1 < line.size() && line[i + 1] == '"') {
+                    fields.back() += '"';
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+/* Поле CSV заключается в кавычки, если содержит разделители или кавычки */
+void WriteCSVField(std::ostream& output, std::string_view field) {
+    if (field.find_first_of(",\"\r\n"sv) == std::string_view::npos) {
+        output << field;
+        return;
+    }
+    output << '"';
+    for (const char c : field) {
+        if (c == '"') {
+            output << '"';
+        }
+        output << c;
+    }
+    output << '"';
+}
+
+/* Кавычки в строке CSV сбалансированы, т.е. запись не продолжается на следующей строке */
+bool IsCompleteCSVRecord(const std::string& text) {
+    return std::count(text.begin(), text.end(), '"') % 2 == 0;
+}
+
+}  // namespace
+
+std::optional<CatalogFormat> CatalogFormatFromFileName(const std::string& file_name) {
+    auto ends_with = [&file_name](std::string_view suffix) {
+        return file_name.size() >= suffix.size()
+               && std::string_view{file_name}.substr(file_name.size() - suffix.size()) == suffix;
+    };
+    if (ends_with(".csv"sv)) {
+        return CatalogFormat::CSV;
+    }
+    if (ends_with(".ndjson"sv) || ends_with(".jsonl"sv)) {
+        return CatalogFormat::NDJSON;
+    }
+    return std::nullopt;
+}
+
+CatalogReader::CatalogReader(std::istream& input, CatalogFormat format)
+    : input_{input}
+    , format_{format} {
+    if (format_ == CatalogFormat::CSV) {
+        std::string header;
+        if (ReadLine(header)) {
+            boost::algorithm::trim(header);
+            if (header != CSV_HEADER) {
+                ThrowFormatError("expected header '"s + std::string{CSV_HEADER} + "'"s);
+            }
+        }
+    }
+}
+
+std::optional<domain::CatalogRecord> CatalogReader::Next() {
+    std::optional<domain::CatalogRecord> record =
+        (format_ == CatalogFormat::CSV) ? NextCSV() : NextNDJSON();
+    if (!record) {
+        return std::nullopt;
+    }
+
+    boost::algorithm::trim(record->author_name);
+    boost::algorithm::trim(record->title);
+    if (record->author_name.empty() || record->author_name.size() > MAX_NAME_LENGTH) {
+        ThrowFormatError("invalid author name"s);
+    }
+    if (record->title.empty() || record->title.size() > MAX_NAME_LENGTH) {
+        ThrowFormatError("invalid title"s);
+    }
+    if (record->publication_year == 0) {
+        ThrowFormatError("invalid publication year"s);
+    }
+    return record;
+}
+
+std::optional<domain::CatalogRecord> CatalogReader::NextCSV() {
+    std::string text;
+    do {
+        if (!ReadLine(text)) {
+            return std::nullopt;
+        }
+    } while (text.empty());
+
+    std::string continuation;
+    while (!IsCompleteCSVRecord(text)) {
+        if (!ReadLine(continuation)) {
+            ThrowFormatError("unterminated quoted field"s);
+        }
+        text += '\n';
+        text += continuation;
+    }
+
+    auto fields = SplitCSVLine(text);
+    if (fields.size() != 4) {
+        ThrowFormatError("expected 4 fields"s);
+    }
+
+    domain::CatalogRecord record;
+    record.author_name = std::move(fields[0]);
+    record.title = std::move(fields[1]);
+    try {
+        record.publication_year = std::stoull(fields[2]);
+    } catch (const std::exception&) {
+        ThrowFormatError("invalid publication year"s);
+    }
+    std::vector<std::string_view> raw_tags;
+    std::string_view tags_field = fields[3];
+    while (!tags_field.empty()) {
+        const size_t pos = tags_field.find(CSV_TAGS_DELIMITER);
+        raw_tags.push_back(tags_field.substr(0, pos));
+        tags_field.remove_prefix(pos == std::string_view::npos ? tags_field.size() : pos + 1);
+    }
+    record.tags = NormalizeTags(raw_tags);
+    return record;
+}
+
+std::optional<domain::CatalogRecord> CatalogReader::NextNDJSON() {
+    std::string line;
+    do {
+        if (!ReadLine(line)) {
+            return std::nullopt;
+        }
+        boost::algorithm::trim(line);
+    } while (line.empty());
+
+    domain::CatalogRecord record;
+    try {
+        const auto value = boost::json::parse(line);
+        const auto& object = value.as_object();
+        const auto& author = object.at("author"sv).as_string();
+        const auto& title = object.at("title"sv).as_string();
+        record.author_name.assign(author.data(), author.size());
+        record.title.assign(title.data(), title.size());
+        record.publication_year = object.at("publication_year"sv).to_number<uint64_t>();
+        if (const auto* tags = object.if_contains("tags"sv)) {
+            std::vector<std::string_view> raw_tags;
+            for (const auto& tag : tags->as_array()) {
+                const auto& tag_str = tag.as_string();
+                raw_tags.emplace_back(tag_str.data(), tag_str.size());
+            }
+            record.tags = NormalizeTags(raw_tags);
+        }
+    } catch (const std::exception& e) {
+        ThrowFormatError(e.what());
+    }
+    return record;
+}
+
+bool CatalogReader::ReadLine(std::string& line) {
+    if (!std::getline(input_, line)) {
+        return false;
+    }
+    ++line_number_;
+    return true;
+}
+
+void CatalogReader::ThrowFormatError(const std::string& reason) const {
+    throw std::runtime_error("Catalog line "s + std::to_string(line_number_) + ": "s + reason);
+}
+
+CatalogWriter::CatalogWriter(std::ostream& output, CatalogFormat format)
+    : output_{output}
+    , format_{format} {
+    if (format_ == CatalogFormat::CSV) {
+        output_ << CSV_HEADER << '\n';
+    }
+}
+
+void CatalogWriter::Write(const domain::CatalogRecord& record) {
+    if (format_ == CatalogFormat::CSV) {
+        WriteCSV(record);
+    } else {
+        WriteNDJSON(record);
+    }
+}
+
+void CatalogWriter::WriteCSV(const domain::CatalogRecord& record) {
+    WriteCSVField(output_, record.author_name);
+    output_ << ',';
+    WriteCSVField(output_, record.title);
+    output_ << ',' << record.publication_year << ',';
+    std::string tags;
+    for (const auto& tag : record.tags) {
+        if (!tags.empty()) {
+            tags += CSV_TAGS_DELIMITER;
+        }
+        tags += tag;
+    }
+    WriteCSVField(output_, tags);
+    output_ << '\n';
+}
+
+void CatalogWriter::WriteNDJSON(const domain::CatalogRecord& record) {
+    boost::json::array tags;
+    tags.reserve(record.tags.size());
+    for (const auto& tag : record.tags) {
+        tags.emplace_back(tag);
+    }
+    boost::json::object object;
+    object["author"sv] = record.author_name;
+    object["title"sv] = record.title;
+    object["publication_year"sv] = record.publication_year;
+    object["tags"sv] = std::move(tags);
+    output_ << boost::json::serialize(object) << '\n';
+}
+
+}  // namespace app
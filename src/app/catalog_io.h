@@ -0,0 +1,60 @@
+/*
+ * Чтение и запись каталога (авторы, книги, теги) в файлах форматов CSV и NDJSON
+ * CSV: первая строка - заголовок "author,title,publication_year,tags",
+ *      теги в последнем поле разделяются символом ';'. Поля могут заключаться в кавычки.
+ *      Символ ';' внутри тега при записи не экранируется.
+ * NDJSON: по одному JSON-объекту в строке:
+ *      {"author": "Jack London", "title": "White Fang", "publication_year": 1906, "tags": ["dog"]}
+ */
+#pragma once
+#include <iosfwd>
+#include <optional>
+#include <string>
+
+#include "../domain/author.h"
+
+namespace app {
+
+enum class CatalogFormat {
+    CSV,
+    NDJSON
+};
+
+/* Формат определяется по расширению файла: .csv, .ndjson или .jsonl */
+std::optional<CatalogFormat> CatalogFormatFromFileName(const std::string& file_name);
+
+class CatalogReader {
+public:
+    CatalogReader(std::istream& input, CatalogFormat format);
+
+    /* Очередная запись каталога либо std::nullopt в конце файла.
+     * При ошибке формата выбрасывается исключение с номером строки */
+    std::optional<domain::CatalogRecord> Next();
+
+private:
+    std::optional<domain::CatalogRecord> NextCSV();
+    std::optional<domain::CatalogRecord> NextNDJSON();
+    bool ReadLine(std::string& line);
+    [[noreturn]] void ThrowFormatError(const std::string& reason) const;
+
+    std::istream& input_;
+    CatalogFormat format_;
+    size_t line_number_ = 0;
+};
+
+/* Записи выводятся в поток по одной, без накопления в памяти */
+class CatalogWriter {
+public:
+    CatalogWriter(std::ostream& output, CatalogFormat format);
+
+    void Write(const domain::CatalogRecord& record);
+
+private:
+    void WriteCSV(const domain::CatalogRecord& record);
+    void WriteNDJSON(const domain::CatalogRecord& record);
+
+    std::ostream& output_;
+    CatalogFormat format_;
+};
+
+}  // namespace app
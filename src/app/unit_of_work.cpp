@@ -0,0 +1,341 @@
+#include "unit_of_work.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace app {
+
+using namespace std::literals;
+using namespace domain;
+
+UnitOfWork::UnitOfWork(AuthorRepository& authors, BookRepository& books, CommandBatch* batch)
+    : authors_{authors}
+    , books_{books}
+    , batch_{batch} {
+}
+
+void UnitOfWork::Begin() {
+    std::lock_guard lock{mutex_};
+    if (!units_.try_emplace(std::this_thread::get_id()).second) {
+        throw std::logic_error("Unit of work has been started already"s);
+    }
+}
+
+void UnitOfWork::Commit() {
+    Unit* unit = GetUnit();
+    if (!unit) {
+        throw std::logic_error("Unit of work has not been started"s);
+    }
+    try {
+        if (HasChanges(*unit)) {
+            Flush(*unit);
+        }
+    } catch (...) {
+        Clear();
+        throw;
+    }
+    Clear();
+}
+
+void UnitOfWork::Rollback() noexcept {
+    Clear();
+}
+
+/* Ссылка на элемент unordered_map не меняется при добавлении и удалении других элементов,
+ * поэтому единица работы потока используется без блокировки */
+UnitOfWork::Unit* UnitOfWork::GetUnit() noexcept {
+    std::lock_guard lock{mutex_};
+    const auto it = units_.find(std::this_thread::get_id());
+    return it == units_.end() ? nullptr : &it->second;
+}
+
+/* Новый объект остаётся новым до записи, а повторное сохранение объекта из хранилища - изменением */
+template <typename Id, typename Entity>
+void UnitOfWork::Register(Unit& unit, IdentityMap<Id, Entity>& map, const Id& id, State state,
+                          std::optional<Entity> entity) {
+    auto [it, inserted] = map.try_emplace(id, Entry<Id, Entity>{id, state, std::nullopt});
+    auto& entry = it->second;
+    if (!inserted) {
+        entry.state = entry.state == State::NEW ? State::NEW : State::DIRTY;
+    }
+    entry.entity = std::move(entity);
+    entry.sequence = ++unit.sequence;
+}
+
+/* Удаление ещё не записанного объекта просто забывает его */
+template <typename Id, typename Entity>
+void UnitOfWork::MarkDeleted(Unit& unit, IdentityMap<Id, Entity>& map, const Id& id) {
+    auto [it, inserted] = map.try_emplace(id, Entry<Id, Entity>{id, State::DELETED, std::nullopt});
+    if (!inserted && it->second.state == State::NEW) {
+        map.erase(it);
+        return;
+    }
+    it->second.state = State::DELETED;
+    it->second.entity.reset();
+    it->second.sequence = ++unit.sequence;
+}
+
+template <typename Id, typename Entity>
+std::vector<const UnitOfWork::Entry<Id, Entity>*> UnitOfWork::Select(const IdentityMap<Id, Entity>& map,
+                                                                      State state) {
+    std::vector<const Entry<Id, Entity>*> entries;
+    for (const auto& [id, entry] : map) {
+        if (entry.state == state) {
+            entries.push_back(&entry);
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->sequence < rhs->sequence;
+    });
+    return entries;
+}
+
+/* Без изменений (только чтение) транзакция записи не открывается */
+bool UnitOfWork::HasChanges(const Unit& unit) noexcept {
+    const auto changed = [](const auto& map) {
+        return std::any_of(map.begin(), map.end(), [](const auto& item) {
+            return item.second.state != State::CLEAN;
+        });
+    };
+    return changed(unit.authors) || changed(unit.books);
+}
+
+/* Группа команд хранилища своя у каждого потока: если поток её не открывал (пакетный режим),
+ * единица работы открывает её для записи своих изменений */
+void UnitOfWork::Flush(const Unit& unit) {
+    if (!batch_ || batch_->IsOpen()) {
+        return WriteChanges(unit);
+    }
+    batch_->Begin();
+    try {
+        WriteChanges(unit);
+        batch_->Commit();
+    } catch (...) {
+        batch_->Rollback();
+        throw;
+    }
+}
+
+/* Книги ссылаются на авторов: авторы добавляются до книг, а удаляются после них */
+void UnitOfWork::WriteChanges(const Unit& unit) {
+    for (const auto* entry : Select(unit.authors, State::NEW)) {
+        authors_.Save(*entry->entity);
+    }
+    for (const auto* entry : Select(unit.authors, State::DIRTY)) {
+        authors_.Edit(*entry->entity);
+    }
+    for (const auto* entry : Select(unit.books, State::NEW)) {
+        books_.Save(*entry->entity);
+    }
+    for (const auto* entry : Select(unit.books, State::DIRTY)) {
+        books_.Edit(*entry->entity);
+    }
+    for (const auto* entry : Select(unit.books, State::DELETED)) {
+        books_.Delete(entry->id);
+    }
+    for (const auto* entry : Select(unit.authors, State::DELETED)) {
+        authors_.Delete(entry->id);
+    }
+}
+
+void UnitOfWork::Clear() noexcept {
+    std::lock_guard lock{mutex_};
+    units_.erase(std::this_thread::get_id());
+}
+
+/* ---------------------------- Authors ---------------------------- */
+
+void UnitOfWork::TrackedAuthors::Save(const Author& author) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.authors_.Save(author);
+    }
+    Register(*unit, unit->authors, author.GetId(), State::NEW, std::optional{author});
+}
+
+std::string UnitOfWork::TrackedAuthors::GetName(const AuthorId& id) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.authors_.GetName(id);
+    }
+    if (const auto it = unit->authors.find(id); it != unit->authors.end()) {
+        if (!it->second.entity) {
+            throw std::runtime_error("No such author"s);
+        }
+        return it->second.entity->GetName();
+    }
+    std::string name = work_.authors_.GetName(id);
+    unit->authors.try_emplace(id, Entry<AuthorId, Author>{id, State::CLEAN, Author{id, name}});
+    return name;
+}
+
+std::string UnitOfWork::TrackedAuthors::GetID(const std::string& name) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.authors_.GetID(name);
+    }
+    for (const auto& [id, entry] : unit->authors) {
+        if (entry.entity && entry.entity->GetName() == name) {
+            return id.ToString();
+        }
+    }
+    std::string id_str = work_.authors_.GetID(name);
+    auto id = AuthorId::FromString(id_str);
+    // Автор с этим именем уже переименован или удалён в этой единице работы
+    if (unit->authors.contains(id)) {
+        throw std::runtime_error("No such author"s);
+    }
+    unit->authors.try_emplace(id, Entry<AuthorId, Author>{id, State::CLEAN, Author{id, name}});
+    return id_str;
+}
+
+std::vector<Author> UnitOfWork::TrackedAuthors::Show() {
+    return work_.authors_.Show();
+}
+
+std::vector<Author> UnitOfWork::TrackedAuthors::ShowPage(const std::optional<std::string>& after_name, size_t limit) {
+    return work_.authors_.ShowPage(after_name, limit);
+}
+
+/* Вместе с новым автором забываются и его новые книги: записать их уже нельзя */
+void UnitOfWork::TrackedAuthors::Delete(const AuthorId& id) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.authors_.Delete(id);
+    }
+    if (const auto it = unit->authors.find(id); it != unit->authors.end() && it->second.state == State::NEW) {
+        std::erase_if(unit->books, [&id](const auto& item) {
+            return item.second.state == State::NEW && item.second.entity->GetAuthorId() == id;
+        });
+    }
+    MarkDeleted(*unit, unit->authors, id);
+}
+
+void UnitOfWork::TrackedAuthors::Delete(const std::string& name) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.authors_.Delete(name);
+    }
+    Delete(AuthorId::FromString(GetID(name)));
+}
+
+void UnitOfWork::TrackedAuthors::Edit(const Author& new_author) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.authors_.Edit(new_author);
+    }
+    Register(*unit, unit->authors, new_author.GetId(), State::DIRTY, std::optional{new_author});
+}
+
+void UnitOfWork::TrackedAuthors::Edit(const std::string& old_name, const std::string& new_name) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.authors_.Edit(old_name, new_name);
+    }
+    Edit(Author{AuthorId::FromString(GetID(old_name)), new_name});
+}
+
+/* ---------------------------- Books ---------------------------- */
+
+void UnitOfWork::TrackedBooks::Save(const Book& book) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.books_.Save(book);
+    }
+    Register(*unit, unit->books, book.GetId(), State::NEW, std::optional{book});
+}
+
+std::vector<Book> UnitOfWork::TrackedBooks::ShowAll() {
+    return work_.books_.ShowAll();
+}
+
+std::vector<BookWithAuthor> UnitOfWork::TrackedBooks::ShowAllWithAuthors(bool with_tags) {
+    return work_.books_.ShowAllWithAuthors(with_tags);
+}
+
+std::vector<BookWithAuthor> UnitOfWork::TrackedBooks::ShowPageWithAuthors(const std::optional<BookPageCursor>& after,
+                                                                          size_t limit) {
+    return work_.books_.ShowPageWithAuthors(after, limit);
+}
+
+std::vector<Book> UnitOfWork::TrackedBooks::ShowPageByAuthor(const AuthorId& author_id,
+                                                             const std::optional<AuthorBookPageCursor>& after,
+                                                             size_t limit) {
+    return work_.books_.ShowPageByAuthor(author_id, after, limit);
+}
+
+std::vector<BookWithAuthor> UnitOfWork::TrackedBooks::ShowPageByTags(const std::vector<std::string>& tags,
+                                                                     TagMatch match,
+                                                                     const std::optional<BookPageCursor>& after,
+                                                                     size_t limit) {
+    return work_.books_.ShowPageByTags(tags, match, after, limit);
+}
+
+std::vector<Book> UnitOfWork::TrackedBooks::ShowByAuthor(const AuthorId& author_id) {
+    return work_.books_.ShowByAuthor(author_id);
+}
+
+Book UnitOfWork::TrackedBooks::ShowInfoByID(const BookId& book_id) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.books_.ShowInfoByID(book_id);
+    }
+    if (const auto it = unit->books.find(book_id); it != unit->books.end()) {
+        if (!it->second.entity) {
+            throw std::runtime_error("No such book"s);
+        }
+        return *it->second.entity;
+    }
+    Book book = work_.books_.ShowInfoByID(book_id);
+    unit->books.try_emplace(book_id, Entry<BookId, Book>{book_id, State::CLEAN, book});
+    return book;
+}
+
+std::vector<Book> UnitOfWork::TrackedBooks::ShowInfoByTitle(const std::string& book_title) {
+    return work_.books_.ShowInfoByTitle(book_title);
+}
+
+BookWithAuthor UnitOfWork::TrackedBooks::ShowInfoWithAuthorByID(const BookId& book_id) {
+    if (const auto* unit = work_.GetUnit(); unit && unit->books.contains(book_id)) {
+        Book book = ShowInfoByID(book_id);
+        std::string author_name = work_.tracked_authors_.GetName(book.GetAuthorId());
+        return {std::move(book), std::move(author_name)};
+    }
+    return work_.books_.ShowInfoWithAuthorByID(book_id);
+}
+
+std::vector<BookWithAuthor> UnitOfWork::TrackedBooks::ShowInfoWithAuthorByTitle(const std::string& book_title) {
+    return work_.books_.ShowInfoWithAuthorByTitle(book_title);
+}
+
+std::vector<BookSearchResult> UnitOfWork::TrackedBooks::Search(const std::string& query,
+                                                               const std::optional<BookSearchCursor>& after,
+                                                               size_t limit) {
+    return work_.books_.Search(query, after, limit);
+}
+
+void UnitOfWork::TrackedBooks::Delete(const BookId& id) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.books_.Delete(id);
+    }
+    MarkDeleted(*unit, unit->books, id);
+}
+
+void UnitOfWork::TrackedBooks::Edit(const Book& new_book) {
+    auto* unit = work_.GetUnit();
+    if (!unit) {
+        return work_.books_.Edit(new_book);
+    }
+    Register(*unit, unit->books, new_book.GetId(), State::DIRTY, std::optional{new_book});
+}
+
+void UnitOfWork::TrackedBooks::Import(const std::vector<CatalogRecord>& records) {
+    work_.books_.Import(records);
+}
+
+void UnitOfWork::TrackedBooks::Export(const std::function<void(const CatalogRecord&)>& visitor) {
+    work_.books_.Export(visitor);
+}
+
+}  // namespace app
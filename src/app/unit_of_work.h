@@ -0,0 +1,158 @@
+/*
+ * Единица работы (Unit of Work) команды.
+ * Между Begin и Commit операции записи авторов и книг, выполняемые открывшим её потоком,
+ * не отправляются в хранилище, а запоминаются в карте идентичности (identity map):
+ * новые, изменённые и удалённые объекты. Commit записывает их одной транзакцией хранилища
+ * (CommandBatch) в порядке: новые авторы, изменённые авторы, новые книги, изменённые книги,
+ * удалённые книги, удалённые авторы. Ошибка записи отменяет всю транзакцию.
+ * Чтение по идентификатору (и автора по имени) учитывает незаписанные изменения,
+ * прочитанные объекты запоминаются до конца единицы работы. Списки читаются из хранилища
+ * и незаписанных изменений не содержат.
+ * Единица работы у каждого потока своя, операции потоков без неё, импорт и экспорт каталога
+ * выполняются в хранилище сразу. Commit записывает изменения в группе команд своего потока:
+ * открытой им ранее (пакетный режим) или открываемой для этой записи.
+ */
+#pragma once
+#include <boost/uuid/uuid_hash.hpp>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../domain/author.h"
+
+namespace app {
+
+class UnitOfWork {
+public:
+    /* batch может отсутствовать: тогда каждая запись выполняется в своей транзакции хранилища */
+    UnitOfWork(domain::AuthorRepository& authors, domain::BookRepository& books, domain::CommandBatch* batch);
+
+    UnitOfWork(const UnitOfWork&) = delete;
+    UnitOfWork& operator=(const UnitOfWork&) = delete;
+
+    /* Репозитории, через которые работают варианты использования */
+    domain::AuthorRepository& GetAuthors() noexcept {
+        return tracked_authors_;
+    }
+
+    domain::BookRepository& GetBooks() noexcept {
+        return tracked_books_;
+    }
+
+    void Begin();
+    void Commit();
+    void Rollback() noexcept;
+
+private:
+    enum class State {
+        CLEAN,  // прочитан из хранилища
+        NEW,
+        DIRTY,
+        DELETED
+    };
+
+    template <typename Id, typename Entity>
+    struct Entry {
+        Id id;
+        State state;
+        std::optional<Entity> entity;  // нет только у удалённых объектов
+        uint64_t sequence = 0;         // порядок изменений внутри одного вида записи
+    };
+
+    template <typename Id, typename Entity>
+    using IdentityMap = std::unordered_map<Id, Entry<Id, Entity>, util::TaggedHasher<Id>>;
+
+    class TrackedAuthors : public domain::AuthorRepository {
+    public:
+        explicit TrackedAuthors(UnitOfWork& work)
+            : work_{work} {
+        }
+
+        void Save(const domain::Author& author) override;
+        std::string GetName(const domain::AuthorId& id) override;
+        std::string GetID(const std::string& name) override;
+        std::vector<domain::Author> Show() override;
+        std::vector<domain::Author> ShowPage(const std::optional<std::string>& after_name, size_t limit) override;
+        void Delete(const domain::AuthorId& id) override;
+        void Delete(const std::string& name) override;
+        void Edit(const domain::Author& new_author) override;
+        void Edit(const std::string& old_name, const std::string& new_name) override;
+
+    private:
+        UnitOfWork& work_;
+    };
+
+    class TrackedBooks : public domain::BookRepository {
+    public:
+        explicit TrackedBooks(UnitOfWork& work)
+            : work_{work} {
+        }
+
+        void Save(const domain::Book& book) override;
+        std::vector<domain::Book> ShowAll() override;
+        std::vector<domain::BookWithAuthor> ShowAllWithAuthors(bool with_tags) override;
+        std::vector<domain::BookWithAuthor> ShowPageWithAuthors(const std::optional<domain::BookPageCursor>& after,
+                                                                size_t limit) override;
+        std::vector<domain::Book> ShowPageByAuthor(const domain::AuthorId& author_id,
+                                                   const std::optional<domain::AuthorBookPageCursor>& after,
+                                                   size_t limit) override;
+        std::vector<domain::BookWithAuthor> ShowPageByTags(const std::vector<std::string>& tags,
+                                                           domain::TagMatch match,
+                                                           const std::optional<domain::BookPageCursor>& after,
+                                                           size_t limit) override;
+        std::vector<domain::Book> ShowByAuthor(const domain::AuthorId& author_id) override;
+        domain::Book ShowInfoByID(const domain::BookId& book_id) override;
+        std::vector<domain::Book> ShowInfoByTitle(const std::string& book_title) override;
+        domain::BookWithAuthor ShowInfoWithAuthorByID(const domain::BookId& book_id) override;
+        std::vector<domain::BookWithAuthor> ShowInfoWithAuthorByTitle(const std::string& book_title) override;
+        std::vector<domain::BookSearchResult> Search(const std::string& query,
+                                                     const std::optional<domain::BookSearchCursor>& after,
+                                                     size_t limit) override;
+        void Delete(const domain::BookId& id) override;
+        void Edit(const domain::Book& new_book) override;
+        void Import(const std::vector<domain::CatalogRecord>& records) override;
+        void Export(const std::function<void(const domain::CatalogRecord&)>& visitor) override;
+
+    private:
+        UnitOfWork& work_;
+    };
+
+    /* Карта идентичности единицы работы одного потока */
+    struct Unit {
+        IdentityMap<domain::AuthorId, domain::Author> authors;
+        IdentityMap<domain::BookId, domain::Book> books;
+        uint64_t sequence = 0;
+    };
+
+    /* Единица работы вызывающего потока или nullptr: изменения запоминаются, только если он её открыл */
+    Unit* GetUnit() noexcept;
+
+    template <typename Id, typename Entity>
+    static void Register(Unit& unit, IdentityMap<Id, Entity>& map, const Id& id, State state,
+                         std::optional<Entity> entity);
+    template <typename Id, typename Entity>
+    static void MarkDeleted(Unit& unit, IdentityMap<Id, Entity>& map, const Id& id);
+    /* Изменения одного вида в порядке их выполнения */
+    template <typename Id, typename Entity>
+    static std::vector<const Entry<Id, Entity>*> Select(const IdentityMap<Id, Entity>& map, State state);
+
+    static bool HasChanges(const Unit& unit) noexcept;
+    void Flush(const Unit& unit);
+    void WriteChanges(const Unit& unit);
+    /* Закрывает единицу работы вызывающего потока */
+    void Clear() noexcept;
+
+    domain::AuthorRepository& authors_;
+    domain::BookRepository& books_;
+    domain::CommandBatch* batch_;
+    TrackedAuthors tracked_authors_{*this};
+    TrackedBooks tracked_books_{*this};
+
+    std::mutex mutex_;
+    std::unordered_map<std::thread::id, Unit> units_;
+};
+
+}  // namespace app
@@ -3,10 +3,14 @@
  */
 #pragma once
 
+#include <iosfwd>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "../domain/author.h"
+#include "catalog_io.h"
 
 namespace app {
 
@@ -39,8 +43,125 @@ public:
     virtual domain::Book ShowBookInfoByID(const std::string& book_id) = 0;
     virtual std::vector<domain::Book> ShowBookInfoByTitle(const std::string& book_title) = 0;
 
+    /* Книги вместе с именами авторов, полученные одним запросом */
+    virtual std::vector<domain::BookWithAuthor> ShowAllBooksWithAuthors(bool with_tags) = 0;
+    virtual domain::BookWithAuthor ShowBookFullInfoByID(const std::string& book_id) = 0;
+    virtual std::vector<domain::BookWithAuthor> ShowBookFullInfoByTitle(const std::string& book_title) = 0;
+
+    /* Постраничный вывод списков. Следующая страница запрашивается с курсором,
+     * построенным по последнему элементу предыдущей страницы */
+    virtual std::vector<domain::Author> ShowAuthorsPage(const std::optional<std::string>& after_name,
+                                                        size_t limit) = 0;
+    virtual std::vector<domain::BookWithAuthor> ShowBooksPage(const std::optional<domain::BookPageCursor>& after,
+                                                              size_t limit) = 0;
+    virtual std::vector<domain::Book> ShowAuthorBooksPage(const std::string& author_id,
+                                                          const std::optional<domain::AuthorBookPageCursor>& after,
+                                                          size_t limit) = 0;
+
+    /* Книги с тегом и книги с любым или со всеми тегами из списка, постранично */
+    virtual std::vector<domain::BookWithAuthor> ShowBooksByTag(const std::string& tag,
+                                                               const std::optional<domain::BookPageCursor>& after,
+                                                               size_t limit) = 0;
+    virtual std::vector<domain::BookWithAuthor> ShowBooksByTags(const std::vector<std::string>& tags,
+                                                                domain::TagMatch match,
+                                                                const std::optional<domain::BookPageCursor>& after,
+                                                                size_t limit) = 0;
+
+    /* Поиск книг по фрагментам названия, имени автора и тегов, постранично по убыванию релевантности */
+    virtual std::vector<domain::BookSearchResult> SearchBooks(const std::string& query,
+                                                              const std::optional<domain::BookSearchCursor>& after,
+                                                              size_t limit) = 0;
+
+    /* Массовый импорт каталога, фиксируется пакетами по batch_size книг.
+     * Возвращает число импортированных книг */
+    virtual size_t ImportCatalog(std::istream& input, CatalogFormat format, size_t batch_size) = 0;
+    /* Потоковый экспорт каталога. Возвращает число экспортированных книг */
+    virtual size_t ExportCatalog(std::ostream& output, CatalogFormat format) = 0;
+
+    /* Единица работы команды: изменения авторов и книг после BeginWork
+     * записываются в хранилище одной транзакцией в CommitWork.
+     * Чтение внутри единицы работы выполняется в общем снимке, как между BeginRead и EndRead */
+    virtual void BeginWork() = 0;
+    virtual void CommitWork() = 0;
+    virtual void RollbackWork() noexcept = 0;
+
+    /* Общий снимок данных для всех чтений команды */
+    virtual void BeginRead() = 0;
+    virtual void EndRead() noexcept = 0;
+    /* Закрывает транзакцию снимка до следующего чтения, например, пока команда ждёт ввода пользователя:
+     * чтения до и после вызова видят разные снимки */
+    virtual void ReleaseRead() noexcept = 0;
+    /* Чтения вызывающего потока выполняются в снимке потока owner до DetachRead */
+    virtual void AttachRead(std::thread::id owner) noexcept = 0;
+    virtual void DetachRead() noexcept = 0;
+
 protected:
     ~UseCases() = default;
 };
 
+/* Открывает единицу работы и отменяет её, если до выхода из области видимости не вызван Commit */
+class WorkScope {
+public:
+    explicit WorkScope(UseCases& use_cases)
+        : use_cases_{use_cases} {
+        use_cases_.BeginWork();
+    }
+
+    WorkScope(const WorkScope&) = delete;
+    WorkScope& operator=(const WorkScope&) = delete;
+
+    ~WorkScope() {
+        if (!committed_) {
+            use_cases_.RollbackWork();
+        }
+    }
+
+    void Commit() {
+        committed_ = true;
+        use_cases_.CommitWork();
+    }
+
+private:
+    UseCases& use_cases_;
+    bool committed_ = false;
+};
+
+/* Открывает общий снимок для чтения на время области видимости */
+class ReadScope {
+public:
+    explicit ReadScope(UseCases& use_cases)
+        : use_cases_{use_cases} {
+        use_cases_.BeginRead();
+    }
+
+    ReadScope(const ReadScope&) = delete;
+    ReadScope& operator=(const ReadScope&) = delete;
+
+    ~ReadScope() {
+        use_cases_.EndRead();
+    }
+
+private:
+    UseCases& use_cases_;
+};
+
+/* Чтения вызывающего потока выполняются в снимке потока owner на время области видимости */
+class AttachedReadScope {
+public:
+    AttachedReadScope(UseCases& use_cases, std::thread::id owner)
+        : use_cases_{use_cases} {
+        use_cases_.AttachRead(owner);
+    }
+
+    AttachedReadScope(const AttachedReadScope&) = delete;
+    AttachedReadScope& operator=(const AttachedReadScope&) = delete;
+
+    ~AttachedReadScope() {
+        use_cases_.DetachRead();
+    }
+
+private:
+    UseCases& use_cases_;
+};
+
 }  // namespace app
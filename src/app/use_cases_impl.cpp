@@ -1,5 +1,7 @@
 #include "use_cases_impl.h"
 
+#include <stdexcept>
+
 #include "../domain/author.h"
 
 namespace app {
@@ -81,4 +83,139 @@ std::vector<domain::Book> UseCasesImpl::ShowBookInfoByTitle(const std::string& b
     return books_.ShowInfoByTitle(book_title);
 }
 
+std::vector<domain::BookWithAuthor> UseCasesImpl::ShowAllBooksWithAuthors(bool with_tags) {
+    return books_.ShowAllWithAuthors(with_tags);
+}
+domain::BookWithAuthor UseCasesImpl::ShowBookFullInfoByID(const std::string& book_id) {
+    return books_.ShowInfoWithAuthorByID(BookId::FromString(book_id));
+}
+std::vector<domain::BookWithAuthor> UseCasesImpl::ShowBookFullInfoByTitle(const std::string& book_title) {
+    return books_.ShowInfoWithAuthorByTitle(book_title);
+}
+
+std::vector<domain::Author> UseCasesImpl::ShowAuthorsPage(const std::optional<std::string>& after_name,
+                                                          size_t limit) {
+    return authors_.ShowPage(after_name, limit);
+}
+std::vector<domain::BookWithAuthor> UseCasesImpl::ShowBooksPage(const std::optional<domain::BookPageCursor>& after,
+                                                                size_t limit) {
+    return books_.ShowPageWithAuthors(after, limit);
+}
+std::vector<domain::Book> UseCasesImpl::ShowAuthorBooksPage(const std::string& author_id,
+                                                            const std::optional<domain::AuthorBookPageCursor>& after,
+                                                            size_t limit) {
+    return books_.ShowPageByAuthor(AuthorId::FromString(author_id), after, limit);
+}
+
+std::vector<domain::BookWithAuthor> UseCasesImpl::ShowBooksByTag(const std::string& tag,
+                                                                 const std::optional<domain::BookPageCursor>& after,
+                                                                 size_t limit) {
+    return ShowBooksByTags({tag}, domain::TagMatch::ANY, after, limit);
+}
+
+std::vector<domain::BookWithAuthor> UseCasesImpl::ShowBooksByTags(const std::vector<std::string>& tags,
+                                                                  domain::TagMatch match,
+                                                                  const std::optional<domain::BookPageCursor>& after,
+                                                                  size_t limit) {
+    if (tags.empty()) {
+        throw std::invalid_argument("No tags");
+    }
+    return books_.ShowPageByTags(tags, match, after, limit);
+}
+
+std::vector<domain::BookSearchResult> UseCasesImpl::SearchBooks(const std::string& query,
+                                                                const std::optional<domain::BookSearchCursor>& after,
+                                                                size_t limit) {
+    if (query.empty()) {
+        throw std::invalid_argument("Search query is empty");
+    }
+    return books_.Search(query, after, limit);
+}
+
+size_t UseCasesImpl::ImportCatalog(std::istream& input, CatalogFormat format, size_t batch_size) {
+    if (batch_size == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    CatalogReader reader{input, format};
+    std::vector<CatalogRecord> batch;
+    batch.reserve(batch_size);
+    size_t imported = 0;
+    auto flush = [&] {
+        books_.Import(batch);
+        imported += batch.size();
+        batch.clear();
+    };
+    while (auto record = reader.Next()) {
+        batch.emplace_back(std::move(*record));
+        if (batch.size() == batch_size) {
+            flush();
+        }
+    }
+    if (!batch.empty()) {
+        flush();
+    }
+    return imported;
+}
+
+size_t UseCasesImpl::ExportCatalog(std::ostream& output, CatalogFormat format) {
+    CatalogWriter writer{output, format};
+    size_t exported = 0;
+    books_.Export([&writer, &exported](const CatalogRecord& record) {
+        writer.Write(record);
+        ++exported;
+    });
+    return exported;
+}
+
+void UseCasesImpl::BeginWork() {
+    unit_of_work_.Begin();
+    try {
+        BeginRead();
+    } catch (...) {
+        unit_of_work_.Rollback();
+        throw;
+    }
+}
+
+/* Снимок закрывается до записи: его соединение возвращается в пул и может понадобиться записи */
+void UseCasesImpl::CommitWork() {
+    EndRead();
+    unit_of_work_.Commit();
+}
+
+void UseCasesImpl::RollbackWork() noexcept {
+    EndRead();
+    unit_of_work_.Rollback();
+}
+
+void UseCasesImpl::BeginRead() {
+    if (snapshot_) {
+        snapshot_->Begin();
+    }
+}
+
+void UseCasesImpl::EndRead() noexcept {
+    if (snapshot_) {
+        snapshot_->End();
+    }
+}
+
+void UseCasesImpl::ReleaseRead() noexcept {
+    if (snapshot_) {
+        snapshot_->Release();
+    }
+}
+
+void UseCasesImpl::AttachRead(std::thread::id owner) noexcept {
+    if (snapshot_) {
+        snapshot_->Attach(owner);
+    }
+}
+
+void UseCasesImpl::DetachRead() noexcept {
+    if (snapshot_) {
+        snapshot_->Detach();
+    }
+}
+
 }  // namespace app
@@ -1,19 +1,24 @@
 /*
  * Реализация интерфейса взаимодействия с модулем представления данных
  * Примечание:
- * Интерфейсы для взаимодействия с модулем хранения (authors_, books_) реализованы в модуле хранения
+ * Интерфейсы для взаимодействия с модулем хранения (authors_, books_) реализованы в модуле хранения.
+ * Варианты использования обращаются к ним через единицу работы (unit_of_work_)
  */
 #pragma once
 #include "../domain/author_fwd.h"
+#include "unit_of_work.h"
 #include "use_cases.h"
 
 namespace app {
 
 class UseCasesImpl : public UseCases {
 public:
-    explicit UseCasesImpl(domain::AuthorRepository& authors, domain::BookRepository& books)
-        : authors_{authors}
-        , books_{books} {}
+    /* Без batch изменения единицы работы записываются без общей транзакции,
+     * без snapshot каждое чтение выполняется отдельно */
+    explicit UseCasesImpl(domain::AuthorRepository& authors, domain::BookRepository& books,
+                          domain::CommandBatch* batch = nullptr, domain::ReadSnapshot* snapshot = nullptr)
+        : unit_of_work_{authors, books, batch}
+        , snapshot_{snapshot} {}
 
     domain::AuthorId AddAuthor(const std::string& name) override;
     std::string GetAuthorName(const std::string& id) override;
@@ -42,9 +47,48 @@ public:
     domain::Book ShowBookInfoByID(const std::string& book_id) override;
     std::vector<domain::Book> ShowBookInfoByTitle(const std::string& book_title) override;
 
+    std::vector<domain::BookWithAuthor> ShowAllBooksWithAuthors(bool with_tags) override;
+    domain::BookWithAuthor ShowBookFullInfoByID(const std::string& book_id) override;
+    std::vector<domain::BookWithAuthor> ShowBookFullInfoByTitle(const std::string& book_title) override;
+
+    std::vector<domain::Author> ShowAuthorsPage(const std::optional<std::string>& after_name,
+                                                size_t limit) override;
+    std::vector<domain::BookWithAuthor> ShowBooksPage(const std::optional<domain::BookPageCursor>& after,
+                                                      size_t limit) override;
+    std::vector<domain::Book> ShowAuthorBooksPage(const std::string& author_id,
+                                                  const std::optional<domain::AuthorBookPageCursor>& after,
+                                                  size_t limit) override;
+
+    std::vector<domain::BookWithAuthor> ShowBooksByTag(const std::string& tag,
+                                                       const std::optional<domain::BookPageCursor>& after,
+                                                       size_t limit) override;
+    std::vector<domain::BookWithAuthor> ShowBooksByTags(const std::vector<std::string>& tags,
+                                                        domain::TagMatch match,
+                                                        const std::optional<domain::BookPageCursor>& after,
+                                                        size_t limit) override;
+
+    std::vector<domain::BookSearchResult> SearchBooks(const std::string& query,
+                                                      const std::optional<domain::BookSearchCursor>& after,
+                                                      size_t limit) override;
+
+    size_t ImportCatalog(std::istream& input, CatalogFormat format, size_t batch_size) override;
+    size_t ExportCatalog(std::ostream& output, CatalogFormat format) override;
+
+    void BeginWork() override;
+    void CommitWork() override;
+    void RollbackWork() noexcept override;
+
+    void BeginRead() override;
+    void EndRead() noexcept override;
+    void ReleaseRead() noexcept override;
+    void AttachRead(std::thread::id owner) noexcept override;
+    void DetachRead() noexcept override;
+
 private:
-    domain::AuthorRepository& authors_;
-    domain::BookRepository& books_;
+    UnitOfWork unit_of_work_;
+    domain::ReadSnapshot* snapshot_;
+    domain::AuthorRepository& authors_ = unit_of_work_.GetAuthors();
+    domain::BookRepository& books_ = unit_of_work_.GetBooks();
 };
 
 }  // namespace app
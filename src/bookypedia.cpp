@@ -1,9 +1,14 @@
 #include "bookypedia.h"
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 
+#include "app/async_runner.h"
 #include "menu/menu.h"
 #include "postgres/postgres.h"
+#include "stats/stats.h"
 #include "ui/view.h"
 
 namespace bookypedia {
@@ -11,7 +16,53 @@ namespace bookypedia {
 using namespace std::literals;
 
 Application::Application(const AppConfig& config)
-    : db_{pqxx::connection{config.db_url}} {
+    : db_{config.storage == StorageType::POSTGRES
+              ? std::make_unique<postgres::Database>(config.db_url, config.db_pool_size, config.slow_query_log,
+                                                    config.replicas)
+              : nullptr}
+    , memory_db_{config.storage == StorageType::MEMORY ? std::make_unique<memory::Database>() : nullptr}
+    , author_cache_{config.author_cache_size == 0
+                        ? nullptr
+                        : std::make_unique<cache::CachingAuthorRepository>(GetStorageAuthors(),
+                                                                           config.author_cache_size)}
+    , output_format_{config.output_format}
+    , stats_file_{config.stats_file} {
+    util::SetUUIDVersion(config.id_version);
+}
+
+domain::AuthorRepository& Application::GetStorageAuthors() {
+    if (memory_db_) {
+        return memory_db_->GetAuthors();
+    }
+    return db_->GetAuthors();
+}
+
+domain::BookRepository& Application::GetStorageBooks() {
+    if (memory_db_) {
+        return memory_db_->GetBooks();
+    }
+    return db_->GetBooks();
+}
+
+domain::CommandBatch& Application::GetCommandBatch() {
+    if (memory_db_) {
+        return memory_db_->GetCommandBatch();
+    }
+    return db_->GetCommandBatch();
+}
+
+domain::ReadSnapshot& Application::GetReadSnapshot() {
+    if (memory_db_) {
+        return memory_db_->GetReadSnapshot();
+    }
+    return db_->GetReadSnapshot();
+}
+
+domain::AuthorRepository& Application::GetAuthorRepository() {
+    if (author_cache_) {
+        return *author_cache_;
+    }
+    return GetStorageAuthors();
 }
 
 void Application::Run() {
@@ -23,8 +74,150 @@ void Application::Run() {
     menu.AddAction("Exit"s, {}, "Exit program"s, [&menu](std::istream&) {
         return false;
     });
-    ui::View view{menu, use_cases_, std::cin, std::cout};
+    menu.AddAction("RunScript"s, "<file> [<commands per transaction>]"s, "Run commands from file"s,
+                   [this, &menu](std::istream& cmd_input) {
+                       return RunScript(cmd_input, menu);
+                   });
+    menu.AddAction("Stats"s, "[reset]"s, "Show execution time of commands and queries"s,
+                   [this, &menu](std::istream& cmd_input) {
+                       return ShowStats(cmd_input, menu);
+                   });
+    // Интерактивные списки запрашивают следующую страницу в фоне, пока пользователь читает текущую.
+    // Сценарии RunScript выполняются без фоновых запросов: те шли бы мимо транзакции группы команд
+    app::AsyncRunner async_runner{PREFETCH_THREADS};
+    ui::View view{menu, use_cases_, std::cin, std::cout, output_format_, &async_runner};
     menu.Run();
+    DumpStats();
+}
+
+/* Пакетный режим: команды выполняются из файла группами по batch_size в одной транзакции,
+ * каждая команда - в своей точке сохранения. Пустые строки и строки, начинающиеся с #, пропускаются.
+ * Ответы на уточняющие вопросы команд (например, выбор книги) читаются из следующих строк файла.
+ * Команда Exit завершает сценарий, выполненные до неё команды фиксируются */
+bool Application::RunScript(std::istream& cmd_input, menu::Menu& menu) {
+    try {
+        std::string file_name;
+        if (!(cmd_input >> file_name)) {
+            throw std::runtime_error("File name is empty"s);
+        }
+        size_t batch_size = DEFAULT_SCRIPT_BATCH_SIZE;
+        if (std::string batch_size_str; cmd_input >> batch_size_str) {
+            batch_size = std::stoul(batch_size_str);
+        }
+        if (batch_size == 0) {
+            throw std::invalid_argument("Batch size must be positive"s);
+        }
+        std::ifstream script{file_name};
+        if (!script) {
+            throw std::runtime_error("Failed to open file"s);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const ScriptStats stats = ExecuteScript(script, batch_size);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Executed "sv << stats.commands << " commands in "sv << elapsed.count() << " s ("sv
+                  << (elapsed.count() > 0 ? stats.commands / elapsed.count() : 0) << " commands/s), "sv
+                  << stats.transactions << " transactions, "sv << stats.rolled_back << " commands rolled back"sv
+                  << std::endl;
+    } catch (const std::exception&) {
+        menu.ReportFailure();
+        std::cout << "Failed to run script"sv << std::endl;
+    }
+    return true;
+}
+
+Application::ScriptStats Application::ExecuteScript(std::istream& script, size_t batch_size) {
+    menu::Menu script_menu{script, std::cout};
+    script_menu.AddAction("Exit"s, {}, "Stop the script"s, [](std::istream&) {
+        return false;
+    });
+    ui::View view{script_menu, use_cases_, script, std::cout, output_format_};
+    auto& batch = GetCommandBatch();
+    ScriptStats stats;
+    size_t batch_commands = 0;
+    auto commit = [&] {
+        batch.Commit();
+        ResetAuthorCache();
+        ++stats.transactions;
+        batch_commands = 0;
+    };
+
+    try {
+        std::string line;
+        while (std::getline(script, line)) {
+            if (line.empty() || line.front() == '#') {
+                continue;
+            }
+            if (batch_commands == 0) {
+                batch.Begin();
+            }
+            batch.BeginCommand();
+            const bool proceed = script_menu.Execute(std::move(line));
+            if (!batch.EndCommand()) {
+                ++stats.rolled_back;
+                ResetAuthorCache();
+            }
+            ++stats.commands;
+            if (++batch_commands == batch_size || !proceed) {
+                commit();
+            }
+            if (!proceed) {
+                break;
+            }
+        }
+        if (batch_commands != 0) {
+            commit();
+        }
+    } catch (...) {
+        batch.Rollback();
+        ResetAuthorCache();
+        throw;
+    }
+    return stats;
+}
+
+/* Stats reset обнуляет счётчики, например, перед замером отдельного сценария */
+bool Application::ShowStats(std::istream& cmd_input, menu::Menu& menu) const {
+    if (std::string arg; cmd_input >> arg) {
+        if (arg != "reset"sv) {
+            menu.ReportFailure();
+            std::cout << "Unknown argument"sv << std::endl;
+            return true;
+        }
+        stats::ResetAll();
+        return true;
+    }
+    WriteStats(std::cout);
+    std::cout.flush();
+    return true;
+}
+
+void Application::WriteStats(std::ostream& output) const {
+    stats::WriteReport(output);
+    if (author_cache_) {
+        const auto cache_stats = author_cache_->GetStats();
+        output << "Author cache: "sv << cache_stats.hits << " hits, "sv << cache_stats.misses << " misses, "sv
+               << cache_stats.evictions << " evictions, "sv << cache_stats.size << " entries"sv << '\n';
+    }
+}
+
+void Application::DumpStats() const {
+    if (stats_file_.empty()) {
+        return;
+    }
+    std::ofstream output{stats_file_};
+    WriteStats(output);
+    if (!output) {
+        std::cerr << "Failed to write stats to "sv << stats_file_ << std::endl;
+    }
+}
+
+/* Кэш мог запомнить значения, изменённые отменёнными командами, а другие потоки -
+ * прочитать значения до фиксации группы */
+void Application::ResetAuthorCache() {
+    if (author_cache_) {
+        author_cache_->Clear();
+    }
 }
 
 }  // namespace bookypedia
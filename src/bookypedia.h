@@ -1,29 +1,84 @@
 /*
  * Модуль приложения.
- * 1) Создаётся объект модуля хранения (db_)
- * 2) Создаются объекты интерфейса взаимодействия с модулем представления данных (use_cases_)
+ * 1) Создаётся объект модуля хранения: СУБД PostgreSQL (db_) или память процесса (memory_db_)
+ * 2) Если задан размер кэша авторов, репозиторий авторов оборачивается кэшем (author_cache_)
+ * 3) Создаются объекты интерфейса взаимодействия с модулем представления данных (use_cases_)
+ * Команды читаются из std::cin либо из файла командой RunScript (пакетный режим)
+ * Команда Stats выводит статистику времени выполнения команд и запросов к СУБД,
+ * при завершении работы она записывается в файл stats_file, если он задан
  */
 #pragma once
 #include <pqxx/pqxx>
 
+#include <iosfwd>
+#include <memory>
+
 #include "app/use_cases_impl.h"
+#include "cache/author_cache.h"
+#include "memory/memory.h"
+#include "menu/menu.h"
 #include "postgres/postgres.h"
+#include "ui/renderer.h"
 
 namespace bookypedia {
 
+enum class StorageType {
+    POSTGRES,
+    MEMORY  // данные не сохраняются между запусками
+};
+
 struct AppConfig {
-    std::string db_url;
+    StorageType storage = StorageType::POSTGRES;
+    std::string db_url;  // используется только хранилищем POSTGRES
+    size_t db_pool_size = 4;
+    size_t author_cache_size = 0;  // 0 - кэш авторов отключён
+    util::UUIDVersion id_version = util::UUIDVersion::RANDOM;  // версия идентификаторов новых авторов и книг
+    ui::OutputFormat output_format = ui::OutputFormat::TEXT;  // начальный формат вывода списков
+    std::string stats_file;  // пустой - статистика при завершении не записывается
+    postgres::SlowQueryLogConfig slow_query_log;  // используется только хранилищем POSTGRES
+    postgres::ReplicaSetConfig replicas;  // используется только хранилищем POSTGRES, без URL реплик не используются
 };
 
 class Application {
 public:
+    /* Число команд сценария в одной транзакции по умолчанию */
+    static constexpr size_t DEFAULT_SCRIPT_BATCH_SIZE = 1'000;
+    /* Потоки фоновых запросов: в каждый момент запрашивается не больше одной следующей страницы */
+    static constexpr size_t PREFETCH_THREADS = 1;
+
     explicit Application(const AppConfig& config);
 
     void Run();
 
+    struct ScriptStats {
+        size_t commands = 0;
+        size_t rolled_back = 0;
+        size_t transactions = 0;
+    };
+
+    /* Выполнение команд сценария группами по batch_size (см. RunScript) */
+    ScriptStats ExecuteScript(std::istream& script, size_t batch_size);
+
 private:
-    postgres::Database db_;
-    app::UseCasesImpl use_cases_{db_.GetAuthors(), db_.GetBooks()};
+    /* Неудача команды сообщается меню menu для учёта в статистике */
+    bool RunScript(std::istream& cmd_input, menu::Menu& menu);
+    void ResetAuthorCache();
+    bool ShowStats(std::istream& cmd_input, menu::Menu& menu) const;
+    void WriteStats(std::ostream& output) const;
+    void DumpStats() const;
+
+    domain::AuthorRepository& GetStorageAuthors();
+    domain::BookRepository& GetStorageBooks();
+    domain::CommandBatch& GetCommandBatch();
+    domain::ReadSnapshot& GetReadSnapshot();
+    domain::AuthorRepository& GetAuthorRepository();
+
+    std::unique_ptr<postgres::Database> db_;
+    std::unique_ptr<memory::Database> memory_db_;
+    std::unique_ptr<cache::CachingAuthorRepository> author_cache_;
+    ui::OutputFormat output_format_;
+    std::string stats_file_;
+    app::UseCasesImpl use_cases_{GetAuthorRepository(), GetStorageBooks(), &GetCommandBatch(), &GetReadSnapshot()};
 };
 
 }  // namespace bookypedia
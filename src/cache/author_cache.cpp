@@ -0,0 +1,165 @@
+#include "author_cache.h"
+
+#include <stdexcept>
+
+namespace cache {
+
+CachingAuthorRepository::CachingAuthorRepository(domain::AuthorRepository& authors, size_t capacity)
+    : authors_{authors}
+    , capacity_{capacity} {
+    if (capacity_ == 0) {
+        throw std::invalid_argument("Cache capacity must be positive");
+    }
+}
+
+std::string CachingAuthorRepository::GetName(const domain::AuthorId& id) {
+    if (auto entry = FindById(id)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return std::move(entry->name);
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t generation = GetGeneration();
+    std::string name = authors_.GetName(id);
+    Insert({id, name}, generation);
+    return name;
+}
+
+std::string CachingAuthorRepository::GetID(const std::string& name) {
+    if (auto entry = FindByName(name)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return entry->id.ToString();
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t generation = GetGeneration();
+    std::string id = authors_.GetID(name);
+    Insert({domain::AuthorId::FromString(id), name}, generation);
+    return id;
+}
+
+std::vector<domain::Author> CachingAuthorRepository::Show() {
+    return authors_.Show();
+}
+
+std::vector<domain::Author> CachingAuthorRepository::ShowPage(const std::optional<std::string>& after_name,
+                                                              size_t limit) {
+    return authors_.ShowPage(after_name, limit);
+}
+
+/* Save может как добавить автора, так и переименовать существующего (по id) */
+void CachingAuthorRepository::Save(const domain::Author& author) {
+    InvalidateId(author.GetId());
+    InvalidateName(author.GetName());
+    authors_.Save(author);
+    InvalidateId(author.GetId());
+    InvalidateName(author.GetName());
+}
+
+void CachingAuthorRepository::Delete(const domain::AuthorId& id) {
+    InvalidateId(id);
+    authors_.Delete(id);
+    InvalidateId(id);
+}
+
+void CachingAuthorRepository::Delete(const std::string& name) {
+    InvalidateName(name);
+    authors_.Delete(name);
+    InvalidateName(name);
+}
+
+void CachingAuthorRepository::Edit(const domain::Author& new_author) {
+    InvalidateId(new_author.GetId());
+    InvalidateName(new_author.GetName());
+    authors_.Edit(new_author);
+    InvalidateId(new_author.GetId());
+    InvalidateName(new_author.GetName());
+}
+
+void CachingAuthorRepository::Edit(const std::string& old_name, const std::string& new_name) {
+    InvalidateName(old_name);
+    InvalidateName(new_name);
+    authors_.Edit(old_name, new_name);
+    InvalidateName(old_name);
+    InvalidateName(new_name);
+}
+
+CachingAuthorRepository::Stats CachingAuthorRepository::GetStats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    std::lock_guard lock{mutex_};
+    stats.size = lru_.size();
+    return stats;
+}
+
+std::optional<CachingAuthorRepository::Entry> CachingAuthorRepository::FindById(const domain::AuthorId& id) {
+    std::lock_guard lock{mutex_};
+    auto it = by_id_.find(id);
+    if (it == by_id_.end()) {
+        return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return *it->second;
+}
+
+std::optional<CachingAuthorRepository::Entry> CachingAuthorRepository::FindByName(const std::string& name) {
+    std::lock_guard lock{mutex_};
+    auto it = by_name_.find(name);
+    if (it == by_name_.end()) {
+        return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return *it->second;
+}
+
+void CachingAuthorRepository::Insert(Entry entry, uint64_t generation) {
+    std::lock_guard lock{mutex_};
+    if (generation != generation_ || by_id_.count(entry.id) != 0 || by_name_.count(entry.name) != 0) {
+        return;
+    }
+    lru_.push_front(std::move(entry));
+    by_id_.emplace(lru_.front().id, lru_.begin());
+    by_name_.emplace(lru_.front().name, lru_.begin());
+    if (lru_.size() > capacity_) {
+        Erase(std::prev(lru_.end()));
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void CachingAuthorRepository::InvalidateId(const domain::AuthorId& id) {
+    std::lock_guard lock{mutex_};
+    ++generation_;
+    if (auto it = by_id_.find(id); it != by_id_.end()) {
+        Erase(it->second);
+    }
+}
+
+void CachingAuthorRepository::InvalidateName(const std::string& name) {
+    std::lock_guard lock{mutex_};
+    ++generation_;
+    if (auto it = by_name_.find(name); it != by_name_.end()) {
+        Erase(it->second);
+    }
+}
+
+void CachingAuthorRepository::Clear() {
+    std::lock_guard lock{mutex_};
+    ++generation_;
+    by_id_.clear();
+    by_name_.clear();
+    lru_.clear();
+}
+
+/* Вызывается под блокировкой mutex_ */
+void CachingAuthorRepository::Erase(EntryList::iterator it) {
+    by_name_.erase(it->name);
+    by_id_.erase(it->id);
+    lru_.erase(it);
+}
+
+uint64_t CachingAuthorRepository::GetGeneration() const {
+    std::lock_guard lock{mutex_};
+    return generation_;
+}
+
+}  // namespace cache
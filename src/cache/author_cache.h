@@ -0,0 +1,82 @@
+/*
+ * Модуль кэширования.
+ * CachingAuthorRepository - декоратор domain::AuthorRepository, кэширующий
+ * соответствие id <-> имя автора. Размер кэша ограничен, при переполнении
+ * вытесняются давно не использовавшиеся записи (LRU). Операции записи
+ * (Save, Edit, Delete) сбрасывают затронутые записи.
+ * Кэш локален для процесса: изменения, сделанные другими экземплярами
+ * программы, становятся видны после вытеснения записи.
+ */
+#pragma once
+#include <atomic>
+#include <boost/uuid/uuid_hash.hpp>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../domain/author.h"
+
+namespace cache {
+
+class CachingAuthorRepository : public domain::AuthorRepository {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t size = 0;
+    };
+
+    CachingAuthorRepository(domain::AuthorRepository& authors, size_t capacity);
+
+    void Save(const domain::Author& author) override;
+    std::string GetName(const domain::AuthorId& id) override;
+    std::string GetID(const std::string& name) override;
+    std::vector<domain::Author> Show() override;
+    std::vector<domain::Author> ShowPage(const std::optional<std::string>& after_name, size_t limit) override;
+    void Delete(const domain::AuthorId& id) override;
+    void Delete(const std::string& name) override;
+    void Edit(const domain::Author& new_author) override;
+    void Edit(const std::string& old_name, const std::string& new_name) override;
+
+    Stats GetStats() const;
+    /* Сбрасывает все записи. Нужен, когда изменения могли быть отменены
+     * или зафиксированы в обход кэша, например в пакетном режиме */
+    void Clear();
+
+private:
+    struct Entry {
+        domain::AuthorId id;
+        std::string name;
+    };
+    using EntryList = std::list<Entry>;
+
+    std::optional<Entry> FindById(const domain::AuthorId& id);
+    std::optional<Entry> FindByName(const std::string& name);
+    /* Запись добавляется, только если с момента начала чтения (generation)
+     * не было инвалидаций: иначе в кэш могло бы попасть устаревшее значение */
+    void Insert(Entry entry, uint64_t generation);
+    void InvalidateId(const domain::AuthorId& id);
+    void InvalidateName(const std::string& name);
+    void Erase(EntryList::iterator it);
+    uint64_t GetGeneration() const;
+
+    domain::AuthorRepository& authors_;
+    const size_t capacity_;
+
+    mutable std::mutex mutex_;
+    EntryList lru_;  // в начале списка - последние использованные записи
+    std::unordered_map<domain::AuthorId, EntryList::iterator, util::TaggedHasher<domain::AuthorId>> by_id_;
+    std::unordered_map<std::string_view, EntryList::iterator> by_name_;
+    uint64_t generation_ = 0;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
+
+}  // namespace cache
@@ -7,11 +7,17 @@
  * а также интерфейсы для взаимодействия с модулем хранения:
  * - AuthorRepository - запись, чтение в таблицу "authors" в СУБД
  * - BookRepository - запись, чтение в таблицу "books" в СУБД
+ * - CommandBatch - выполнение группы команд в одной транзакции
+ * - ReadSnapshot - общий снимок данных для чтения на время команды
+ * Проекция BookWithAuthor (книга + имя автора) используется для вывода списков книг
  * Интерфейсы реализованы в модуле хранения
  */
 #pragma once
 #include <cstdint>
+#include <functional>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "../util/tagged_uuid.h"
@@ -53,6 +59,8 @@ public:
     virtual std::string GetName(const AuthorId& id) = 0;
     virtual std::string GetID(const std::string& name) = 0;
     virtual std::vector<Author> Show() = 0;
+    /* Страница списка авторов (по алфавиту), начиная с автора, следующего за after_name */
+    virtual std::vector<Author> ShowPage(const std::optional<std::string>& after_name, size_t limit) = 0;
     virtual void Delete(const AuthorId& id) = 0;
     virtual void Delete(const std::string& name) = 0;
     virtual void Edit(const Author& new_author) = 0;
@@ -108,18 +116,147 @@ private:
     std::vector<std::string> tags_;
 };
 
+/* Книга вместе с именем её автора. Проекция для вывода списков книг:
+ * данные книги и автора получаются одним запросом с JOIN */
+class BookWithAuthor {
+public:
+    BookWithAuthor(Book book, std::string author_name)
+            : book_(std::move(book))
+            , author_name_(std::move(author_name)) {}
+
+    const Book& GetBook() const noexcept {
+        return book_;
+    }
+
+    const std::string& GetAuthorName() const noexcept {
+        return author_name_;
+    }
+
+private:
+    Book book_;
+    std::string author_name_;
+};
+
+/* Курсоры постраничного вывода (keyset pagination) - ключ сортировки последней
+ * книги предыдущей страницы. Следующая страница выбирается условием "ключ > курсор",
+ * поэтому её получение не зависит от номера страницы и размера каталога */
+
+/* Список всех книг: название, имя автора, год публикации */
+struct BookPageCursor {
+    std::string title;
+    std::string author_name;
+    uint64_t publication_year = 0;
+    BookId id;
+};
+
+/* Книги автора: год публикации, название */
+struct AuthorBookPageCursor {
+    uint64_t publication_year = 0;
+    std::string title;
+    BookId id;
+};
+
+/* Запись каталога для массового импорта и экспорта: книга, имя её автора и теги.
+ * Автор определяется по имени и добавляется, если его ещё нет */
+struct CatalogRecord {
+    std::string author_name;
+    std::string title;
+    uint64_t publication_year = 0;
+    std::vector<std::string> tags;
+};
+
+/* Условие выбора книг по нескольким тегам: хотя бы один из тегов или все теги сразу */
+enum class TagMatch {
+    ANY,
+    ALL
+};
+
+/* Книга, найденная поиском, и её релевантность запросу (чем больше, тем лучше) */
+struct BookSearchResult {
+    BookWithAuthor book;
+    double rank = 0;
+};
+
+/* Результаты поиска упорядочены по убыванию релевантности, затем по id */
+struct BookSearchCursor {
+    double rank = 0;
+    BookId id;
+};
+
 class BookRepository {
 public:
     virtual void Save(const Book& book) = 0;
     virtual std::vector<Book> ShowAll() = 0;
+    virtual std::vector<BookWithAuthor> ShowAllWithAuthors(bool with_tags) = 0;
+    virtual std::vector<BookWithAuthor> ShowPageWithAuthors(const std::optional<BookPageCursor>& after,
+                                                            size_t limit) = 0;
+    virtual std::vector<Book> ShowPageByAuthor(const AuthorId& author_id,
+                                               const std::optional<AuthorBookPageCursor>& after,
+                                               size_t limit) = 0;
+    /* Страница книг с тегами tags в порядке списка всех книг */
+    virtual std::vector<BookWithAuthor> ShowPageByTags(const std::vector<std::string>& tags, TagMatch match,
+                                                       const std::optional<BookPageCursor>& after,
+                                                       size_t limit) = 0;
     virtual std::vector<Book> ShowByAuthor(const AuthorId& author_id) = 0;
     virtual Book ShowInfoByID(const BookId& book_id) = 0;
     virtual std::vector<Book> ShowInfoByTitle(const std::string& book_title) = 0;
+    virtual BookWithAuthor ShowInfoWithAuthorByID(const BookId& book_id) = 0;
+    virtual std::vector<BookWithAuthor> ShowInfoWithAuthorByTitle(const std::string& book_title) = 0;
+    /* Нечёткий поиск по фрагментам названия, имени автора и тегов с учётом опечаток */
+    virtual std::vector<BookSearchResult> Search(const std::string& query,
+                                                 const std::optional<BookSearchCursor>& after,
+                                                 size_t limit) = 0;
     virtual void Delete(const BookId& id) = 0;
     virtual void Edit(const Book& new_book) = 0;
+    /* Пакет записей импортируется в одной транзакции */
+    virtual void Import(const std::vector<CatalogRecord>& records) = 0;
+    /* Записи каталога передаются visitor по одной по мере чтения из СУБД,
+     * весь каталог в памяти не хранится */
+    virtual void Export(const std::function<void(const CatalogRecord&)>& visitor) = 0;
 
 protected:
     ~BookRepository() = default;
 };
 
+/* ---------------------------- Command Batch ---------------------------- */
+
+/* Группа команд в одной транзакции хранилища (пакетный режим).
+ * Операции репозиториев между Begin и Commit выполняются в общей транзакции,
+ * каждая команда - между BeginCommand и EndCommand в своей точке сохранения:
+ * ошибка отменяет изменения только этой команды */
+class CommandBatch {
+public:
+    virtual void Begin() = 0;
+    virtual void BeginCommand() = 0;
+    /* Возвращает false, если при выполнении команды была ошибка и её изменения отменены */
+    virtual bool EndCommand() = 0;
+    virtual void Commit() = 0;
+    virtual void Rollback() noexcept = 0;
+    /* Открыта ли группа вызывающим потоком */
+    virtual bool IsOpen() const noexcept = 0;
+
+protected:
+    ~CommandBatch() = default;
+};
+
+/* ---------------------------- Read Snapshot ---------------------------- */
+
+/* Пока снимок открыт, операции чтения репозиториев видят одно и то же состояние хранилища,
+ * даже если другие клиенты его меняют. Запись в снимке не выполняется.
+ * Снимок свой у каждого потока, открывшего его (владельца), остальные потоки читают вне снимков */
+class ReadSnapshot {
+public:
+    virtual void Begin() = 0;
+    virtual void End() noexcept = 0;
+    /* Закрывает транзакцию открытого снимка, следующее чтение начнёт новый снимок */
+    virtual void Release() noexcept = 0;
+    /* Чтения вызывающего потока до Detach выполняются в снимке потока owner,
+     * например, фоновый запрос страницы для команды владельца */
+    virtual void Attach(std::thread::id owner) noexcept = 0;
+    virtual void Detach() noexcept = 0;
+
+protected:
+    ~ReadSnapshot() = default;
+};
+
 }  // namespace domain
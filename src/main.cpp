@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "bookypedia.h"
 
@@ -9,14 +13,124 @@ using namespace std::literals;
 namespace {
 
 constexpr const char DB_URL_ENV_NAME[]{"BOOKYPEDIA_DB_URL"};
-/* Чтение URL базы данных из переменной окружения BOOKYPEDIA_DB_URL */
+constexpr const char DB_POOL_SIZE_ENV_NAME[]{"BOOKYPEDIA_DB_POOL_SIZE"};
+constexpr const char AUTHOR_CACHE_SIZE_ENV_NAME[]{"BOOKYPEDIA_AUTHOR_CACHE_SIZE"};
+constexpr const char STORAGE_ENV_NAME[]{"BOOKYPEDIA_STORAGE"};
+constexpr const char ID_VERSION_ENV_NAME[]{"BOOKYPEDIA_ID_VERSION"};
+constexpr const char OUTPUT_FORMAT_ENV_NAME[]{"BOOKYPEDIA_OUTPUT_FORMAT"};
+constexpr const char STATS_FILE_ENV_NAME[]{"BOOKYPEDIA_STATS_FILE"};
+constexpr const char SLOW_QUERY_MS_ENV_NAME[]{"BOOKYPEDIA_SLOW_QUERY_MS"};
+constexpr const char SLOW_QUERY_LOG_ENV_NAME[]{"BOOKYPEDIA_SLOW_QUERY_LOG"};
+constexpr const char SLOW_QUERY_EXPLAIN_ENV_NAME[]{"BOOKYPEDIA_SLOW_QUERY_EXPLAIN"};
+constexpr const char DB_REPLICA_URLS_ENV_NAME[]{"BOOKYPEDIA_DB_REPLICA_URLS"};
+constexpr const char DB_REPLICA_POLICY_ENV_NAME[]{"BOOKYPEDIA_DB_REPLICA_POLICY"};
+constexpr const char DB_REPLICA_PIN_MS_ENV_NAME[]{"BOOKYPEDIA_DB_REPLICA_PIN_MS"};
+
+bookypedia::StorageType StorageTypeFromString(const std::string& storage) {
+    if (storage == "postgres"s) {
+        return bookypedia::StorageType::POSTGRES;
+    }
+    if (storage == "memory"s) {
+        return bookypedia::StorageType::MEMORY;
+    }
+    throw std::runtime_error(STORAGE_ENV_NAME + " must be \"postgres\" or \"memory\""s);
+}
+
+util::UUIDVersion UUIDVersionFromString(const std::string& version) {
+    if (version == "v4"s) {
+        return util::UUIDVersion::RANDOM;
+    }
+    if (version == "v7"s) {
+        return util::UUIDVersion::TIME_ORDERED;
+    }
+    throw std::runtime_error(ID_VERSION_ENV_NAME + " must be \"v4\" or \"v7\""s);
+}
+
+postgres::ReplicaPolicy ReplicaPolicyFromString(const std::string& policy) {
+    if (policy == "round_robin"s) {
+        return postgres::ReplicaPolicy::ROUND_ROBIN;
+    }
+    if (policy == "least_latency"s) {
+        return postgres::ReplicaPolicy::LEAST_LATENCY;
+    }
+    throw std::runtime_error(DB_REPLICA_POLICY_ENV_NAME + " must be \"round_robin\" or \"least_latency\""s);
+}
+
+/* URL через запятую; пустые элементы пропускаются */
+std::vector<std::string> SplitUrls(const std::string& urls) {
+    std::vector<std::string> result;
+    size_t begin = 0;
+    while (begin <= urls.size()) {
+        size_t end = std::min(urls.find(',', begin), urls.size());
+        if (end > begin) {
+            result.push_back(urls.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return result;
+}
+
+/* Чтение типа хранилища из переменной окружения BOOKYPEDIA_STORAGE (postgres по умолчанию или memory),
+ * URL базы данных из BOOKYPEDIA_DB_URL (обязателен для postgres)
+ * и (необязательно) размера пула соединений из BOOKYPEDIA_DB_POOL_SIZE,
+ * размера кэша авторов из BOOKYPEDIA_AUTHOR_CACHE_SIZE
+ * версии UUID новых идентификаторов из BOOKYPEDIA_ID_VERSION (v4 по умолчанию или v7)
+ * формата вывода из BOOKYPEDIA_OUTPUT_FORMAT (text по умолчанию, tsv или jsonl)
+ * файла статистики, записываемой при завершении, из BOOKYPEDIA_STATS_FILE,
+ * порога медленных запросов в миллисекундах из BOOKYPEDIA_SLOW_QUERY_MS (без него журнал отключён),
+ * файла журнала из BOOKYPEDIA_SLOW_QUERY_LOG (std::cerr по умолчанию),
+ * необходимости получать их планы из BOOKYPEDIA_SLOW_QUERY_EXPLAIN (1 - получать),
+ * URL реплик для чтения через запятую из BOOKYPEDIA_DB_REPLICA_URLS,
+ * способа выбора реплики из BOOKYPEDIA_DB_REPLICA_POLICY (round_robin по умолчанию или least_latency)
+ * и времени чтения с основного сервера после записи в миллисекундах из BOOKYPEDIA_DB_REPLICA_PIN_MS */
 bookypedia::AppConfig GetConfigFromEnv() {
     bookypedia::AppConfig config;
+    if (const auto* storage = std::getenv(STORAGE_ENV_NAME)) {
+        config.storage = StorageTypeFromString(storage);
+    }
     if (const auto* url = std::getenv(DB_URL_ENV_NAME)) {
         config.db_url = url;
-    } else {
+    } else if (config.storage == bookypedia::StorageType::POSTGRES) {
         throw std::runtime_error(DB_URL_ENV_NAME + " environment variable not found"s);
     }
+    if (const auto* pool_size = std::getenv(DB_POOL_SIZE_ENV_NAME)) {
+        config.db_pool_size = std::stoul(pool_size);
+    }
+    if (const auto* cache_size = std::getenv(AUTHOR_CACHE_SIZE_ENV_NAME)) {
+        config.author_cache_size = std::stoul(cache_size);
+    }
+    if (const auto* id_version = std::getenv(ID_VERSION_ENV_NAME)) {
+        config.id_version = UUIDVersionFromString(id_version);
+    }
+    if (const auto* output_format = std::getenv(OUTPUT_FORMAT_ENV_NAME)) {
+        auto format = ui::OutputFormatFromString(output_format);
+        if (!format) {
+            throw std::runtime_error(OUTPUT_FORMAT_ENV_NAME + " must be \"text\", \"tsv\" or \"jsonl\""s);
+        }
+        config.output_format = *format;
+    }
+    if (const auto* stats_file = std::getenv(STATS_FILE_ENV_NAME)) {
+        config.stats_file = stats_file;
+    }
+    if (const auto* slow_query_ms = std::getenv(SLOW_QUERY_MS_ENV_NAME)) {
+        config.slow_query_log.threshold = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::duration<double, std::milli>{std::stod(slow_query_ms)});
+    }
+    if (const auto* slow_query_log = std::getenv(SLOW_QUERY_LOG_ENV_NAME)) {
+        config.slow_query_log.file = slow_query_log;
+    }
+    if (const auto* explain = std::getenv(SLOW_QUERY_EXPLAIN_ENV_NAME)) {
+        config.slow_query_log.explain = explain == "1"s;
+    }
+    if (const auto* replica_urls = std::getenv(DB_REPLICA_URLS_ENV_NAME)) {
+        config.replicas.urls = SplitUrls(replica_urls);
+    }
+    if (const auto* replica_policy = std::getenv(DB_REPLICA_POLICY_ENV_NAME)) {
+        config.replicas.policy = ReplicaPolicyFromString(replica_policy);
+    }
+    if (const auto* pin_ms = std::getenv(DB_REPLICA_PIN_MS_ENV_NAME)) {
+        config.replicas.pin_after_write = std::chrono::milliseconds{std::stol(pin_ms)};
+    }
     return config;
 }
 
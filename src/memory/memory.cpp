@@ -0,0 +1,777 @@
+#include "memory.h"
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace memory {
+
+using namespace std::literals;
+
+namespace {
+
+/* Порог и веса совпадений те же, что в запросе search_books модуля postgres */
+constexpr double SEARCH_THRESHOLD = 0.6;
+constexpr double AUTHOR_MATCH_WEIGHT = 0.8;
+constexpr double TAG_MATCH_WEIGHT = 0.6;
+
+/* Триграммы строки, как в pg_trgm: строка делится на слова из букв и цифр (байты UTF-8 за пределами
+ * ASCII считаются буквами), слова приводятся к нижнему регистру и дополняются пробелами: "  word ".
+ * Триграмма упаковывается в три младших байта числа, результат упорядочен и без повторов */
+std::vector<uint32_t> Trigrams(std::string_view text) {
+    std::vector<uint32_t> trigrams;
+    uint32_t window = 0;
+    size_t word_length = 0;
+    auto push = [&](unsigned char byte) {
+        window = ((window << 8) | byte) & 0xFFFFFF;
+        trigrams.push_back(window);
+    };
+    auto end_word = [&] {
+        if (word_length > 0) {
+            push(' ');
+            word_length = 0;
+        }
+    };
+    for (const char c : text) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (byte >= 0x80 || std::isalnum(byte)) {
+            if (word_length++ == 0) {
+                window = (' ' << 8) | ' ';
+            }
+            push(static_cast<unsigned char>(std::tolower(byte)));
+        } else {
+            end_word();
+        }
+    }
+    end_word();
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+/* Доля триграмм запроса, найденных в тексте. Приближение word_similarity из pg_trgm:
+ * совпавшие триграммы не обязаны идти в тексте подряд */
+double Similarity(const std::vector<uint32_t>& query_trigrams, std::string_view text) {
+    if (query_trigrams.empty()) {
+        return 0;
+    }
+    const auto text_trigrams = Trigrams(text);
+    size_t common = 0;
+    for (auto query_it = query_trigrams.begin(), text_it = text_trigrams.begin();
+         query_it != query_trigrams.end() && text_it != text_trigrams.end();) {
+        if (*query_it < *text_it) {
+            ++query_it;
+        } else if (*text_it < *query_it) {
+            ++text_it;
+        } else {
+            ++common;
+            ++query_it;
+            ++text_it;
+        }
+    }
+    return static_cast<double>(common) / static_cast<double>(query_trigrams.size());
+}
+
+}  // namespace
+
+bool Storage::BookOrderKey::operator<(const BookOrderKey& other) const {
+    const auto lhs = std::tie(title, author_name, publication_year);
+    const auto rhs = std::tie(other.title, other.author_name, other.publication_year);
+    if (lhs != rhs) {
+        return lhs < rhs;
+    }
+    return *id < *other.id;
+}
+
+bool Storage::AuthorBookOrderKey::operator<(const AuthorBookOrderKey& other) const {
+    const auto lhs = std::tie(publication_year, title);
+    const auto rhs = std::tie(other.publication_year, other.title);
+    if (lhs != rhs) {
+        return lhs < rhs;
+    }
+    return *id < *other.id;
+}
+
+/* ---------------------------- Author ---------------------------- */
+
+void Storage::SaveAuthor(const domain::Author& author) {
+    std::unique_lock lock{mutex_};
+    if (author_names_.contains(author.GetId())) {
+        RenameAuthor(author.GetId(), author.GetName());
+    } else {
+        InsertAuthor(author.GetId(), author.GetName());
+    }
+}
+
+std::string Storage::GetAuthorName(const domain::AuthorId& id) const {
+    std::shared_lock lock{mutex_};
+    auto it = author_names_.find(id);
+    if (it == author_names_.end()) {
+        throw std::runtime_error("No such author"s);
+    }
+    return it->second;
+}
+
+std::string Storage::GetAuthorID(const std::string& name) const {
+    std::shared_lock lock{mutex_};
+    auto it = author_ids_by_name_.find(name);
+    if (it == author_ids_by_name_.end()) {
+        throw std::runtime_error("No such author"s);
+    }
+    return it->second.ToString();
+}
+
+std::vector<domain::Author> Storage::ShowAuthors() const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::Author> authors;
+    authors.reserve(author_ids_by_name_.size());
+    for (const auto& [name, id] : author_ids_by_name_) {
+        authors.emplace_back(id, name);
+    }
+    return authors;
+}
+
+std::vector<domain::Author> Storage::ShowAuthorsPage(const std::optional<std::string>& after_name,
+                                                     size_t limit) const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::Author> authors;
+    auto it = after_name ? author_ids_by_name_.upper_bound(*after_name) : author_ids_by_name_.begin();
+    for (; it != author_ids_by_name_.end() && authors.size() < limit; ++it) {
+        authors.emplace_back(it->second, it->first);
+    }
+    return authors;
+}
+
+/* Книги автора и их теги удаляются каскадно */
+void Storage::DeleteAuthor(const domain::AuthorId& id) {
+    std::unique_lock lock{mutex_};
+    if (!author_names_.contains(id)) {
+        throw std::runtime_error("No such author"s);
+    }
+    EraseAuthor(id);
+}
+
+void Storage::DeleteAuthor(const std::string& name) {
+    std::unique_lock lock{mutex_};
+    auto it = author_ids_by_name_.find(name);
+    if (it == author_ids_by_name_.end()) {
+        throw std::runtime_error("No such author"s);
+    }
+    EraseAuthor(domain::AuthorId{it->second});
+}
+
+void Storage::EditAuthor(const domain::Author& new_author) {
+    std::unique_lock lock{mutex_};
+    if (author_names_.contains(new_author.GetId())) {
+        RenameAuthor(new_author.GetId(), new_author.GetName());
+    }
+}
+
+void Storage::EditAuthor(const std::string& old_name, const std::string& new_name) {
+    std::unique_lock lock{mutex_};
+    auto it = author_ids_by_name_.find(old_name);
+    if (it != author_ids_by_name_.end()) {
+        RenameAuthor(domain::AuthorId{it->second}, new_name);
+    }
+}
+
+/* ---------------------------- Book ---------------------------- */
+
+void Storage::SaveBook(const domain::Book& book) {
+    std::unique_lock lock{mutex_};
+    if (!author_names_.contains(book.GetAuthorId())) {
+        ViolateConstraint("No such author"s);
+    }
+    if (books_.contains(book.GetId())) {
+        ViolateConstraint("Book already exists"s);
+    }
+    InsertBook(book.GetId(), {book.GetAuthorId(), book.GetTitle(), book.GetPublicationYear(), book.GetTags()});
+}
+
+std::vector<domain::Book> Storage::ShowAllBooks() const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::Book> books;
+    books.reserve(books_order_.size());
+    for (const auto& key : books_order_) {
+        books.push_back(MakeBook(key.id, GetBook(key.id), false));
+    }
+    return books;
+}
+
+std::vector<domain::BookWithAuthor> Storage::ShowAllBooksWithAuthors(bool with_tags) const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::BookWithAuthor> books;
+    books.reserve(books_order_.size());
+    for (const auto& key : books_order_) {
+        books.push_back(MakeBookWithAuthor(key.id, GetBook(key.id), with_tags));
+    }
+    return books;
+}
+
+std::vector<domain::BookWithAuthor> Storage::ShowBooksPage(const std::optional<domain::BookPageCursor>& after,
+                                                           size_t limit) const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::BookWithAuthor> books;
+    auto it = after
+              ? books_order_.upper_bound({after->title, after->author_name, after->publication_year, after->id})
+              : books_order_.begin();
+    for (; it != books_order_.end() && books.size() < limit; ++it) {
+        books.push_back(MakeBookWithAuthor(it->id, GetBook(it->id), false));
+    }
+    return books;
+}
+
+/* Книги выбираются по хеш-индексу тегов. Для условия ALL перебираются книги самого редкого тега */
+std::vector<domain::BookWithAuthor> Storage::ShowBooksPageByTags(const std::vector<std::string>& tags,
+                                                                 domain::TagMatch match,
+                                                                 const std::optional<domain::BookPageCursor>& after,
+                                                                 size_t limit) const {
+    std::shared_lock lock{mutex_};
+    using BookIdSet = std::unordered_set<domain::BookId, BookHasher>;
+    std::vector<const BookIdSet*> tag_books;
+    for (const auto& tag : std::set<std::string>{tags.begin(), tags.end()}) {
+        auto it = books_by_tag_.find(tag);
+        if (it != books_by_tag_.end()) {
+            tag_books.push_back(&it->second);
+        } else if (match == domain::TagMatch::ALL) {
+            return {};
+        }
+    }
+
+    BookIdSet ids;
+    if (match == domain::TagMatch::ANY) {
+        for (const auto* books : tag_books) {
+            ids.insert(books->begin(), books->end());
+        }
+    } else if (!tag_books.empty()) {
+        std::sort(tag_books.begin(), tag_books.end(), [](const BookIdSet* lhs, const BookIdSet* rhs) {
+            return lhs->size() < rhs->size();
+        });
+        for (const auto& id : *tag_books.front()) {
+            if (std::all_of(tag_books.begin() + 1, tag_books.end(), [&id](const BookIdSet* books) {
+                    return books->contains(id);
+                })) {
+                ids.insert(id);
+            }
+        }
+    }
+
+    std::optional<BookOrderKey> after_key;
+    if (after) {
+        after_key = BookOrderKey{after->title, after->author_name, after->publication_year, after->id};
+    }
+    std::vector<BookOrderKey> keys;
+    for (const auto& id : ids) {
+        auto key = MakeBookOrderKey(id, GetBook(id));
+        if (!after_key || *after_key < key) {
+            keys.push_back(std::move(key));
+        }
+    }
+    const size_t count = std::min(limit, keys.size());
+    std::partial_sort(keys.begin(), keys.begin() + count, keys.end());
+
+    std::vector<domain::BookWithAuthor> books;
+    books.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        books.push_back(MakeBookWithAuthor(keys[i].id, GetBook(keys[i].id), false));
+    }
+    return books;
+}
+
+std::vector<domain::Book> Storage::ShowBooksByAuthor(const domain::AuthorId& author_id) const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::Book> books;
+    if (auto it = books_by_author_.find(author_id); it != books_by_author_.end()) {
+        books.reserve(it->second.size());
+        for (const auto& key : it->second) {
+            books.push_back(MakeBook(key.id, GetBook(key.id), false));
+        }
+    }
+    return books;
+}
+
+std::vector<domain::Book> Storage::ShowAuthorBooksPage(const domain::AuthorId& author_id,
+                                                       const std::optional<domain::AuthorBookPageCursor>& after,
+                                                       size_t limit) const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::Book> books;
+    auto author_it = books_by_author_.find(author_id);
+    if (author_it == books_by_author_.end()) {
+        return books;
+    }
+    const auto& author_books = author_it->second;
+    auto it = after
+              ? author_books.upper_bound({after->publication_year, after->title, after->id})
+              : author_books.begin();
+    for (; it != author_books.end() && books.size() < limit; ++it) {
+        books.push_back(MakeBook(it->id, GetBook(it->id), false));
+    }
+    return books;
+}
+
+domain::Book Storage::ShowBookInfoByID(const domain::BookId& book_id) const {
+    std::shared_lock lock{mutex_};
+    return MakeBook(book_id, GetBook(book_id), true);
+}
+
+std::vector<domain::Book> Storage::ShowBookInfoByTitle(const std::string& book_title) const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::Book> books;
+    if (auto it = books_by_title_.find(book_title); it != books_by_title_.end()) {
+        books.reserve(it->second.size());
+        for (const auto& id : it->second) {
+            books.push_back(MakeBook(id, GetBook(id), true));
+        }
+    }
+    std::sort(books.begin(), books.end(), [](const domain::Book& lhs, const domain::Book& rhs) {
+        return lhs.GetPublicationYear() < rhs.GetPublicationYear();
+    });
+    return books;
+}
+
+domain::BookWithAuthor Storage::ShowBookWithAuthorByID(const domain::BookId& book_id) const {
+    std::shared_lock lock{mutex_};
+    return MakeBookWithAuthor(book_id, GetBook(book_id), true);
+}
+
+std::vector<domain::BookWithAuthor> Storage::ShowBooksWithAuthorByTitle(const std::string& book_title) const {
+    std::shared_lock lock{mutex_};
+    std::vector<domain::BookWithAuthor> books;
+    if (auto it = books_by_title_.find(book_title); it != books_by_title_.end()) {
+        books.reserve(it->second.size());
+        for (const auto& id : it->second) {
+            books.push_back(MakeBookWithAuthor(id, GetBook(id), true));
+        }
+    }
+    std::sort(books.begin(), books.end(), [](const domain::BookWithAuthor& lhs, const domain::BookWithAuthor& rhs) {
+        if (lhs.GetAuthorName() != rhs.GetAuthorName()) {
+            return lhs.GetAuthorName() < rhs.GetAuthorName();
+        }
+        return lhs.GetBook().GetPublicationYear() < rhs.GetBook().GetPublicationYear();
+    });
+    return books;
+}
+
+/* Индексов для поиска нет: сравниваются все различные названия, имена авторов и теги,
+ * которых обычно заметно меньше, чем книг */
+std::vector<domain::BookSearchResult> Storage::SearchBooks(const std::string& query,
+                                                           const std::optional<domain::BookSearchCursor>& after,
+                                                           size_t limit) const {
+    std::shared_lock lock{mutex_};
+    const auto query_trigrams = Trigrams(query);
+    std::unordered_map<domain::BookId, double, BookHasher> ranks;
+    auto add_match = [&ranks](const domain::BookId& id, double score) {
+        auto [it, inserted] = ranks.try_emplace(id, score);
+        if (!inserted) {
+            it->second = std::max(it->second, score);
+        }
+    };
+    for (const auto& [title, ids] : books_by_title_) {
+        if (const double score = Similarity(query_trigrams, title); score >= SEARCH_THRESHOLD) {
+            for (const auto& id : ids) {
+                add_match(id, score);
+            }
+        }
+    }
+    for (const auto& [author_id, author_books] : books_by_author_) {
+        const double score = Similarity(query_trigrams, author_names_.at(author_id));
+        if (score >= SEARCH_THRESHOLD) {
+            for (const auto& key : author_books) {
+                add_match(key.id, AUTHOR_MATCH_WEIGHT * score);
+            }
+        }
+    }
+    for (const auto& [tag, ids] : books_by_tag_) {
+        if (const double score = Similarity(query_trigrams, tag); score >= SEARCH_THRESHOLD) {
+            for (const auto& id : ids) {
+                add_match(id, TAG_MATCH_WEIGHT * score);
+            }
+        }
+    }
+
+    auto precedes = [](double lhs_rank, const domain::BookId& lhs_id, double rhs_rank, const domain::BookId& rhs_id) {
+        if (lhs_rank != rhs_rank) {
+            return lhs_rank > rhs_rank;
+        }
+        return *lhs_id < *rhs_id;
+    };
+    std::vector<std::pair<domain::BookId, double>> found;
+    for (const auto& [id, rank] : ranks) {
+        if (!after || precedes(after->rank, after->id, rank, id)) {
+            found.emplace_back(id, rank);
+        }
+    }
+    const size_t count = std::min(limit, found.size());
+    std::partial_sort(found.begin(), found.begin() + count, found.end(), [&precedes](const auto& lhs, const auto& rhs) {
+        return precedes(lhs.second, lhs.first, rhs.second, rhs.first);
+    });
+
+    std::vector<domain::BookSearchResult> books;
+    books.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const auto& [id, rank] = found[i];
+        books.push_back({MakeBookWithAuthor(id, GetBook(id), true), rank});
+    }
+    return books;
+}
+
+void Storage::DeleteBook(const domain::BookId& id) {
+    std::unique_lock lock{mutex_};
+    if (!books_.contains(id)) {
+        throw std::runtime_error("No such book"s);
+    }
+    EraseBook(id);
+}
+
+void Storage::EditBook(const domain::Book& new_book) {
+    std::unique_lock lock{mutex_};
+    auto it = books_.find(new_book.GetId());
+    if (it == books_.end()) {
+        return;
+    }
+    BookRecord book = it->second;
+    book.title = new_book.GetTitle();
+    book.publication_year = new_book.GetPublicationYear();
+    book.tags = new_book.GetTags();
+    EraseBook(new_book.GetId());
+    InsertBook(new_book.GetId(), std::move(book));
+}
+
+/* Авторы ищутся по имени и добавляются, если их ещё нет */
+void Storage::ImportBooks(const std::vector<domain::CatalogRecord>& records) {
+    std::unique_lock lock{mutex_};
+    for (const auto& record : records) {
+        auto author_it = author_ids_by_name_.find(record.author_name);
+        domain::AuthorId author_id = author_it != author_ids_by_name_.end()
+                                     ? author_it->second
+                                     : domain::AuthorId::New();
+        if (author_it == author_ids_by_name_.end()) {
+            InsertAuthor(author_id, record.author_name);
+        }
+        InsertBook(domain::BookId::New(), {author_id, record.title, record.publication_year, record.tags});
+    }
+}
+
+/* Каталог выгружается под разделяемой блокировкой: visitor не должен обращаться к хранилищу на запись */
+void Storage::ExportBooks(const std::function<void(const domain::CatalogRecord&)>& visitor) const {
+    std::shared_lock lock{mutex_};
+    for (const auto& key : books_order_) {
+        const BookRecord& book = GetBook(key.id);
+        visitor({key.author_name, book.title, book.publication_year, book.tags});
+    }
+}
+
+/* ---------------------------- Indexes ---------------------------- */
+
+const Storage::BookRecord& Storage::GetBook(const domain::BookId& id) const {
+    auto it = books_.find(id);
+    if (it == books_.end()) {
+        throw std::runtime_error("No such book"s);
+    }
+    return it->second;
+}
+
+domain::Book Storage::MakeBook(const domain::BookId& id, const BookRecord& book, bool with_tags) const {
+    return {id, book.author_id, book.title, book.publication_year,
+            with_tags ? book.tags : std::vector<std::string>{}};
+}
+
+domain::BookWithAuthor Storage::MakeBookWithAuthor(const domain::BookId& id, const BookRecord& book,
+                                                   bool with_tags) const {
+    return {MakeBook(id, book, with_tags), author_names_.at(book.author_id)};
+}
+
+Storage::BookOrderKey Storage::MakeBookOrderKey(const domain::BookId& id, const BookRecord& book) const {
+    return {book.title, author_names_.at(book.author_id), book.publication_year, id};
+}
+
+void Storage::InsertAuthor(const domain::AuthorId& id, const std::string& name) {
+    if (!author_ids_by_name_.emplace(name, id).second) {
+        ViolateConstraint("Author already exists"s);
+    }
+    author_names_.emplace(id, name);
+    Log(AuthorInserted{id});
+}
+
+/* Имя автора входит в ключ сортировки списка книг, поэтому книги автора переиндексируются */
+void Storage::RenameAuthor(const domain::AuthorId& id, const std::string& new_name) {
+    std::string& name = author_names_.at(id);
+    if (name == new_name) {
+        return;
+    }
+    if (!author_ids_by_name_.emplace(new_name, id).second) {
+        ViolateConstraint("Author already exists"s);
+    }
+    Log(AuthorRenamed{id, name});
+    author_ids_by_name_.erase(name);
+    if (auto it = books_by_author_.find(id); it != books_by_author_.end()) {
+        for (const auto& key : it->second) {
+            const BookRecord& book = GetBook(key.id);
+            auto node = books_order_.extract({book.title, name, book.publication_year, key.id});
+            node.value().author_name = new_name;
+            books_order_.insert(std::move(node));
+        }
+    }
+    name = new_name;
+}
+
+void Storage::EraseAuthor(const domain::AuthorId& id) {
+    if (auto it = books_by_author_.find(id); it != books_by_author_.end()) {
+        std::vector<domain::BookId> book_ids;
+        book_ids.reserve(it->second.size());
+        for (const auto& key : it->second) {
+            book_ids.push_back(key.id);
+        }
+        for (const auto& book_id : book_ids) {
+            EraseBook(book_id);
+        }
+    }
+    auto name_it = author_names_.find(id);
+    Log(AuthorErased{id, name_it->second});
+    author_ids_by_name_.erase(name_it->second);
+    author_names_.erase(name_it);
+}
+
+void Storage::InsertBook(const domain::BookId& id, BookRecord book) {
+    std::sort(book.tags.begin(), book.tags.end());
+    auto [it, inserted] = books_.emplace(id, std::move(book));
+    if (!inserted) {
+        ViolateConstraint("Book already exists"s);
+    }
+    IndexBook(id, it->second);
+    Log(BookInserted{id});
+}
+
+void Storage::EraseBook(const domain::BookId& id) {
+    auto it = books_.find(id);
+    UnindexBook(id, it->second);
+    Log(BookErased{id, std::move(it->second)});
+    books_.erase(it);
+}
+
+void Storage::IndexBook(const domain::BookId& id, const BookRecord& book) {
+    books_order_.insert(MakeBookOrderKey(id, book));
+    books_by_author_[book.author_id].insert({book.publication_year, book.title, id});
+    books_by_title_[book.title].insert(id);
+    for (const auto& tag : book.tags) {
+        books_by_tag_[tag].insert(id);
+    }
+}
+
+void Storage::UnindexBook(const domain::BookId& id, const BookRecord& book) {
+    books_order_.erase(MakeBookOrderKey(id, book));
+
+    auto author_it = books_by_author_.find(book.author_id);
+    author_it->second.erase({book.publication_year, book.title, id});
+    if (author_it->second.empty()) {
+        books_by_author_.erase(author_it);
+    }
+
+    auto title_it = books_by_title_.find(book.title);
+    title_it->second.erase(id);
+    if (title_it->second.empty()) {
+        books_by_title_.erase(title_it);
+    }
+
+    for (const auto& tag : book.tags) {
+        auto tag_it = books_by_tag_.find(tag);
+        if (tag_it == books_by_tag_.end()) {
+            continue;  // повторяющийся тег уже снят с индекса
+        }
+        tag_it->second.erase(id);
+        if (tag_it->second.empty()) {
+            books_by_tag_.erase(tag_it);
+        }
+    }
+}
+
+/* ---------------------------- Undo log ---------------------------- */
+
+void Storage::StartUndoLog() {
+    std::unique_lock lock{mutex_};
+    if (!undo_logs_.try_emplace(std::this_thread::get_id()).second) {
+        throw std::logic_error("Batch has been started already"s);
+    }
+}
+
+void Storage::StartUndoCommand() {
+    std::unique_lock lock{mutex_};
+    auto it = undo_logs_.find(std::this_thread::get_id());
+    if (it == undo_logs_.end()) {
+        throw std::logic_error("Batch has not been started"s);
+    }
+    it->second.command_start = it->second.records.size();
+    it->second.command_failed = false;
+}
+
+bool Storage::EndUndoCommand() noexcept {
+    std::unique_lock lock{mutex_};
+    auto it = undo_logs_.find(std::this_thread::get_id());
+    if (it == undo_logs_.end() || !it->second.command_failed) {
+        return true;
+    }
+    Undo(it->second, it->second.command_start);
+    it->second.command_failed = false;
+    return false;
+}
+
+void Storage::DropUndoLog(bool undo) noexcept {
+    std::unique_lock lock{mutex_};
+    auto it = undo_logs_.find(std::this_thread::get_id());
+    if (it == undo_logs_.end()) {
+        return;
+    }
+    if (undo) {
+        Undo(it->second, 0);
+    }
+    undo_logs_.erase(it);
+}
+
+bool Storage::HasUndoLog() const noexcept {
+    std::shared_lock lock{mutex_};
+    return undo_logs_.contains(std::this_thread::get_id());
+}
+
+void Storage::Log(UndoRecord record) {
+    if (undoing_ || undo_logs_.empty()) {
+        return;
+    }
+    if (auto it = undo_logs_.find(std::this_thread::get_id()); it != undo_logs_.end()) {
+        it->second.records.push_back(std::move(record));
+    }
+}
+
+/* Изменение, которое после записи в журнал перекрыто изменением другого потока (например, имя
+ * удалённого автора уже занято), не отменяется: отмена не должна терять чужие изменения */
+void Storage::Undo(UndoLog& log, size_t from) noexcept {
+    undoing_ = true;
+    for (size_t i = log.records.size(); i > from; --i) {
+        try {
+            std::visit(
+                [this](auto& record) {
+                    using Record = std::decay_t<decltype(record)>;
+                    if constexpr (std::is_same_v<Record, AuthorInserted>) {
+                        if (author_names_.contains(record.id)) {
+                            EraseAuthor(record.id);
+                        }
+                    } else if constexpr (std::is_same_v<Record, AuthorRenamed>) {
+                        if (author_names_.contains(record.id)) {
+                            RenameAuthor(record.id, record.old_name);
+                        }
+                    } else if constexpr (std::is_same_v<Record, AuthorErased>) {
+                        InsertAuthor(record.id, record.name);
+                    } else if constexpr (std::is_same_v<Record, BookInserted>) {
+                        if (books_.contains(record.id)) {
+                            EraseBook(record.id);
+                        }
+                    } else if constexpr (std::is_same_v<Record, BookErased>) {
+                        if (author_names_.contains(record.book.author_id)) {
+                            InsertBook(record.id, std::move(record.book));
+                        }
+                    }
+                },
+                log.records[i - 1]);
+        } catch (const std::exception&) {
+        }
+    }
+    log.records.resize(from);
+    undoing_ = false;
+}
+
+void Storage::ViolateConstraint(const std::string& message) {
+    if (auto it = undo_logs_.find(std::this_thread::get_id()); it != undo_logs_.end()) {
+        it->second.command_failed = true;
+    }
+    throw std::runtime_error(message);
+}
+
+/* ---------------------------- Repositories ---------------------------- */
+
+void AuthorRepositoryImpl::Save(const domain::Author& author) {
+    storage_.SaveAuthor(author);
+}
+std::string AuthorRepositoryImpl::GetName(const domain::AuthorId& id) {
+    return storage_.GetAuthorName(id);
+}
+std::string AuthorRepositoryImpl::GetID(const std::string& name) {
+    return storage_.GetAuthorID(name);
+}
+std::vector<domain::Author> AuthorRepositoryImpl::Show() {
+    return storage_.ShowAuthors();
+}
+std::vector<domain::Author> AuthorRepositoryImpl::ShowPage(const std::optional<std::string>& after_name,
+                                                           size_t limit) {
+    return storage_.ShowAuthorsPage(after_name, limit);
+}
+void AuthorRepositoryImpl::Delete(const domain::AuthorId& id) {
+    storage_.DeleteAuthor(id);
+}
+void AuthorRepositoryImpl::Delete(const std::string& name) {
+    storage_.DeleteAuthor(name);
+}
+void AuthorRepositoryImpl::Edit(const domain::Author& new_author) {
+    storage_.EditAuthor(new_author);
+}
+void AuthorRepositoryImpl::Edit(const std::string& old_name, const std::string& new_name) {
+    storage_.EditAuthor(old_name, new_name);
+}
+
+void BookRepositoryImpl::Save(const domain::Book& book) {
+    storage_.SaveBook(book);
+}
+void BookRepositoryImpl::Delete(const domain::BookId& id) {
+    storage_.DeleteBook(id);
+}
+void BookRepositoryImpl::Edit(const domain::Book& new_book) {
+    storage_.EditBook(new_book);
+}
+std::vector<domain::BookSearchResult> BookRepositoryImpl::Search(
+        const std::string& query, const std::optional<domain::BookSearchCursor>& after, size_t limit) {
+    return storage_.SearchBooks(query, after, limit);
+}
+void BookRepositoryImpl::Import(const std::vector<domain::CatalogRecord>& records) {
+    storage_.ImportBooks(records);
+}
+void BookRepositoryImpl::Export(const std::function<void(const domain::CatalogRecord&)>& visitor) {
+    storage_.ExportBooks(visitor);
+}
+std::vector<domain::Book> BookRepositoryImpl::ShowAll() {
+    return storage_.ShowAllBooks();
+}
+std::vector<domain::Book> BookRepositoryImpl::ShowByAuthor(const domain::AuthorId& author_id) {
+    return storage_.ShowBooksByAuthor(author_id);
+}
+domain::Book BookRepositoryImpl::ShowInfoByID(const domain::BookId& book_id) {
+    return storage_.ShowBookInfoByID(book_id);
+}
+std::vector<domain::Book> BookRepositoryImpl::ShowInfoByTitle(const std::string& book_title) {
+    return storage_.ShowBookInfoByTitle(book_title);
+}
+std::vector<domain::BookWithAuthor> BookRepositoryImpl::ShowAllWithAuthors(bool with_tags) {
+    return storage_.ShowAllBooksWithAuthors(with_tags);
+}
+std::vector<domain::BookWithAuthor> BookRepositoryImpl::ShowPageWithAuthors(
+        const std::optional<domain::BookPageCursor>& after, size_t limit) {
+    return storage_.ShowBooksPage(after, limit);
+}
+std::vector<domain::BookWithAuthor> BookRepositoryImpl::ShowPageByTags(
+        const std::vector<std::string>& tags, domain::TagMatch match,
+        const std::optional<domain::BookPageCursor>& after, size_t limit) {
+    return storage_.ShowBooksPageByTags(tags, match, after, limit);
+}
+std::vector<domain::Book> BookRepositoryImpl::ShowPageByAuthor(
+        const domain::AuthorId& author_id, const std::optional<domain::AuthorBookPageCursor>& after, size_t limit) {
+    return storage_.ShowAuthorBooksPage(author_id, after, limit);
+}
+domain::BookWithAuthor BookRepositoryImpl::ShowInfoWithAuthorByID(const domain::BookId& book_id) {
+    return storage_.ShowBookWithAuthorByID(book_id);
+}
+std::vector<domain::BookWithAuthor> BookRepositoryImpl::ShowInfoWithAuthorByTitle(const std::string& book_title) {
+    return storage_.ShowBooksWithAuthorByTitle(book_title);
+}
+
+}  // namespace memory
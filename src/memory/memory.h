@@ -0,0 +1,300 @@
+/*
+ * Модуль хранения в памяти процесса. Реализует те же интерфейсы репозиториев,
+ * что и модуль postgres, с тем же порядком сортировки и каскадным удалением,
+ * но без СУБД: данные существуют, пока работает программа.
+ * Поиск выполняется по хеш-индексам (id автора и книги, название книги, автор книги, тег),
+ * порядок вывода списков поддерживается упорядоченными индексами.
+ * Строки сравниваются побайтно (аналог COLLATE "C" в PostgreSQL).
+ * Репозитории можно использовать из нескольких потоков одновременно.
+ * Группа команд (CommandBatchImpl) отменяется по журналу изменений открывшего её потока.
+ */
+#pragma once
+#include <boost/uuid/uuid_hash.hpp>
+#include <functional>
+#include <map>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+#include "../domain/author.h"
+
+namespace memory {
+
+class Storage {
+public:
+    /* ---------------------------- Author ---------------------------- */
+    void SaveAuthor(const domain::Author& author);
+    std::string GetAuthorName(const domain::AuthorId& id) const;
+    std::string GetAuthorID(const std::string& name) const;
+    std::vector<domain::Author> ShowAuthors() const;
+    std::vector<domain::Author> ShowAuthorsPage(const std::optional<std::string>& after_name, size_t limit) const;
+    void DeleteAuthor(const domain::AuthorId& id);
+    void DeleteAuthor(const std::string& name);
+    void EditAuthor(const domain::Author& new_author);
+    void EditAuthor(const std::string& old_name, const std::string& new_name);
+
+    /* ---------------------------- Book ---------------------------- */
+    void SaveBook(const domain::Book& book);
+    std::vector<domain::Book> ShowAllBooks() const;
+    std::vector<domain::BookWithAuthor> ShowAllBooksWithAuthors(bool with_tags) const;
+    std::vector<domain::BookWithAuthor> ShowBooksPage(const std::optional<domain::BookPageCursor>& after,
+                                                      size_t limit) const;
+    std::vector<domain::BookWithAuthor> ShowBooksPageByTags(const std::vector<std::string>& tags,
+                                                            domain::TagMatch match,
+                                                            const std::optional<domain::BookPageCursor>& after,
+                                                            size_t limit) const;
+    std::vector<domain::Book> ShowBooksByAuthor(const domain::AuthorId& author_id) const;
+    std::vector<domain::Book> ShowAuthorBooksPage(const domain::AuthorId& author_id,
+                                                  const std::optional<domain::AuthorBookPageCursor>& after,
+                                                  size_t limit) const;
+    domain::Book ShowBookInfoByID(const domain::BookId& book_id) const;
+    std::vector<domain::Book> ShowBookInfoByTitle(const std::string& book_title) const;
+    domain::BookWithAuthor ShowBookWithAuthorByID(const domain::BookId& book_id) const;
+    std::vector<domain::BookWithAuthor> ShowBooksWithAuthorByTitle(const std::string& book_title) const;
+    std::vector<domain::BookSearchResult> SearchBooks(const std::string& query,
+                                                      const std::optional<domain::BookSearchCursor>& after,
+                                                      size_t limit) const;
+    void DeleteBook(const domain::BookId& id);
+    void EditBook(const domain::Book& new_book);
+    void ImportBooks(const std::vector<domain::CatalogRecord>& records);
+    void ExportBooks(const std::function<void(const domain::CatalogRecord&)>& visitor) const;
+
+    /* ---------------------------- Undo log ---------------------------- */
+    /* Изменения вызывающего потока между StartUndoLog и DropUndoLog запоминаются в его журнале отмены
+     * (группа команд, см. CommandBatchImpl). Отмена возвращает только изменения этого потока */
+    void StartUndoLog();
+    /* Начало команды: её изменения отменяются в EndUndoCommand, если она нарушила ограничение
+     * хранилища (уникальность имени автора или id, ссылку книги на автора) */
+    void StartUndoCommand();
+    bool EndUndoCommand() noexcept;
+    /* undo - отменить все изменения журнала */
+    void DropUndoLog(bool undo) noexcept;
+    bool HasUndoLog() const noexcept;
+
+private:
+    using AuthorHasher = util::TaggedHasher<domain::AuthorId>;
+    using BookHasher = util::TaggedHasher<domain::BookId>;
+
+    struct BookRecord {
+        domain::AuthorId author_id;
+        std::string title;
+        uint64_t publication_year;
+        std::vector<std::string> tags;  // упорядочены по алфавиту, как ORDER BY tag в postgres
+    };
+
+    /* Порядок списка всех книг: название, имя автора, год публикации, id */
+    struct BookOrderKey {
+        std::string title;
+        std::string author_name;
+        uint64_t publication_year;
+        domain::BookId id;
+
+        bool operator<(const BookOrderKey& other) const;
+    };
+
+    /* Порядок книг автора: год публикации, название, id */
+    struct AuthorBookOrderKey {
+        uint64_t publication_year;
+        std::string title;
+        domain::BookId id;
+
+        bool operator<(const AuthorBookOrderKey& other) const;
+    };
+
+    /* Записи журнала отмены: каждая описывает изменение, которое нужно вернуть */
+    struct AuthorInserted {
+        domain::AuthorId id;
+    };
+    struct AuthorRenamed {
+        domain::AuthorId id;
+        std::string old_name;
+    };
+    struct AuthorErased {
+        domain::AuthorId id;
+        std::string name;
+    };
+    struct BookInserted {
+        domain::BookId id;
+    };
+    struct BookErased {
+        domain::BookId id;
+        BookRecord book;
+    };
+    using UndoRecord = std::variant<AuthorInserted, AuthorRenamed, AuthorErased, BookInserted, BookErased>;
+
+    struct UndoLog {
+        std::vector<UndoRecord> records;
+        size_t command_start = 0;
+        bool command_failed = false;
+    };
+
+    /* Вспомогательные методы вызываются под блокировкой mutex_ */
+    const BookRecord& GetBook(const domain::BookId& id) const;
+    domain::Book MakeBook(const domain::BookId& id, const BookRecord& book, bool with_tags) const;
+    domain::BookWithAuthor MakeBookWithAuthor(const domain::BookId& id, const BookRecord& book,
+                                              bool with_tags) const;
+    BookOrderKey MakeBookOrderKey(const domain::BookId& id, const BookRecord& book) const;
+    void InsertAuthor(const domain::AuthorId& id, const std::string& name);
+    void RenameAuthor(const domain::AuthorId& id, const std::string& new_name);
+    void EraseAuthor(const domain::AuthorId& id);
+    void InsertBook(const domain::BookId& id, BookRecord book);
+    void EraseBook(const domain::BookId& id);
+    void IndexBook(const domain::BookId& id, const BookRecord& book);
+    void UnindexBook(const domain::BookId& id, const BookRecord& book);
+    /* Запись в журнал отмены вызывающего потока, если он ведётся */
+    void Log(UndoRecord record);
+    /* Отменяет записи журнала log, начиная с from, в обратном порядке */
+    void Undo(UndoLog& log, size_t from) noexcept;
+    /* Нарушение ограничения хранилища отменяет изменения команды (см. StartUndoCommand) */
+    [[noreturn]] void ViolateConstraint(const std::string& message);
+
+    mutable std::shared_mutex mutex_;
+
+    std::unordered_map<domain::AuthorId, std::string, AuthorHasher> author_names_;
+    std::map<std::string, domain::AuthorId> author_ids_by_name_;  // также задаёт порядок вывода авторов
+
+    std::unordered_map<domain::BookId, BookRecord, BookHasher> books_;
+    std::unordered_map<std::string, std::unordered_set<domain::BookId, BookHasher>> books_by_title_;
+    std::unordered_map<std::string, std::unordered_set<domain::BookId, BookHasher>> books_by_tag_;
+    std::unordered_map<domain::AuthorId, std::set<AuthorBookOrderKey>, AuthorHasher> books_by_author_;
+    std::set<BookOrderKey> books_order_;
+
+    std::unordered_map<std::thread::id, UndoLog> undo_logs_;
+    bool undoing_ = false;  // изменения при отмене не записываются в журнал
+};
+
+class AuthorRepositoryImpl : public domain::AuthorRepository {
+public:
+    explicit AuthorRepositoryImpl(Storage& storage)
+        : storage_{storage} {
+    }
+
+    void Save(const domain::Author& author) override;
+    std::string GetName(const domain::AuthorId& id) override;
+    std::string GetID(const std::string& name) override;
+    std::vector<domain::Author> Show() override;
+    std::vector<domain::Author> ShowPage(const std::optional<std::string>& after_name, size_t limit) override;
+    void Delete(const domain::AuthorId& id) override;
+    void Delete(const std::string& name) override;
+    void Edit(const domain::Author& new_author) override;
+    void Edit(const std::string& old_name, const std::string& new_name) override;
+
+private:
+    Storage& storage_;
+};
+
+class BookRepositoryImpl : public domain::BookRepository {
+public:
+    explicit BookRepositoryImpl(Storage& storage)
+        : storage_{storage} {
+    }
+
+    void Save(const domain::Book& book) override;
+    std::vector<domain::Book> ShowAll() override;
+    std::vector<domain::BookWithAuthor> ShowAllWithAuthors(bool with_tags) override;
+    std::vector<domain::BookWithAuthor> ShowPageWithAuthors(const std::optional<domain::BookPageCursor>& after,
+                                                            size_t limit) override;
+    std::vector<domain::BookWithAuthor> ShowPageByTags(const std::vector<std::string>& tags, domain::TagMatch match,
+                                                       const std::optional<domain::BookPageCursor>& after,
+                                                       size_t limit) override;
+    std::vector<domain::Book> ShowPageByAuthor(const domain::AuthorId& author_id,
+                                               const std::optional<domain::AuthorBookPageCursor>& after,
+                                               size_t limit) override;
+    std::vector<domain::Book> ShowByAuthor(const domain::AuthorId& author_id) override;
+    domain::Book ShowInfoByID(const domain::BookId& book_id) override;
+    std::vector<domain::Book> ShowInfoByTitle(const std::string& book_title) override;
+    domain::BookWithAuthor ShowInfoWithAuthorByID(const domain::BookId& book_id) override;
+    std::vector<domain::BookWithAuthor> ShowInfoWithAuthorByTitle(const std::string& book_title) override;
+    std::vector<domain::BookSearchResult> Search(const std::string& query,
+                                                 const std::optional<domain::BookSearchCursor>& after,
+                                                 size_t limit) override;
+    void Delete(const domain::BookId& id) override;
+    void Edit(const domain::Book& new_book) override;
+    void Import(const std::vector<domain::CatalogRecord>& records) override;
+    void Export(const std::function<void(const domain::CatalogRecord&)>& visitor) override;
+
+private:
+    Storage& storage_;
+};
+
+/* Группа команд потока: его изменения записываются в журнал отмены хранилища, Rollback их отменяет.
+ * Команда, нарушившая ограничение хранилища, отменяется в EndCommand. Изменения других потоков,
+ * в том числе сделанные за время группы, отмена не затрагивает. Изоляции нет: другие потоки
+ * видят изменения группы до её фиксации */
+class CommandBatchImpl : public domain::CommandBatch {
+public:
+    explicit CommandBatchImpl(Storage& storage)
+        : storage_{storage} {
+    }
+
+    void Begin() override {
+        storage_.StartUndoLog();
+    }
+    void BeginCommand() override {
+        storage_.StartUndoCommand();
+    }
+    bool EndCommand() override {
+        return storage_.EndUndoCommand();
+    }
+    void Commit() override {
+        storage_.DropUndoLog(false);
+    }
+    void Rollback() noexcept override {
+        storage_.DropUndoLog(true);
+    }
+    bool IsOpen() const noexcept override {
+        return storage_.HasUndoLog();
+    }
+
+private:
+    Storage& storage_;
+};
+
+/* Каждая операция хранилища в памяти выполняется под его мьютексом и видит согласованное состояние,
+ * общий снимок нескольких операций не поддерживается */
+class ReadSnapshotImpl : public domain::ReadSnapshot {
+public:
+    void Begin() override {
+    }
+    void End() noexcept override {
+    }
+    void Release() noexcept override {
+    }
+    void Attach(std::thread::id) noexcept override {
+    }
+    void Detach() noexcept override {
+    }
+};
+
+class Database {
+public:
+    AuthorRepositoryImpl& GetAuthors() & {
+        return authors_;
+    }
+
+    BookRepositoryImpl& GetBooks() & {
+        return books_;
+    }
+
+    CommandBatchImpl& GetCommandBatch() & {
+        return batch_;
+    }
+
+    ReadSnapshotImpl& GetReadSnapshot() & {
+        return snapshot_;
+    }
+
+private:
+    Storage storage_;
+    CommandBatchImpl batch_{storage_};
+    ReadSnapshotImpl snapshot_;
+    AuthorRepositoryImpl authors_{storage_};
+    BookRepositoryImpl books_{storage_};
+};
+
+}  // namespace memory
@@ -12,9 +12,10 @@ Menu::Menu(std::istream& input, std::ostream& output)
 
 void Menu::AddAction(std::string action_name, std::string args, std::string description,
                      Handler handler) {
+    auto& metric = stats::GetMetric("command/" + action_name);
     if (!actions_
              .try_emplace(std::move(action_name), std::move(handler), std::move(args),
-                          std::move(description))
+                          std::move(description), &metric)
              .second) {
         throw std::invalid_argument("A command has been added already");
     }
@@ -23,13 +24,17 @@ void Menu::AddAction(std::string action_name, std::string args, std::string desc
 void Menu::Run() {
     std::string line;
     while (std::getline(input_, line)) {
-        std::istringstream cmd_stream{std::move(line)};
-        if (!ParseCommand(cmd_stream)) {
+        if (!Execute(std::move(line))) {
             break;
         }
     }
 }
 
+bool Menu::Execute(std::string line) {
+    std::istringstream cmd_stream{std::move(line)};
+    return ParseCommand(cmd_stream);
+}
+
 void Menu::ShowInstructions() const {
     if (actions_.empty()) {
         return;
@@ -69,7 +74,13 @@ bool Menu::ParseCommand(std::istream& input) {
         std::string cmd;
         if (input >> cmd) {
             if (const auto it = actions_.find(cmd); it != actions_.cend()) {
-                if (!it->second.handler(input)) {
+                stats::ScopedTimer timer{*it->second.metric};
+                command_failed_ = false;
+                const bool proceed = it->second.handler(input);
+                if (command_failed_) {
+                    timer.Fail();
+                }
+                if (!proceed) {
                     return false;
                 }
             } else {
@@ -4,6 +4,8 @@
 #include <map>
 #include <string>
 
+#include "../stats/stats.h"
+
 namespace menu {
 
 class Menu {
@@ -17,13 +19,23 @@ public:
 
     void Run();
 
+    /* Выполняет одну строку с командой. Возвращает false, если команда завершает работу (Exit) */
+    bool Execute(std::string line);
+
     void ShowInstructions() const;
 
+    /* Обработчик сообщает о неудаче выполняемой команды, которую он обработал сам
+     * (например, вывел сообщение об ошибке): она учитывается в числе ошибок команды */
+    void ReportFailure() noexcept {
+        command_failed_ = true;
+    }
+
 private:
     struct ActionInfo {
         Handler handler;
         std::string args;
         std::string description;
+        stats::Metric* metric;  // длительность выполнения команды
     };
 
     [[nodiscard]] bool ParseCommand(std::istream& input);
@@ -31,6 +43,7 @@ private:
     std::istream& input_;
     std::ostream& output_;
     std::map<std::string, ActionInfo> actions_;
+    bool command_failed_ = false;
 };
 
 }  // namespace menu
\ No newline at end of file
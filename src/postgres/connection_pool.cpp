@@ -0,0 +1,65 @@
+#include "connection_pool.h"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace postgres {
+
+ConnectionPool::ConnectionPool(size_t capacity, ConnectionFactory connection_factory)
+    : capacity_{capacity}
+    , connection_factory_{std::move(connection_factory)} {
+    if (capacity_ == 0) {
+        throw std::invalid_argument("Connection pool capacity must be positive");
+    }
+    idle_connections_.reserve(capacity_);
+}
+
+ConnectionPool::ConnectionWrapper ConnectionPool::GetConnection() {
+    ConnectionPtr conn;
+    {
+        std::unique_lock lock{mutex_};
+        cond_var_.wait(lock, [this] {
+            return used_connections_ < capacity_;
+        });
+        if (!idle_connections_.empty()) {
+            conn = std::move(idle_connections_.back());
+            idle_connections_.pop_back();
+        }
+        ++used_connections_;
+    }
+
+    /* Проверка соединения и переподключение выполняются без блокировки пула */
+    try {
+        if (!conn || !conn->is_open()) {
+            conn = connection_factory_();
+        }
+    } catch (...) {
+        {
+            std::lock_guard lock{mutex_};
+            --used_connections_;
+        }
+        cond_var_.notify_one();
+        throw;
+    }
+    return {std::move(conn), *this};
+}
+
+void ConnectionPool::DiscardIdle() noexcept {
+    std::vector<ConnectionPtr> discarded;
+    {
+        std::lock_guard lock{mutex_};
+        discarded.swap(idle_connections_);
+    }
+}
+
+void ConnectionPool::ReturnConnection(ConnectionPtr&& conn) {
+    {
+        std::lock_guard lock{mutex_};
+        assert(used_connections_ != 0);
+        idle_connections_.push_back(std::move(conn));
+        --used_connections_;
+    }
+    cond_var_.notify_one();
+}
+
+}  // namespace postgres
@@ -0,0 +1,84 @@
+/*
+ * Пул соединений с СУБД PostgreSQL.
+ * Соединения создаются по требованию (не более capacity) фабрикой соединений,
+ * выдаются во временное пользование (ConnectionWrapper) и возвращаются в пул
+ * при разрушении обёртки. Перед выдачей соединение проверяется; разорванное
+ * соединение пересоздаётся фабрикой.
+ * Соединение, разорванное сервером, считается открытым до первого запроса, поэтому
+ * получивший broken_connection вызывает DiscardIdle: после перезапуска сервера
+ * разорваны и простаивающие соединения, и они пересоздаются при следующей выдаче.
+ */
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <pqxx/connection>
+#include <vector>
+
+namespace postgres {
+
+class ConnectionPool {
+    using PoolType = ConnectionPool;
+    using ConnectionPtr = std::shared_ptr<pqxx::connection>;
+
+public:
+    using ConnectionFactory = std::function<ConnectionPtr()>;
+
+    class ConnectionWrapper {
+    public:
+        ConnectionWrapper(ConnectionPtr&& conn, PoolType& pool) noexcept
+            : conn_{std::move(conn)}
+            , pool_{&pool} {
+        }
+
+        ConnectionWrapper(const ConnectionWrapper&) = delete;
+        ConnectionWrapper& operator=(const ConnectionWrapper&) = delete;
+
+        ConnectionWrapper(ConnectionWrapper&&) = default;
+        ConnectionWrapper& operator=(ConnectionWrapper&&) = delete;
+
+        pqxx::connection& operator*() const& noexcept {
+            return *conn_;
+        }
+        pqxx::connection& operator*() const&& = delete;
+
+        pqxx::connection* operator->() const& noexcept {
+            return conn_.get();
+        }
+
+        ~ConnectionWrapper() {
+            if (conn_) {
+                pool_->ReturnConnection(std::move(conn_));
+            }
+        }
+
+    private:
+        ConnectionPtr conn_;
+        PoolType* pool_;
+    };
+
+    ConnectionPool(size_t capacity, ConnectionFactory connection_factory);
+
+    /* Ожидает свободное соединение, если все capacity соединений заняты */
+    ConnectionWrapper GetConnection();
+
+    /* Закрывает простаивающие соединения. Выданные соединения не затрагиваются */
+    void DiscardIdle() noexcept;
+
+    size_t GetCapacity() const noexcept {
+        return capacity_;
+    }
+
+private:
+    void ReturnConnection(ConnectionPtr&& conn);
+
+    const size_t capacity_;
+    ConnectionFactory connection_factory_;
+    std::mutex mutex_;
+    std::condition_variable cond_var_;
+    std::vector<ConnectionPtr> idle_connections_;
+    size_t used_connections_ = 0;
+};
+
+}  // namespace postgres
@@ -0,0 +1,176 @@
+#include "migrations.h"
+
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <pqxx/pqxx>
+#include <string_view>
+
+#include "../stats/stats.h"
+
+namespace postgres {
+
+using namespace std::literals;
+using pqxx::operator"" _zv;
+
+namespace {
+
+struct Migration {
+    int version;
+    std::string_view description;
+    pqxx::zview sql;
+};
+
+/* Миграции упорядочены по версии. Применённую миграцию менять нельзя - только добавлять новые */
+const Migration MIGRATIONS[]{
+    {1, "Authors, books and tags"sv, R"(
+CREATE TABLE IF NOT EXISTS authors (
+    id UUID CONSTRAINT author_id_constraint PRIMARY KEY,
+    name varchar(100) UNIQUE NOT NULL
+);
+CREATE TABLE IF NOT EXISTS books (
+    id UUID PRIMARY KEY,
+    author_id UUID NOT NULL,
+    title varchar(100) NOT NULL,
+    publication_year integer CHECK (publication_year > 0));
+CREATE TABLE IF NOT EXISTS book_tags (
+    book_id UUID,
+    tag varchar(30));
+)"_zv},
+    /* Книги удаляются вместе с автором, теги - вместе с книгой.
+     * Если в уже существующих таблицах есть "осиротевшие" строки, миграция завершается ошибкой с их числом.
+     * Удалить их разрешает параметр сеанса bookypedia.delete_orphans = on
+     * (например, PGOPTIONS='-c bookypedia.delete_orphans=on'); число удалённых строк выводится предупреждением */
+    {2, "Cascading foreign keys"sv, R"(
+DO $$
+DECLARE
+    delete_orphans boolean := coalesce(current_setting('bookypedia.delete_orphans', true), '') = 'on';
+    orphans bigint;
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM pg_constraint
+                   WHERE conname = 'books_author_id_fkey' AND conrelid = 'books'::regclass) THEN
+        SELECT count(*) INTO orphans FROM books WHERE author_id NOT IN (SELECT id FROM authors);
+        IF orphans > 0 AND NOT delete_orphans THEN
+            RAISE EXCEPTION '% books reference missing authors', orphans
+                USING HINT = 'Fix them or set bookypedia.delete_orphans = on to delete them';
+        END IF;
+        IF orphans > 0 THEN
+            DELETE FROM books WHERE author_id NOT IN (SELECT id FROM authors);
+            RAISE WARNING 'Deleted % books referencing missing authors', orphans;
+        END IF;
+        ALTER TABLE books ADD CONSTRAINT books_author_id_fkey
+            FOREIGN KEY (author_id) REFERENCES authors (id) ON DELETE CASCADE;
+    END IF;
+    IF NOT EXISTS (SELECT 1 FROM pg_constraint
+                   WHERE conname = 'book_tags_book_id_fkey' AND conrelid = 'book_tags'::regclass) THEN
+        SELECT count(*) INTO orphans FROM book_tags WHERE book_id NOT IN (SELECT id FROM books);
+        IF orphans > 0 AND NOT delete_orphans THEN
+            RAISE EXCEPTION '% book tags reference missing books', orphans
+                USING HINT = 'Fix them or set bookypedia.delete_orphans = on to delete them';
+        END IF;
+        IF orphans > 0 THEN
+            DELETE FROM book_tags WHERE book_id NOT IN (SELECT id FROM books);
+            RAISE WARNING 'Deleted % book tags referencing missing books', orphans;
+        END IF;
+        ALTER TABLE book_tags ADD CONSTRAINT book_tags_book_id_fkey
+            FOREIGN KEY (book_id) REFERENCES books (id) ON DELETE CASCADE;
+    END IF;
+END
+$$;
+)"_zv},
+    /* Книги автора (в порядке вывода), книги по названию, теги книги
+     * и обратный индекс тегов (ShowBooksByTag, ShowBooksByTags) */
+    {3, "Lookup indexes"sv, R"(
+CREATE INDEX IF NOT EXISTS books_author_id_idx ON books (author_id, publication_year, title);
+CREATE INDEX IF NOT EXISTS books_title_idx ON books (title);
+CREATE INDEX IF NOT EXISTS book_tags_book_id_idx ON book_tags (book_id, tag);
+CREATE INDEX IF NOT EXISTS book_tags_tag_idx ON book_tags (tag, book_id);
+)"_zv},
+    /* Нечёткий поиск (SearchBooks) */
+    {4, "Trigram search indexes"sv, R"(
+CREATE EXTENSION IF NOT EXISTS pg_trgm;
+CREATE INDEX IF NOT EXISTS books_title_trgm_idx ON books USING GIN (title gin_trgm_ops);
+CREATE INDEX IF NOT EXISTS authors_name_trgm_idx ON authors USING GIN (name gin_trgm_ops);
+CREATE INDEX IF NOT EXISTS book_tags_tag_trgm_idx ON book_tags USING GIN (tag gin_trgm_ops);
+)"_zv},
+};
+
+/* Ключ рекомендательной блокировки миграций: "bookyped" в ASCII */
+constexpr int64_t MIGRATION_LOCK_KEY = 0x626f6f6b79706564;
+
+stats::Metric& MIGRATE_SCHEMA = stats::GetMetric("db/MigrateSchema"sv);
+
+/* Текущая версия схемы; 0 - таблицы schema_version ещё нет */
+int ReadSchemaVersion(pqxx::connection& connection) {
+    pqxx::nontransaction read{connection};
+    try {
+        return read.query_value<std::optional<int>>("SELECT max(version) FROM schema_version"_zv).value_or(0);
+    } catch (const pqxx::undefined_table&) {
+        return 0;
+    }
+}
+
+/* Сеансовая блокировка: удерживается между транзакциями отдельных миграций */
+class MigrationLock {
+public:
+    explicit MigrationLock(pqxx::connection& connection)
+        : connection_{connection} {
+        pqxx::nontransaction{connection_}.exec_params("SELECT pg_advisory_lock($1)"_zv, MIGRATION_LOCK_KEY);
+    }
+
+    MigrationLock(const MigrationLock&) = delete;
+    MigrationLock& operator=(const MigrationLock&) = delete;
+
+    /* Если соединение разорвано, сервер уже снял блокировку вместе с сеансом */
+    ~MigrationLock() {
+        try {
+            pqxx::nontransaction{connection_}.exec_params("SELECT pg_advisory_unlock($1)"_zv, MIGRATION_LOCK_KEY);
+        } catch (const pqxx::failure&) {
+        }
+    }
+
+private:
+    pqxx::connection& connection_;
+};
+
+}  // namespace
+
+int GetLatestSchemaVersion() noexcept {
+    return MIGRATIONS[std::size(MIGRATIONS) - 1].version;
+}
+
+size_t MigrateSchema(pqxx::connection& connection) {
+    stats::ScopedTimer timer{MIGRATE_SCHEMA};
+    if (ReadSchemaVersion(connection) >= GetLatestSchemaVersion()) {
+        return 0;
+    }
+
+    MigrationLock lock{connection};
+    {
+        pqxx::work work{connection};
+        work.exec(R"(
+CREATE TABLE IF NOT EXISTS schema_version (
+    version integer PRIMARY KEY,
+    description text NOT NULL,
+    applied_at timestamptz NOT NULL DEFAULT now());
+)"_zv);
+        work.commit();
+    }
+    // Пока блокировка ожидалась, миграции мог применить другой экземпляр
+    const int current = ReadSchemaVersion(connection);
+    size_t applied = 0;
+    for (const auto& migration : MIGRATIONS) {
+        if (migration.version <= current) {
+            continue;
+        }
+        pqxx::work work{connection};
+        work.exec(migration.sql);
+        work.exec_params("INSERT INTO schema_version (version, description) VALUES ($1, $2)"_zv,
+                         migration.version, migration.description);
+        work.commit();
+        ++applied;
+    }
+    return applied;
+}
+
+}  // namespace postgres
@@ -0,0 +1,27 @@
+/*
+ * Версионные миграции схемы базы данных.
+ * Применённые миграции записываются в таблицу schema_version (номер, описание, время применения).
+ * При запуске MigrateSchema одним запросом без транзакции читает текущую версию схемы;
+ * если схема актуальна, больше ничего не выполняется и блокировки таблиц не берутся.
+ * Иначе берётся рекомендательная блокировка (pg_advisory_lock), под ней версия перечитывается
+ * и недостающие миграции применяются по порядку, каждая в своей транзакции вместе с записью
+ * в schema_version. Одновременно запущенные экземпляры приложения ждут друг друга на блокировке
+ * и не применяют одну миграцию дважды.
+ * Первые миграции повторяют прежнюю схему и написаны так, чтобы выполняться и на базе,
+ * созданной до появления schema_version. Данные миграции без явного разрешения не удаляют:
+ * ошибка миграции откатывает её транзакцию, и модуль хранения не создаётся.
+ * Время MigrateSchema учитывается в метрике db/MigrateSchema (команда Stats).
+ */
+#pragma once
+#include <cstddef>
+#include <pqxx/connection>
+
+namespace postgres {
+
+/* Версия схемы, которую ожидает приложение (номер последней миграции) */
+int GetLatestSchemaVersion() noexcept;
+
+/* Приводит схему к последней версии. Возвращает число применённых миграций */
+size_t MigrateSchema(pqxx::connection& connection);
+
+}  // namespace postgres
@@ -1,5 +1,13 @@
 #include "postgres.h"
+#include "migrations.h"
+#include "tagged_uuid_traits.h"
+#include "../stats/stats.h"
 
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <pqxx/pqxx>
 #include <pqxx/zview.hxx>
 #include <pqxx/result.hxx>
@@ -9,6 +17,388 @@ namespace postgres {
 using namespace std::literals;
 using pqxx::operator"" _zv;
 
+namespace {
+
+/* Теги книги приходят одним столбцом-массивом (ARRAY(SELECT tag ...)) */
+std::vector<std::string> TagsFromArrayParser(pqxx::array_parser&& parser) {
+    std::vector<std::string> tags;
+    for (;;) {
+        auto [juncture, value] = parser.get_next();
+        if (juncture == pqxx::array_parser::juncture::done) {
+            break;
+        }
+        if (juncture == pqxx::array_parser::juncture::string_value) {
+            tags.emplace_back(std::move(value));
+        }
+    }
+    return tags;
+}
+
+std::vector<std::string> TagsFromField(const pqxx::field& field) {
+    return TagsFromArrayParser(field.as_array());
+}
+
+/* В потоке COPY массив передаётся текстовым литералом вида {tag1,"tag 2"} */
+std::vector<std::string> TagsFromArrayLiteral(std::string_view literal) {
+    return TagsFromArrayParser(pqxx::array_parser{literal});
+}
+
+/* Строка результата: id, author_id, title, publication_year[, ...]
+ * tags_column - номер столбца с массивом тегов, если теги запрашивались */
+domain::Book BookFromRow(const pqxx::row& row, std::optional<pqxx::row::size_type> tags_column) {
+    std::vector<std::string> tags;
+    if (tags_column) {
+        tags = TagsFromField(row[*tags_column]);
+    }
+    return {row[0].as<domain::BookId>(),
+            row[1].as<domain::AuthorId>(),
+            row[2].as<std::string>(),
+            row[3].as<uint64_t>(),
+            std::move(tags)};
+}
+
+/* Строка результата: id, author_id, title, publication_year, author_name[, tags] */
+domain::BookWithAuthor BookWithAuthorFromRow(const pqxx::row& row, bool with_tags) {
+    return {BookFromRow(row, with_tags ? std::optional<pqxx::row::size_type>{5} : std::nullopt),
+            row[4].as<std::string>()};
+}
+
+/* ---------------------------- Prepared statements ---------------------------- */
+
+/* Имена подготовленных запросов. Запросы готовятся один раз при открытии соединения
+ * (см. PrepareStatements), далее UnitOfWork выполняет их через ExecPrepared */
+namespace statements {
+
+constexpr const char ADD_AUTHOR[]{"add_author"};
+constexpr const char DELETE_AUTHOR_BY_ID[]{"delete_author_by_id"};
+constexpr const char DELETE_AUTHOR_BY_NAME[]{"delete_author_by_name"};
+constexpr const char EDIT_AUTHOR_BY_ID[]{"edit_author_by_id"};
+constexpr const char EDIT_AUTHOR_BY_NAME[]{"edit_author_by_name"};
+constexpr const char GET_AUTHOR_NAME[]{"get_author_name"};
+constexpr const char GET_AUTHOR_ID[]{"get_author_id"};
+constexpr const char SHOW_AUTHORS[]{"show_authors"};
+constexpr const char SHOW_AUTHORS_FIRST_PAGE[]{"show_authors_first_page"};
+constexpr const char SHOW_AUTHORS_PAGE[]{"show_authors_page"};
+
+constexpr const char ADD_BOOK[]{"add_book"};
+constexpr const char DELETE_BOOK[]{"delete_book"};
+constexpr const char EDIT_BOOK[]{"edit_book"};
+constexpr const char SHOW_ALL_BOOKS[]{"show_all_books"};
+constexpr const char SHOW_BOOKS_BY_AUTHOR[]{"show_books_by_author"};
+constexpr const char SHOW_BOOK_BY_ID[]{"show_book_by_id"};
+constexpr const char SHOW_BOOKS_BY_TITLE[]{"show_books_by_title"};
+constexpr const char SHOW_ALL_BOOKS_WITH_AUTHORS[]{"show_all_books_with_authors"};
+constexpr const char SHOW_ALL_BOOKS_WITH_AUTHORS_AND_TAGS[]{"show_all_books_with_authors_and_tags"};
+constexpr const char SHOW_BOOK_WITH_AUTHOR_BY_ID[]{"show_book_with_author_by_id"};
+constexpr const char SHOW_BOOKS_WITH_AUTHOR_BY_TITLE[]{"show_books_with_author_by_title"};
+constexpr const char SHOW_BOOKS_FIRST_PAGE[]{"show_books_first_page"};
+constexpr const char SHOW_BOOKS_PAGE[]{"show_books_page"};
+constexpr const char SHOW_AUTHOR_BOOKS_FIRST_PAGE[]{"show_author_books_first_page"};
+constexpr const char SHOW_AUTHOR_BOOKS_PAGE[]{"show_author_books_page"};
+constexpr const char SHOW_BOOKS_WITH_ANY_TAG[]{"show_books_with_any_tag"};
+constexpr const char SHOW_BOOKS_WITH_ALL_TAGS[]{"show_books_with_all_tags"};
+constexpr const char SEARCH_BOOKS[]{"search_books"};
+constexpr const char CLEAR_IMPORT[]{"clear_import"};
+constexpr const char IMPORT_AUTHORS[]{"import_authors"};
+constexpr const char IMPORT_BOOKS[]{"import_books"};
+constexpr const char IMPORT_BOOK_TAGS[]{"import_book_tags"};
+
+struct Statement {
+    const char* name;
+    const char* sql;
+};
+
+constexpr Statement CATALOG[]{
+    {ADD_AUTHOR, R"(
+INSERT INTO authors (id, name) VALUES ($1, $2)
+ON CONFLICT (id) DO UPDATE SET name=$2;)"},
+    {DELETE_AUTHOR_BY_ID, R"(DELETE FROM authors WHERE id = $1;)"},
+    {DELETE_AUTHOR_BY_NAME, R"(DELETE FROM authors WHERE name = $1;)"},
+    {EDIT_AUTHOR_BY_ID, R"(UPDATE authors SET name = $1 WHERE id = $2;)"},
+    {EDIT_AUTHOR_BY_NAME, R"(UPDATE authors SET name = $1 WHERE name = $2;)"},
+    {GET_AUTHOR_NAME, R"(SELECT name FROM authors WHERE id = $1;)"},
+    {GET_AUTHOR_ID, R"(SELECT id FROM authors WHERE name = $1;)"},
+    {SHOW_AUTHORS, R"(SELECT id, name FROM authors ORDER BY name ASC;)"},
+    {SHOW_AUTHORS_FIRST_PAGE, R"(SELECT id, name FROM authors ORDER BY name ASC LIMIT $1;)"},
+    {SHOW_AUTHORS_PAGE, R"(SELECT id, name FROM authors WHERE name > $1 ORDER BY name ASC LIMIT $2;)"},
+
+    /* Книга и все её теги добавляются одним запросом: теги передаются массивом $5 */
+    {ADD_BOOK, R"(
+WITH book AS (
+    INSERT INTO books (id, author_id, title, publication_year) VALUES($1, $2, $3, $4)
+    RETURNING id
+)
+INSERT INTO book_tags (book_id, tag)
+SELECT book.id, tag FROM book, unnest($5::text[]) AS tag;)"},
+    {DELETE_BOOK, R"(DELETE FROM books WHERE id = $1;)"},
+    /* Все части запроса видят теги до изменения, поэтому удаляются только теги, которых нет в новом
+     * наборе $4, а добавляются только отсутствующие. Если набор тегов не изменился, book_tags не меняется */
+    {EDIT_BOOK, R"(
+WITH book AS (
+    UPDATE books SET title = $1, publication_year = $2 WHERE id = $3
+    RETURNING id
+), removed_tags AS (
+    DELETE FROM book_tags WHERE book_id = $3 AND tag <> ALL($4::text[])
+)
+INSERT INTO book_tags (book_id, tag)
+SELECT book.id, new_tags.tag
+FROM book, (SELECT DISTINCT unnest($4::text[]) AS tag) AS new_tags
+WHERE NOT EXISTS (SELECT 1 FROM book_tags WHERE book_tags.book_id = $3 AND book_tags.tag = new_tags.tag);)"},
+    {SHOW_ALL_BOOKS, R"(
+SELECT books.id, author_id, title, publication_year
+FROM books
+JOIN authors ON books.author_id = authors.id
+ORDER BY books.title, authors.name, books.publication_year;)"},
+    {SHOW_BOOKS_BY_AUTHOR, R"(
+SELECT id, author_id, title, publication_year
+FROM books
+WHERE author_id = $1
+ORDER BY publication_year, title;)"},
+    {SHOW_BOOK_BY_ID, R"(
+SELECT id, author_id, title, publication_year,
+       ARRAY(SELECT tag FROM book_tags WHERE book_tags.book_id = books.id ORDER BY tag)
+FROM books
+WHERE id = $1;)"},
+    {SHOW_BOOKS_BY_TITLE, R"(
+SELECT id, author_id, title, publication_year,
+       ARRAY(SELECT tag FROM book_tags WHERE book_tags.book_id = books.id ORDER BY tag)
+FROM books
+WHERE title = $1
+ORDER BY publication_year, title;)"},
+    {SHOW_ALL_BOOKS_WITH_AUTHORS, R"(
+SELECT books.id, books.author_id, books.title, books.publication_year, authors.name
+FROM books
+JOIN authors ON books.author_id = authors.id
+ORDER BY books.title, authors.name, books.publication_year;)"},
+    {SHOW_ALL_BOOKS_WITH_AUTHORS_AND_TAGS, R"(
+SELECT books.id, books.author_id, books.title, books.publication_year, authors.name,
+       ARRAY(SELECT tag FROM book_tags WHERE book_tags.book_id = books.id ORDER BY tag)
+FROM books
+JOIN authors ON books.author_id = authors.id
+ORDER BY books.title, authors.name, books.publication_year;)"},
+    {SHOW_BOOK_WITH_AUTHOR_BY_ID, R"(
+SELECT books.id, books.author_id, books.title, books.publication_year, authors.name,
+       ARRAY(SELECT tag FROM book_tags WHERE book_tags.book_id = books.id ORDER BY tag)
+FROM books
+JOIN authors ON books.author_id = authors.id
+WHERE books.id = $1;)"},
+    {SHOW_BOOKS_WITH_AUTHOR_BY_TITLE, R"(
+SELECT books.id, books.author_id, books.title, books.publication_year, authors.name,
+       ARRAY(SELECT tag FROM book_tags WHERE book_tags.book_id = books.id ORDER BY tag)
+FROM books
+JOIN authors ON books.author_id = authors.id
+WHERE books.title = $1
+ORDER BY authors.name, books.publication_year;)"},
+    /* Первая страница и последующие готовятся отдельно, чтобы у каждой был план с поиском по индексу.
+     * Условие books.title >= $1 дублирует сравнение кортежей и позволяет начать с нужного места индекса */
+    {SHOW_BOOKS_FIRST_PAGE, R"(
+SELECT books.id, books.author_id, books.title, books.publication_year, authors.name
+FROM books
+JOIN authors ON books.author_id = authors.id
+ORDER BY books.title, authors.name, books.publication_year, books.id
+LIMIT $1;)"},
+    {SHOW_BOOKS_PAGE, R"(
+SELECT books.id, books.author_id, books.title, books.publication_year, authors.name
+FROM books
+JOIN authors ON books.author_id = authors.id
+WHERE books.title >= $1
+  AND (books.title, authors.name, books.publication_year, books.id) > ($1, $2, $3, $4)
+ORDER BY books.title, authors.name, books.publication_year, books.id
+LIMIT $5;)"},
+    {SHOW_AUTHOR_BOOKS_FIRST_PAGE, R"(
+SELECT id, author_id, title, publication_year
+FROM books
+WHERE author_id = $1
+ORDER BY publication_year, title, id
+LIMIT $2;)"},
+    {SHOW_AUTHOR_BOOKS_PAGE, R"(
+SELECT id, author_id, title, publication_year
+FROM books
+WHERE author_id = $1
+  AND (publication_year, title, id) > ($2, $3, $4)
+ORDER BY publication_year, title, id
+LIMIT $5;)"},
+    /* Книги с тегами $1 выбираются по индексу book_tags_tag_idx (tag, book_id).
+     * Курсор $2-$5 - как у show_books_page, для первой страницы не задан */
+    {SHOW_BOOKS_WITH_ANY_TAG, R"(
+SELECT books.id, books.author_id, books.title, books.publication_year, authors.name
+FROM books
+JOIN authors ON books.author_id = authors.id
+WHERE books.id IN (SELECT book_id FROM book_tags WHERE tag = ANY($1::text[]))
+  AND ($2::text IS NULL
+       OR (books.title, authors.name, books.publication_year, books.id) > ($2, $3, $4, $5::uuid))
+ORDER BY books.title, authors.name, books.publication_year, books.id
+LIMIT $6;)"},
+    {SHOW_BOOKS_WITH_ALL_TAGS, R"(
+SELECT books.id, books.author_id, books.title, books.publication_year, authors.name
+FROM books
+JOIN authors ON books.author_id = authors.id
+WHERE books.id IN (SELECT book_id FROM book_tags WHERE tag = ANY($1::text[])
+                   GROUP BY book_id
+                   HAVING count(DISTINCT tag) = (SELECT count(DISTINCT required) FROM unnest($1::text[]) AS required))
+  AND ($2::text IS NULL
+       OR (books.title, authors.name, books.publication_year, books.id) > ($2, $3, $4, $5::uuid))
+ORDER BY books.title, authors.name, books.publication_year, books.id
+LIMIT $6;)"},
+    /* Совпадения ищутся оператором <% (pg_trgm) по GIN-индексам триграмм: запрос похож на фрагмент
+     * названия, имени автора или тега. Релевантность книги - лучшее из совпадений, совпадение с названием
+     * весит больше, чем с автором и тегом. Курсор $2, $3 (релевантность и id) не задан для первой страницы */
+    {SEARCH_BOOKS, R"(
+WITH matches AS (
+    SELECT id AS book_id, word_similarity($1, title)::double precision AS score
+    FROM books
+    WHERE $1 <% title
+    UNION ALL
+    SELECT books.id, 0.8 * word_similarity($1, authors.name)::double precision
+    FROM authors
+    JOIN books ON books.author_id = authors.id
+    WHERE $1 <% authors.name
+    UNION ALL
+    SELECT book_id, 0.6 * word_similarity($1, tag)::double precision
+    FROM book_tags
+    WHERE $1 <% tag
+), ranked AS (
+    SELECT book_id, max(score) AS rank FROM matches GROUP BY book_id
+)
+SELECT books.id, books.author_id, books.title, books.publication_year, authors.name,
+       ARRAY(SELECT tag FROM book_tags WHERE book_tags.book_id = books.id ORDER BY tag),
+       ranked.rank
+FROM ranked
+JOIN books ON books.id = ranked.book_id
+JOIN authors ON books.author_id = authors.id
+WHERE $2::double precision IS NULL
+   OR ranked.rank < $2
+   OR (ranked.rank = $2 AND books.id > $3::uuid)
+ORDER BY ranked.rank DESC, books.id
+LIMIT $4;)"},
+};
+
+/* Запросы импорта используют временную таблицу catalog_import, поэтому готовятся только
+ * на соединениях основного сервера (см. CreateImportTable) */
+constexpr Statement IMPORT[]{
+    /* Таблица пуста только в начале транзакции: в группе команд её строки остаются от прежних пакетов.
+     * TRUNCATE не оставляет мёртвых строк, которые до фиксации группы читались бы каждым пакетом */
+    {CLEAR_IMPORT, R"(TRUNCATE catalog_import;)"},
+    {IMPORT_AUTHORS, R"(
+INSERT INTO authors (id, name)
+SELECT DISTINCT ON (author_name) author_id, author_name FROM catalog_import
+ON CONFLICT (name) DO NOTHING;)"},
+    {IMPORT_BOOKS, R"(
+INSERT INTO books (id, author_id, title, publication_year)
+SELECT catalog_import.book_id, authors.id, catalog_import.title, catalog_import.publication_year
+FROM catalog_import
+JOIN authors ON authors.name = catalog_import.author_name;)"},
+    {IMPORT_BOOK_TAGS, R"(
+INSERT INTO book_tags (book_id, tag)
+SELECT book_id, unnest(tags) FROM catalog_import;)"},
+};
+
+/* Изменяющие запросы журнал медленных запросов не выполняет повторно, а запросы импорта
+ * не объясняет: на соединении журнала их временная таблица catalog_import пуста */
+SlowQueryLog::Explain ExplainOf(std::string_view statement) {
+    for (const auto& [name, sql] : IMPORT) {
+        if (statement == name) {
+            return SlowQueryLog::Explain::NONE;
+        }
+    }
+    constexpr const char* WRITES[]{ADD_AUTHOR,       DELETE_AUTHOR_BY_ID, DELETE_AUTHOR_BY_NAME,
+                                   EDIT_AUTHOR_BY_ID, EDIT_AUTHOR_BY_NAME, ADD_BOOK,
+                                   DELETE_BOOK,       EDIT_BOOK};
+    for (const char* name : WRITES) {
+        if (statement == name) {
+            return SlowQueryLog::Explain::PLAN;
+        }
+    }
+    return SlowQueryLog::Explain::ANALYZE;
+}
+
+}  // namespace statements
+
+/* Длительность операций UnitOfWork, включая ожидание соединения из пула (см. команду Stats) */
+namespace metrics {
+
+stats::Metric& ADD_AUTHOR = stats::GetMetric("db/AddAuthor"sv);
+stats::Metric& DELETE_AUTHOR_BY_ID = stats::GetMetric("db/DeleteAuthorById"sv);
+stats::Metric& DELETE_AUTHOR_BY_NAME = stats::GetMetric("db/DeleteAuthorByName"sv);
+stats::Metric& EDIT_AUTHOR_BY_ID = stats::GetMetric("db/EditAuthorById"sv);
+stats::Metric& EDIT_AUTHOR_BY_NAME = stats::GetMetric("db/EditAuthorByName"sv);
+stats::Metric& GET_AUTHOR_NAME = stats::GetMetric("db/GetAuthorName"sv);
+stats::Metric& GET_AUTHOR_ID = stats::GetMetric("db/GetAuthorID"sv);
+stats::Metric& SHOW_AUTHORS = stats::GetMetric("db/ShowAuthors"sv);
+stats::Metric& SHOW_AUTHORS_PAGE = stats::GetMetric("db/ShowAuthorsPage"sv);
+stats::Metric& ADD_BOOK = stats::GetMetric("db/AddBook"sv);
+stats::Metric& DELETE_BOOK = stats::GetMetric("db/DeleteBook"sv);
+stats::Metric& EDIT_BOOK = stats::GetMetric("db/EditBook"sv);
+stats::Metric& SHOW_ALL_BOOKS = stats::GetMetric("db/ShowAllBooks"sv);
+stats::Metric& SHOW_BOOKS_BY_AUTHOR = stats::GetMetric("db/ShowBooksByAuthor"sv);
+stats::Metric& SHOW_BOOKS_PAGE = stats::GetMetric("db/ShowBooksPage"sv);
+stats::Metric& SHOW_BOOKS_PAGE_BY_TAGS = stats::GetMetric("db/ShowBooksPageByTags"sv);
+stats::Metric& SHOW_AUTHOR_BOOKS_PAGE = stats::GetMetric("db/ShowAuthorBooksPage"sv);
+stats::Metric& SHOW_BOOK_INFO_BY_ID = stats::GetMetric("db/ShowBookInfoByID"sv);
+stats::Metric& SHOW_BOOK_INFO_BY_TITLE = stats::GetMetric("db/ShowBookInfoByTitle"sv);
+stats::Metric& SEARCH_BOOKS = stats::GetMetric("db/SearchBooks"sv);
+stats::Metric& IMPORT_BOOKS = stats::GetMetric("db/ImportBooks"sv);
+stats::Metric& EXPORT_BOOKS = stats::GetMetric("db/ExportBooks"sv);
+stats::Metric& SHOW_ALL_BOOKS_WITH_AUTHORS = stats::GetMetric("db/ShowAllBooksWithAuthors"sv);
+stats::Metric& SHOW_BOOK_WITH_AUTHOR_BY_ID = stats::GetMetric("db/ShowBookWithAuthorByID"sv);
+stats::Metric& SHOW_BOOKS_WITH_AUTHOR_BY_TITLE = stats::GetMetric("db/ShowBooksWithAuthorByTitle"sv);
+
+}  // namespace metrics
+
+/* Временная таблица для массового импорта (COPY) создаётся один раз на соединение,
+ * очищается при фиксации каждой транзакции и перед каждым импортом (см. CLEAR_IMPORT) */
+void CreateImportTable(pqxx::connection& connection) {
+    pqxx::nontransaction work{connection};
+    work.exec(R"(
+CREATE TEMP TABLE catalog_import (
+    book_id UUID,
+    author_id UUID,
+    author_name varchar(100),
+    title varchar(100),
+    publication_year integer,
+    tags varchar(30)[]
+) ON COMMIT DELETE ROWS;)"_zv);
+}
+
+/* Подготовка запросов на соединении */
+template <size_t N>
+void PrepareStatements(pqxx::connection& connection, const statements::Statement (&statements)[N]) {
+    for (const auto& [name, sql] : statements) {
+        connection.prepare(name, sql);
+    }
+}
+
+/* Соединения пула и журнала медленных запросов */
+ConnectionPool::ConnectionFactory MakeConnectionFactory(const std::string& db_url) {
+    return [db_url] {
+        auto conn = std::make_shared<pqxx::connection>(db_url);
+        CreateImportTable(*conn);
+        PrepareStatements(*conn, statements::CATALOG);
+        PrepareStatements(*conn, statements::IMPORT);
+        return conn;
+    };
+}
+
+/* Соединения реплик: на резервном сервере (hot standby) временные таблицы создавать нельзя,
+ * а запросы записи на реплике не выполняются, но подготовить их можно */
+ConnectionPool::ConnectionFactory MakeReplicaConnectionFactory(const std::string& replica_url) {
+    return [replica_url] {
+        auto conn = std::make_shared<pqxx::connection>(replica_url);
+        PrepareStatements(*conn, statements::CATALOG);
+        return conn;
+    };
+}
+
+template <typename T>
+std::optional<std::string> ParamToString(const T& value) {
+    if (pqxx::is_null(value)) {
+        return std::nullopt;
+    }
+    return pqxx::to_string(value);
+}
+
+}  // namespace
+
 /* ---------------------------- Author ---------------------------- */
 
 void AuthorRepositoryImpl::Save(const domain::Author& author) {
@@ -35,6 +425,10 @@ std::string AuthorRepositoryImpl::GetID(const std::string& name) {
 std::vector<domain::Author> AuthorRepositoryImpl::Show() {
     return unit_of_work_.ShowAuthors();
 }
+std::vector<domain::Author> AuthorRepositoryImpl::ShowPage(const std::optional<std::string>& after_name,
+                                                           size_t limit) {
+    return unit_of_work_.ShowAuthorsPage(after_name, limit);
+}
 
 /* ---------------------------- Book ---------------------------- */
 
@@ -47,6 +441,16 @@ void BookRepositoryImpl::Delete(const domain::BookId& id) {
 void BookRepositoryImpl::Edit(const domain::Book& new_book) {
     unit_of_work_.EditBook(new_book);
 }
+std::vector<domain::BookSearchResult> BookRepositoryImpl::Search(
+        const std::string& query, const std::optional<domain::BookSearchCursor>& after, size_t limit) {
+    return unit_of_work_.SearchBooks(query, after, limit);
+}
+void BookRepositoryImpl::Import(const std::vector<domain::CatalogRecord>& records) {
+    unit_of_work_.ImportBooks(records);
+}
+void BookRepositoryImpl::Export(const std::function<void(const domain::CatalogRecord&)>& visitor) {
+    unit_of_work_.ExportBooks(visitor);
+}
 std::vector<domain::Book> BookRepositoryImpl::ShowAll() {
     return unit_of_work_.ShowAllBooks();
 }
@@ -59,243 +463,695 @@ domain::Book BookRepositoryImpl::ShowInfoByID(const domain::BookId& book_id) {
 std::vector<domain::Book> BookRepositoryImpl::ShowInfoByTitle(const std::string& book_title) {
     return unit_of_work_.ShowBookInfoByTitle(book_title);
 }
+std::vector<domain::BookWithAuthor> BookRepositoryImpl::ShowAllWithAuthors(bool with_tags) {
+    return unit_of_work_.ShowAllBooksWithAuthors(with_tags);
+}
+std::vector<domain::BookWithAuthor> BookRepositoryImpl::ShowPageWithAuthors(
+        const std::optional<domain::BookPageCursor>& after, size_t limit) {
+    return unit_of_work_.ShowBooksPage(after, limit);
+}
+std::vector<domain::BookWithAuthor> BookRepositoryImpl::ShowPageByTags(
+        const std::vector<std::string>& tags, domain::TagMatch match,
+        const std::optional<domain::BookPageCursor>& after, size_t limit) {
+    return unit_of_work_.ShowBooksPageByTags(tags, match, after, limit);
+}
+std::vector<domain::Book> BookRepositoryImpl::ShowPageByAuthor(
+        const domain::AuthorId& author_id, const std::optional<domain::AuthorBookPageCursor>& after, size_t limit) {
+    return unit_of_work_.ShowAuthorBooksPage(author_id, after, limit);
+}
+domain::BookWithAuthor BookRepositoryImpl::ShowInfoWithAuthorByID(const domain::BookId& book_id) {
+    return unit_of_work_.ShowBookWithAuthorByID(book_id);
+}
+std::vector<domain::BookWithAuthor> BookRepositoryImpl::ShowInfoWithAuthorByTitle(const std::string& book_title) {
+    return unit_of_work_.ShowBooksWithAuthorByTitle(book_title);
+}
 
 /* ---------------------------- Database ---------------------------- */
 
-Database::Database(pqxx::connection connection)
-    : connection_{std::move(connection)} {
-    pqxx::work work{connection_};
-    work.exec(R"(
-CREATE TABLE IF NOT EXISTS authors (
-    id UUID CONSTRAINT author_id_constraint PRIMARY KEY,
-    name varchar(100) UNIQUE NOT NULL
-);
-)"_zv);
-    work.exec(R"(
-CREATE TABLE IF NOT EXISTS books (
-    id UUID PRIMARY KEY,
-    author_id UUID NOT NULL,
-    title varchar(100) NOT NULL,
-    publication_year integer CHECK (publication_year > 0));
-    )"_zv);
-    work.exec(R"(
-CREATE TABLE IF NOT EXISTS book_tags (
-    book_id UUID,
-    tag varchar(30));
-    )"_zv);
-    work.commit();
+Database::Database(const std::string& db_url, size_t pool_size, SlowQueryLogConfig slow_query_config,
+                   ReplicaSetConfig replica_config)
+    : pool_{pool_size, MakeConnectionFactory(db_url)}
+    , replicas_{std::move(replica_config), pool_size, MakeReplicaConnectionFactory}
+    , slow_log_{std::move(slow_query_config), MakeConnectionFactory(db_url)} {
+    /* Схема обновляется до первого соединения пула: запросы готовятся на существующих таблицах */
+    pqxx::connection connection{db_url};
+    MigrateSchema(connection);
+}
+
+/* ---------------------------- Command Batch ---------------------------- */
+
+CommandBatchImpl::CommandBatchImpl(ConnectionPool& pool, ReplicaSet& replicas)
+    : pool_{pool}
+    , replicas_{replicas} {
+}
+
+/* Незафиксированные группы откатываются при разрушении их транзакций */
+CommandBatchImpl::~CommandBatchImpl() = default;
+
+void CommandBatchImpl::Begin() {
+    if (FindGroup()) {
+        throw std::logic_error("Batch has been started already"s);
+    }
+    Group group;
+    // BEGIN ещё ничего не изменил: на разорванном соединении он повторяется один раз на новом
+    for (bool retry = true;; retry = false) {
+        group.connection.emplace(pool_.GetConnection());
+        try {
+            group.work = std::make_unique<pqxx::work>(**group.connection);
+            break;
+        } catch (const pqxx::broken_connection&) {
+            group.connection.reset();
+            pool_.DiscardIdle();
+            if (!retry) {
+                throw;
+            }
+        }
+    }
+    std::lock_guard lock{mutex_};
+    groups_.emplace(std::this_thread::get_id(), std::move(group));
+}
+
+void CommandBatchImpl::BeginCommand() {
+    Group* group = FindGroup();
+    if (!group) {
+        throw std::logic_error("Batch has not been started"s);
+    }
+    group->command.reset();
+    group->command = std::make_unique<pqxx::subtransaction>(*group->work);
+    group->command_failed = false;
+}
+
+bool CommandBatchImpl::EndCommand() {
+    Group* group = FindGroup();
+    if (!group || !group->command) {
+        return true;
+    }
+    const bool succeeded = !group->command_failed;
+    if (succeeded) {
+        group->command->commit();
+    } else {
+        group->command->abort();
+    }
+    group->command.reset();
+    group->command_failed = false;
+    return succeeded;
+}
+
+void CommandBatchImpl::Commit() {
+    Group* group = FindGroup();
+    if (!group) {
+        return;
+    }
+    try {
+        EndCommand();
+        ReplicaSet::WriteMark write_mark{replicas_};
+        group->work->commit();
+    } catch (...) {
+        Rollback();
+        throw;
+    }
+    Rollback();
+}
+
+/* Транзакция группы откатывается при разрушении, уже вне блокировки. После фиксации
+ * Rollback только возвращает соединение группы в пул */
+void CommandBatchImpl::Rollback() noexcept {
+    std::unique_lock lock{mutex_};
+    auto group = groups_.extract(std::this_thread::get_id());
+    lock.unlock();
+}
+
+bool CommandBatchImpl::IsOpen() const noexcept {
+    std::lock_guard lock{mutex_};
+    return groups_.contains(std::this_thread::get_id());
+}
+
+pqxx::transaction_base* CommandBatchImpl::GetTransaction() noexcept {
+    Group* group = FindGroup();
+    if (!group) {
+        return nullptr;
+    }
+    return group->command ? static_cast<pqxx::transaction_base*>(group->command.get()) : group->work.get();
+}
+
+void CommandBatchImpl::MarkFailed() noexcept {
+    if (Group* group = FindGroup()) {
+        group->command_failed = true;
+    }
+}
+
+/* Группу потока меняет только он сам, поэтому ссылка на неё используется без блокировки */
+CommandBatchImpl::Group* CommandBatchImpl::FindGroup() noexcept {
+    std::lock_guard lock{mutex_};
+    const auto it = groups_.find(std::this_thread::get_id());
+    return it == groups_.end() ? nullptr : &it->second;
+}
+
+/* ---------------------------- Read Snapshot ---------------------------- */
+
+ReadSnapshotImpl::ReadSnapshotImpl(ConnectionPool& pool, ReplicaSet& replicas)
+    : pool_{pool}
+    , replicas_{replicas} {
+}
+
+ReadSnapshotImpl::~ReadSnapshotImpl() = default;
+
+void ReadSnapshotImpl::Begin() {
+    std::lock_guard lock{mutex_};
+    if (!snapshots_.emplace(std::this_thread::get_id(), std::make_shared<Snapshot>()).second) {
+        throw std::logic_error("Snapshot has been started already"s);
+    }
+}
+
+/* Присоединённые потоки, уже получившие снимок, дочитывают в нём: End дожидается их чтения */
+void ReadSnapshotImpl::End() noexcept {
+    if (auto snapshot = Extract()) {
+        std::lock_guard lock{snapshot->mutex};
+        snapshot->Close();
+        snapshot->open = false;
+    }
+}
+
+/* Снимок остаётся открытым: Acquire начнёт новую транзакцию при следующем чтении */
+void ReadSnapshotImpl::Release() noexcept {
+    std::shared_ptr<Snapshot> snapshot;
+    {
+        std::lock_guard lock{mutex_};
+        if (auto it = snapshots_.find(std::this_thread::get_id()); it != snapshots_.end()) {
+            snapshot = it->second;
+        }
+    }
+    if (snapshot) {
+        std::lock_guard lock{snapshot->mutex};
+        snapshot->Close();
+        snapshot->failed = false;
+    }
+}
+
+void ReadSnapshotImpl::Attach(std::thread::id owner) noexcept {
+    std::lock_guard lock{mutex_};
+    attached_.insert_or_assign(std::this_thread::get_id(), owner);
+}
+
+void ReadSnapshotImpl::Detach() noexcept {
+    std::lock_guard lock{mutex_};
+    attached_.erase(std::this_thread::get_id());
+}
+
+/* Снимок берётся на реплике, если чтение сейчас направляется на неё (см. ReplicaSet).
+ * Если транзакцию начать не удалось, чтения выполняются без снимка */
+pqxx::transaction_base* ReadSnapshotImpl::Acquire(Lease& lease) {
+    lease.snapshot = Find();
+    if (!lease.snapshot) {
+        return nullptr;
+    }
+    lease.lock = std::unique_lock{lease.snapshot->mutex};
+    Snapshot& snapshot = *lease.snapshot;
+    if (snapshot.open && !snapshot.failed && !snapshot.transaction) {
+        try {
+            if (auto* replica = replicas_.Select()) {
+                try {
+                    snapshot.connection.emplace(replica->GetPool().GetConnection());
+                } catch (const pqxx::broken_connection&) {
+                    replicas_.MarkFailed(*replica);
+                }
+            }
+            if (!snapshot.connection) {
+                snapshot.connection.emplace(pool_.GetConnection());
+            }
+            snapshot.transaction = std::make_unique<Transaction>(**snapshot.connection);
+        } catch (const pqxx::failure&) {
+            MarkFailed(lease);
+        }
+    }
+    if (!snapshot.transaction || snapshot.failed) {
+        lease.lock.unlock();
+        return nullptr;
+    }
+    return snapshot.transaction.get();
+}
+
+void ReadSnapshotImpl::MarkFailed(Lease& lease) noexcept {
+    lease.snapshot->failed = true;
+    lease.snapshot->Close();
+}
+
+/* Транзакция только для чтения: откат (при разрушении) равноценен фиксации */
+void ReadSnapshotImpl::Snapshot::Close() noexcept {
+    transaction.reset();
+    connection.reset();
+}
+
+std::shared_ptr<ReadSnapshotImpl::Snapshot> ReadSnapshotImpl::Find() const {
+    std::lock_guard lock{mutex_};
+    if (snapshots_.empty()) {
+        return nullptr;
+    }
+    auto owner = std::this_thread::get_id();
+    if (auto it = attached_.find(owner); it != attached_.end()) {
+        owner = it->second;
+    }
+    auto it = snapshots_.find(owner);
+    return it != snapshots_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<ReadSnapshotImpl::Snapshot> ReadSnapshotImpl::Extract() noexcept {
+    std::lock_guard lock{mutex_};
+    auto node = snapshots_.extract(std::this_thread::get_id());
+    return node ? std::move(node.mapped()) : nullptr;
 }
 
 /* ---------------------------- Unit Of Work ---------------------------- */
 
+/* Операция в собственной транзакции Transaction на выданном соединении */
+template <typename Transaction, typename Operation>
+auto RunInTransaction(const ConnectionPool::ConnectionWrapper& connection, Operation& operation) {
+    Transaction transaction{*connection};
+    if constexpr (std::is_void_v<decltype(operation(transaction))>) {
+        operation(transaction);
+        transaction.commit();
+    } else {
+        auto result = operation(transaction);
+        transaction.commit();
+        return result;
+    }
+}
+
+/* Повторить можно только чтение, возвращающее результат целиком: запись могла быть выполнена,
+ * а чтение с обходчиком (ExportBooks) - уже передать ему часть строк */
+template <typename Transaction, typename Operation>
+constexpr bool IsRetryable() {
+    return std::is_same_v<Transaction, pqxx::read_transaction>
+           && !std::is_void_v<std::invoke_result_t<Operation&, pqxx::transaction_base&>>;
+}
+
+/* Операция в собственной транзакции на соединении из пула pool. Разорванное соединение
+ * (например, после перезапуска сервера) закрывает и простаивающие соединения пула,
+ * повторяемая операция (IsRetryable) выполняется ещё раз на новом соединении */
+template <typename Transaction, typename Operation>
+auto RunOnPool(ConnectionPool& pool, Operation& operation) {
+    try {
+        return RunInTransaction<Transaction>(pool.GetConnection(), operation);
+    } catch (const pqxx::broken_connection&) {
+        pool.DiscardIdle();
+        if constexpr (!IsRetryable<Transaction, Operation>()) {
+            throw;
+        }
+    }
+    return RunInTransaction<Transaction>(pool.GetConnection(), operation);
+}
+
+/* Операция выполняется в транзакции группы команд, если группу открыл текущий поток,
+ * иначе - в собственной транзакции Transaction на соединении из пула.
+ * Ошибка сервера внутри группы отмечает команду как неудачную: её изменения будут отменены.
+ * Ошибки клиента (например, unexpected_rows ненайденного автора) транзакцию не прерывают,
+ * и команда, обработавшая такую ошибку сама, продолжается (AddBook с новым автором).
+ * Чтение (pqxx::read_transaction) вне группы выполняется в открытом снимке (см. ReadSnapshotImpl),
+ * без снимка - на реплике, если она выбрана (см. ReplicaSet).
+ * Если к реплике не удалось подключиться, чтение выполняется на основном сервере, туда же
+ * переходит повторяемое чтение (IsRetryable) при разрыве соединения с репликой */
+template <typename Transaction, typename Operation>
+auto UnitOfWork::Execute(stats::Metric& metric, Operation&& operation) {
+    stats::ScopedTimer timer{metric};
+    if (auto* batch_transaction = batch_.GetTransaction()) {
+        try {
+            return operation(*batch_transaction);
+        } catch (const pqxx::sql_error&) {
+            batch_.MarkFailed();
+            throw;
+        }
+    }
+    if constexpr (std::is_same_v<Transaction, pqxx::read_transaction>) {
+        ReadSnapshotImpl::Lease lease;
+        if (auto* snapshot_transaction = snapshot_.Acquire(lease)) {
+            try {
+                return operation(*snapshot_transaction);
+            } catch (const pqxx::failure&) {
+                ReadSnapshotImpl::MarkFailed(lease);
+                throw;
+            }
+        }
+        if (auto* replica = replicas_.Select()) {
+            std::optional<ConnectionPool::ConnectionWrapper> connection;
+            try {
+                connection.emplace(replica->GetPool().GetConnection());
+            } catch (const pqxx::broken_connection&) {
+                replicas_.MarkFailed(*replica);
+            }
+            if (connection) {
+                try {
+                    ReplicaSet::LatencyProbe probe{*replica};
+                    return RunInTransaction<Transaction>(*connection, operation);
+                } catch (const pqxx::broken_connection&) {
+                    replicas_.MarkFailed(*replica);
+                    replica->GetPool().DiscardIdle();
+                    if constexpr (!IsRetryable<Transaction, Operation>()) {
+                        throw;
+                    }
+                }
+            }
+        }
+        return RunOnPool<Transaction>(pool_, operation);
+    } else {
+        ReplicaSet::WriteMark write_mark{replicas_};
+        return RunOnPool<Transaction>(pool_, operation);
+    }
+}
+
+/* Параметры переводятся в текст только для медленного запроса, уже после его выполнения */
+template <typename... Args>
+pqxx::result UnitOfWork::ExecPrepared(pqxx::transaction_base& transaction, const char* statement,
+                                      const Args&... args) {
+    const auto start = std::chrono::steady_clock::now();
+    pqxx::result res = transaction.exec_prepared(statement, args...);
+    const auto duration = std::chrono::steady_clock::now() - start;
+    if (slow_log_.IsSlow(duration)) {
+        slow_log_.Submit({statement, {ParamToString(args)...}, duration,
+                          res.columns() == 0 ? static_cast<size_t>(res.affected_rows()) : res.size(),
+                          statements::ExplainOf(statement)});
+    }
+    return res;
+}
+
+template <typename... Args>
+pqxx::result UnitOfWork::ExecPrepared0(pqxx::transaction_base& transaction, const char* statement,
+                                       const Args&... args) {
+    pqxx::result res = ExecPrepared(transaction, statement, args...);
+    if (!res.empty()) {
+        throw pqxx::unexpected_rows{"Expected no rows from query "s + statement + ", got "s
+                                    + std::to_string(res.size())};
+    }
+    return res;
+}
+
+template <typename... Args>
+pqxx::row UnitOfWork::ExecPrepared1(pqxx::transaction_base& transaction, const char* statement,
+                                    const Args&... args) {
+    pqxx::result res = ExecPrepared(transaction, statement, args...);
+    if (res.size() != 1) {
+        throw pqxx::unexpected_rows{"Expected 1 row from query "s + statement + ", got "s
+                                    + std::to_string(res.size())};
+    }
+    return res[0];
+}
+
 void UnitOfWork::AddAuthor(const domain::Author& author) {
-    pqxx::work work{connection_};
-    work.exec_params(
-        R"(
-INSERT INTO authors (id, name) VALUES ($1, $2)
-ON CONFLICT (id) DO UPDATE SET name=$2;
-)"_zv, author.GetId().ToString(), author.GetName());
-    work.commit();
+    Execute<pqxx::work>(metrics::ADD_AUTHOR, [&](pqxx::transaction_base& work) {
+        ExecPrepared(work, statements::ADD_AUTHOR, author.GetId(), author.GetName());
+    });
 }
 
+/* Книги автора и их теги удаляются каскадно (ON DELETE CASCADE) */
 void UnitOfWork::DeleteAuthor(const domain::AuthorId& id){
-    pqxx::work work{connection_};
-    work.exec(R"(START TRANSACTION;)"_zv);
-    work.exec_params(R"(
-DELETE FROM book_tags
-WHERE book_id IN (
-    SELECT id FROM books
-    WHERE author_id = $1
-);)"_zv, id.ToString());
-    work.exec_params(R"(DELETE FROM books WHERE author_id = $1;)"_zv, id.ToString());
-    work.exec_params(R"(DELETE FROM authors WHERE id = $1;)"_zv, id.ToString());
-    work.exec(R"(COMMIT;)"_zv);
-    work.commit();
+    Execute<pqxx::work>(metrics::DELETE_AUTHOR_BY_ID, [&](pqxx::transaction_base& work) {
+        pqxx::result res = ExecPrepared0(work, statements::DELETE_AUTHOR_BY_ID, id);
+        if (res.affected_rows() == 0) {
+            throw std::runtime_error("No such author"s);
+        }
+    });
 }
 void UnitOfWork::DeleteAuthor(const std::string& name){
-    pqxx::work work{connection_};
-    work.exec(R"(START TRANSACTION;)"_zv);
-    work.exec_params(R"(
-DELETE FROM book_tags
-WHERE book_id IN (
-    SELECT id FROM books
-    WHERE author_id IN (
-        SELECT id FROM authors
-        WHERE name = $1
-    )
-);)"_zv, name);
-    work.exec_params(R"(
-DELETE FROM books
-WHERE author_id IN (
-    SELECT id FROM authors
-    WHERE name = $1
-);)"_zv, name);
-    pqxx::result res = work.exec_params0(R"(DELETE FROM authors WHERE name = $1;)"_zv, name);
-    if (res.affected_rows() == 0) {
-        throw std::runtime_error("No such author"s);
-    }
-    work.exec(R"(COMMIT;)"_zv);
-    work.commit();
+    Execute<pqxx::work>(metrics::DELETE_AUTHOR_BY_NAME, [&](pqxx::transaction_base& work) {
+        pqxx::result res = ExecPrepared0(work, statements::DELETE_AUTHOR_BY_NAME, name);
+        if (res.affected_rows() == 0) {
+            throw std::runtime_error("No such author"s);
+        }
+    });
 }
 
 void UnitOfWork::EditAuthor(const domain::Author& new_author){
-    pqxx::work work{connection_};
-    work.exec_params(R"(
-UPDATE authors SET name = $1 WHERE id = $2;
-    )"_zv, new_author.GetName(), new_author.GetId().ToString());
-    work.commit();
+    Execute<pqxx::work>(metrics::EDIT_AUTHOR_BY_ID, [&](pqxx::transaction_base& work) {
+        ExecPrepared(work, statements::EDIT_AUTHOR_BY_ID, new_author.GetName(), new_author.GetId());
+    });
 }
 void UnitOfWork::EditAuthor(const std::string& old_name, const std::string& new_name) {
-    pqxx::work work{connection_};
-    work.exec_params(R"(
-UPDATE authors SET name = $1 WHERE name = $2;
-    )"_zv, new_name, old_name);
-    work.commit();
+    Execute<pqxx::work>(metrics::EDIT_AUTHOR_BY_NAME, [&](pqxx::transaction_base& work) {
+        ExecPrepared(work, statements::EDIT_AUTHOR_BY_NAME, new_name, old_name);
+    });
 }
 
 std::string UnitOfWork::GetAuthorName(const domain::AuthorId& id) {
-    pqxx::read_transaction r(connection_);
-    std::string query_str = "SELECT name FROM authors WHERE id = '" +
-                            id.ToString() + "';";
-    return r.query_value<std::string>(pqxx::zview(query_str));
+    return Execute<pqxx::read_transaction>(metrics::GET_AUTHOR_NAME, [&](pqxx::transaction_base& r) {
+        return ExecPrepared1(r, statements::GET_AUTHOR_NAME, id)[0].as<std::string>();
+    });
 }
 std::string UnitOfWork::GetAuthorID(const std::string& name) {
-    pqxx::read_transaction r(connection_);
-    std::string query_str = "SELECT id FROM authors WHERE name = '" + name + "';";
-    return r.query_value<std::string>(pqxx::zview(query_str));
+    return Execute<pqxx::read_transaction>(metrics::GET_AUTHOR_ID, [&](pqxx::transaction_base& r) {
+        return ExecPrepared1(r, statements::GET_AUTHOR_ID, name)[0].as<std::string>();
+    });
 }
 std::vector<domain::Author> UnitOfWork::ShowAuthors() {
-    std::vector<domain::Author> authors;
-    pqxx::read_transaction r(connection_);
-    const auto get_authors_sql = R"(SELECT id, name FROM authors ORDER BY name ASC;)"_zv;
-
-    for (auto [id, author] : r.query<std::string, std::string>(get_authors_sql)) {
-        authors.emplace_back(domain::AuthorId::FromString(std::move(id)),
-                             std::move(author));
-    }
-    return authors;
+    return Execute<pqxx::read_transaction>(metrics::SHOW_AUTHORS, [&](pqxx::transaction_base& r) {
+        std::vector<domain::Author> authors;
+        pqxx::result res = ExecPrepared(r, statements::SHOW_AUTHORS);
+        authors.reserve(res.size());
+        for (const auto& row : res) {
+            authors.emplace_back(row[0].as<domain::AuthorId>(),
+                                 row[1].as<std::string>());
+        }
+        return authors;
+    });
+}
+std::vector<domain::Author> UnitOfWork::ShowAuthorsPage(const std::optional<std::string>& after_name,
+                                                        size_t limit) {
+    return Execute<pqxx::read_transaction>(metrics::SHOW_AUTHORS_PAGE, [&](pqxx::transaction_base& r) {
+        std::vector<domain::Author> authors;
+        pqxx::result res = after_name
+                           ? ExecPrepared(r, statements::SHOW_AUTHORS_PAGE, *after_name, limit)
+                           : ExecPrepared(r, statements::SHOW_AUTHORS_FIRST_PAGE, limit);
+        authors.reserve(res.size());
+        for (const auto& row : res) {
+            authors.emplace_back(row[0].as<domain::AuthorId>(),
+                                 row[1].as<std::string>());
+        }
+        return authors;
+    });
 }
-
 
 void UnitOfWork::AddBook(const domain::Book& book) {
-    pqxx::work work{connection_};
-    work.exec(R"(START TRANSACTION;)"_zv);
-    work.exec_params(R"(
-INSERT INTO books (id, author_id, title, publication_year) VALUES($1, $2, $3, $4);
-    )"_zv, book.GetId().ToString(), book.GetAuthorId().ToString(), book.GetTitle(), book.GetPublicationYear());
-    for (const std::string& tag : book.GetTags()) {
-        work.exec_params(R"(
-INSERT INTO book_tags (book_id, tag) VALUES($1, $2);
-        )"_zv, book.GetId().ToString(), tag);
-    }
-    work.exec(R"(COMMIT;)"_zv);
-    work.commit();
+    Execute<pqxx::work>(metrics::ADD_BOOK, [&](pqxx::transaction_base& work) {
+        ExecPrepared(work, statements::ADD_BOOK, book.GetId(), book.GetAuthorId(),
+                     book.GetTitle(), book.GetPublicationYear(), book.GetTags());
+    });
 }
 
 void UnitOfWork::DeleteBook(const domain::BookId& id) {
-    pqxx::work work{connection_};
-    work.exec(R"(START TRANSACTION;)"_zv);
-    work.exec_params(R"(
-DELETE FROM book_tags
-WHERE book_id IN (
-    SELECT id FROM books
-    WHERE author_id = $1
-);)"_zv, id.ToString());
-    pqxx::result res = work.exec_params0(R"(DELETE FROM books WHERE id = $1;)"_zv, id.ToString());
-    if (res.affected_rows() == 0) {
-        throw std::runtime_error("No such book"s);
-    }
-    work.exec(R"(COMMIT;)"_zv);
-    work.commit();
+    Execute<pqxx::work>(metrics::DELETE_BOOK, [&](pqxx::transaction_base& work) {
+        pqxx::result res = ExecPrepared0(work, statements::DELETE_BOOK, id);
+        if (res.affected_rows() == 0) {
+            throw std::runtime_error("No such book"s);
+        }
+    });
 }
 
 void UnitOfWork::EditBook(const domain::Book& new_book) {
-    pqxx::work work{connection_};
-    std::string book_id = new_book.GetId().ToString();
-    work.exec(R"(START TRANSACTION;)"_zv);
-    work.exec_params(R"(
-UPDATE books SET title = $1, publication_year = $2 WHERE id = $3;
-    )"_zv, new_book.GetTitle(), new_book.GetPublicationYear(), book_id);
-    work.exec_params(R"(DELETE FROM book_tags WHERE book_id = $1;)"_zv, book_id);
-    for (const std::string& tag : new_book.GetTags()) {
-        work.exec_params(R"(
-INSERT INTO book_tags (book_id, tag) VALUES($1, $2);
-        )"_zv, book_id, tag);
-    }
-    work.exec(R"(COMMIT;)"_zv);
-    work.commit();
+    Execute<pqxx::work>(metrics::EDIT_BOOK, [&](pqxx::transaction_base& work) {
+        ExecPrepared(work, statements::EDIT_BOOK, new_book.GetTitle(), new_book.GetPublicationYear(),
+                     new_book.GetId(), new_book.GetTags());
+    });
 }
 
 std::vector<domain::Book> UnitOfWork::ShowAllBooks() {
-    std::vector<domain::Book> books;
-    pqxx::read_transaction r(connection_);
-    const auto show_books_sql = R"(
-SELECT books.id, author_id, title, publication_year
-FROM books
-JOIN authors ON books.author_id = authors.id
-ORDER BY books.title, authors.name, books.publication_year;)"_zv;
-
-    for (auto [id, author_id, title, year] :
-                    r.query<std::string, std::string, std::string, uint64_t>(show_books_sql)) {
-        books.emplace_back(domain::BookId::FromString(std::move(id)),
-                           domain::AuthorId::FromString(std::move(author_id)),
-                           std::move(title),
-                           year);
-    }
-    return books;
+    return Execute<pqxx::read_transaction>(metrics::SHOW_ALL_BOOKS, [&](pqxx::transaction_base& r) {
+        std::vector<domain::Book> books;
+        pqxx::result res = ExecPrepared(r, statements::SHOW_ALL_BOOKS);
+        books.reserve(res.size());
+        for (const auto& row : res) {
+            books.emplace_back(BookFromRow(row, std::nullopt));
+        }
+        return books;
+    });
 }
 std::vector<domain::Book> UnitOfWork::ShowBooksByAuthor(const domain::AuthorId& author_id){
-    std::vector<domain::Book> books;
-    pqxx::read_transaction r(connection_);
-    std::string query_str = "SELECT id, author_id, title, publication_year FROM books WHERE author_id = '" +
-                            author_id.ToString() + "' ORDER BY publication_year, title;";
+    return Execute<pqxx::read_transaction>(metrics::SHOW_BOOKS_BY_AUTHOR, [&](pqxx::transaction_base& r) {
+        std::vector<domain::Book> books;
+        pqxx::result res = ExecPrepared(r, statements::SHOW_BOOKS_BY_AUTHOR, author_id);
+        books.reserve(res.size());
+        for (const auto& row : res) {
+            books.emplace_back(BookFromRow(row, std::nullopt));
+        }
+        return books;
+    });
+}
 
-    for (auto [id, author_id, title, year] : r.query<std::string, std::string, std::string, uint64_t>(
-             pqxx::zview(query_str))) {
-        books.emplace_back(domain::BookId::FromString(std::move(id)),
-                           domain::AuthorId::FromString(std::move(author_id)),
-                           std::move(title),
-                           year);
+std::vector<domain::BookWithAuthor> UnitOfWork::ShowBooksPage(const std::optional<domain::BookPageCursor>& after,
+                                                              size_t limit) {
+    return Execute<pqxx::read_transaction>(metrics::SHOW_BOOKS_PAGE, [&](pqxx::transaction_base& r) {
+        std::vector<domain::BookWithAuthor> books;
+        pqxx::result res = after
+                           ? ExecPrepared(r, statements::SHOW_BOOKS_PAGE, after->title, after->author_name,
+                                          after->publication_year, after->id, limit)
+                           : ExecPrepared(r, statements::SHOW_BOOKS_FIRST_PAGE, limit);
+        books.reserve(res.size());
+        for (const auto& row : res) {
+            books.emplace_back(BookWithAuthorFromRow(row, false));
+        }
+        return books;
+    });
+}
+std::vector<domain::BookWithAuthor> UnitOfWork::ShowBooksPageByTags(const std::vector<std::string>& tags,
+                                                                    domain::TagMatch match,
+                                                                    const std::optional<domain::BookPageCursor>& after,
+                                                                    size_t limit) {
+    std::optional<std::string> after_title;
+    std::optional<std::string> after_author_name;
+    std::optional<uint64_t> after_publication_year;
+    std::optional<domain::BookId> after_id;
+    if (after) {
+        after_title = after->title;
+        after_author_name = after->author_name;
+        after_publication_year = after->publication_year;
+        after_id = after->id;
     }
-    return books;
+    return Execute<pqxx::read_transaction>(metrics::SHOW_BOOKS_PAGE_BY_TAGS, [&](pqxx::transaction_base& r) {
+        std::vector<domain::BookWithAuthor> books;
+        pqxx::result res = ExecPrepared(r, match == domain::TagMatch::ALL ? statements::SHOW_BOOKS_WITH_ALL_TAGS
+                                                                         : statements::SHOW_BOOKS_WITH_ANY_TAG,
+                                        tags, after_title, after_author_name, after_publication_year, after_id,
+                                        limit);
+        books.reserve(res.size());
+        for (const auto& row : res) {
+            books.emplace_back(BookWithAuthorFromRow(row, false));
+        }
+        return books;
+    });
+}
+std::vector<domain::Book> UnitOfWork::ShowAuthorBooksPage(const domain::AuthorId& author_id,
+                                                          const std::optional<domain::AuthorBookPageCursor>& after,
+                                                          size_t limit) {
+    return Execute<pqxx::read_transaction>(metrics::SHOW_AUTHOR_BOOKS_PAGE, [&](pqxx::transaction_base& r) {
+        std::vector<domain::Book> books;
+        pqxx::result res = after
+                           ? ExecPrepared(r, statements::SHOW_AUTHOR_BOOKS_PAGE, author_id,
+                                          after->publication_year, after->title, after->id, limit)
+                           : ExecPrepared(r, statements::SHOW_AUTHOR_BOOKS_FIRST_PAGE, author_id, limit);
+        books.reserve(res.size());
+        for (const auto& row : res) {
+            books.emplace_back(BookFromRow(row, std::nullopt));
+        }
+        return books;
+    });
 }
 
+/* Теги всех найденных книг выбираются тем же запросом (ARRAY(SELECT ...)),
+ * поэтому число обращений к серверу не зависит от количества книг */
 domain::Book UnitOfWork::ShowBookInfoByID(const domain::BookId& book_id) {
-    pqxx::read_transaction r(connection_);
-    std::string query1_str = "SELECT id, author_id, title, publication_year FROM books WHERE id = '" +
-                            book_id.ToString() + "' ORDER BY publication_year, title;";
-    std::string query2_str = "SELECT tag FROM book_tags WHERE book_id = '" +
-                             book_id.ToString() + "' ORDER BY tag ASC;";
-    auto [id, author_id, title, year] =
-                r.query1<std::string, std::string, std::string, uint64_t>(pqxx::zview(query1_str));
-    domain::Book book(domain::BookId::FromString(std::move(id)),
-                      domain::AuthorId::FromString(std::move(author_id)),
-                      std::move(title),
-                      year,
-                      {});
-    for (auto [tag] : r.query<std::string>(pqxx::zview(query2_str))) {
-        book.AddTag(std::move(tag));
-    }
-    return book;
+    return Execute<pqxx::read_transaction>(metrics::SHOW_BOOK_INFO_BY_ID, [&](pqxx::transaction_base& r) {
+        pqxx::row row = ExecPrepared1(r, statements::SHOW_BOOK_BY_ID, book_id);
+        return BookFromRow(row, 4);
+    });
 }
 std::vector<domain::Book> UnitOfWork::ShowBookInfoByTitle(const std::string& book_title) {
-    pqxx::read_transaction r(connection_);
-    std::vector<domain::Book> books;
-    std::string query1_str = "SELECT id, author_id, title, publication_year FROM books WHERE title = '" +
-                             book_title + "' ORDER BY publication_year, title;";
-    for (auto [id, author_id, title, year] :
-                r.query<std::string, std::string, std::string, uint64_t>(pqxx::zview(query1_str))) {
-        books.emplace_back(domain::BookId::FromString(std::move(id)),
-                           domain::AuthorId::FromString(std::move(author_id)),
-                           std::move(title),
-                           year);
-        std::string query2_str = "SELECT tag FROM book_tags WHERE book_id = '" +
-                                 id + "' ORDER BY tag;";
-        for (auto [tag] : r.query<std::string>(pqxx::zview(query2_str))) {
-            books.back().AddTag(std::move(tag));
+    return Execute<pqxx::read_transaction>(metrics::SHOW_BOOK_INFO_BY_TITLE, [&](pqxx::transaction_base& r) {
+        std::vector<domain::Book> books;
+        pqxx::result res = ExecPrepared(r, statements::SHOW_BOOKS_BY_TITLE, book_title);
+        books.reserve(res.size());
+        for (const auto& row : res) {
+            books.emplace_back(BookFromRow(row, 4));
         }
+        return books;
+    });
+}
+
+std::vector<domain::BookSearchResult> UnitOfWork::SearchBooks(const std::string& query,
+                                                              const std::optional<domain::BookSearchCursor>& after,
+                                                              size_t limit) {
+    std::optional<double> after_rank;
+    std::optional<domain::BookId> after_id;
+    if (after) {
+        after_rank = after->rank;
+        after_id = after->id;
     }
-    return books;
+    return Execute<pqxx::read_transaction>(metrics::SEARCH_BOOKS, [&](pqxx::transaction_base& r) {
+        std::vector<domain::BookSearchResult> books;
+        pqxx::result res = ExecPrepared(r, statements::SEARCH_BOOKS, query, after_rank, after_id, limit);
+        books.reserve(res.size());
+        for (const auto& row : res) {
+            books.push_back({BookWithAuthorFromRow(row, true), row[6].as<double>()});
+        }
+        return books;
+    });
+}
+
+/* Массовый импорт: записи пакета передаются командой COPY во временную таблицу,
+ * после чего авторы, книги и теги добавляются тремя запросами над всем пакетом.
+ * Новому автору назначается один идентификатор для всех его книг в пакете */
+void UnitOfWork::ImportBooks(const std::vector<domain::CatalogRecord>& records) {
+    Execute<pqxx::work>(metrics::IMPORT_BOOKS, [&](pqxx::transaction_base& work) {
+        ExecPrepared(work, statements::CLEAR_IMPORT);
+        std::unordered_map<std::string_view, domain::AuthorId> author_ids;
+        auto stream = pqxx::stream_to::table(work, {"catalog_import"sv},
+                                             {"book_id"sv, "author_id"sv, "author_name"sv,
+                                              "title"sv, "publication_year"sv, "tags"sv});
+        for (const auto& record : records) {
+            auto [it, inserted] = author_ids.try_emplace(record.author_name);
+            if (inserted) {
+                it->second = domain::AuthorId::New();
+            }
+            stream.write_values(domain::BookId::New(), it->second, record.author_name,
+                                record.title, record.publication_year, record.tags);
+        }
+        stream.complete();
+
+        ExecPrepared(work, statements::IMPORT_AUTHORS);
+        ExecPrepared(work, statements::IMPORT_BOOKS);
+        ExecPrepared(work, statements::IMPORT_BOOK_TAGS);
+    });
+}
+
+/* Потоковый экспорт командой COPY (pqxx::stream_from): строки передаются visitor
+ * по мере получения, поэтому расход памяти не зависит от размера каталога.
+ * COPY не поддерживает подготовленные запросы, поэтому запрос передаётся текстом */
+void UnitOfWork::ExportBooks(const std::function<void(const domain::CatalogRecord&)>& visitor) {
+    Execute<pqxx::read_transaction>(metrics::EXPORT_BOOKS, [&](pqxx::transaction_base& r) {
+        auto stream = pqxx::stream_from::query(r, R"(
+SELECT authors.name, books.title, books.publication_year,
+       ARRAY(SELECT tag FROM book_tags WHERE book_tags.book_id = books.id ORDER BY tag)
+FROM books
+JOIN authors ON books.author_id = authors.id
+ORDER BY books.title, authors.name, books.publication_year)"sv);
+        domain::CatalogRecord record;
+        for (auto [author_name, title, year, tags] :
+                    stream.iter<std::string, std::string, uint64_t, std::string>()) {
+            record.author_name = std::move(author_name);
+            record.title = std::move(title);
+            record.publication_year = year;
+            record.tags = TagsFromArrayLiteral(tags);
+            visitor(record);
+        }
+        stream.complete();
+    });
+}
+
+/* Книги вместе с именами авторов (и, при необходимости, тегами) одним запросом */
+std::vector<domain::BookWithAuthor> UnitOfWork::ShowAllBooksWithAuthors(bool with_tags) {
+    return Execute<pqxx::read_transaction>(metrics::SHOW_ALL_BOOKS_WITH_AUTHORS, [&](pqxx::transaction_base& r) {
+        std::vector<domain::BookWithAuthor> books;
+        pqxx::result res = ExecPrepared(r, with_tags ? statements::SHOW_ALL_BOOKS_WITH_AUTHORS_AND_TAGS
+                                                    : statements::SHOW_ALL_BOOKS_WITH_AUTHORS);
+        books.reserve(res.size());
+        for (const auto& row : res) {
+            books.emplace_back(BookWithAuthorFromRow(row, with_tags));
+        }
+        return books;
+    });
+}
+domain::BookWithAuthor UnitOfWork::ShowBookWithAuthorByID(const domain::BookId& book_id) {
+    return Execute<pqxx::read_transaction>(metrics::SHOW_BOOK_WITH_AUTHOR_BY_ID, [&](pqxx::transaction_base& r) {
+        pqxx::row row = ExecPrepared1(r, statements::SHOW_BOOK_WITH_AUTHOR_BY_ID, book_id);
+        return BookWithAuthorFromRow(row, true);
+    });
+}
+std::vector<domain::BookWithAuthor> UnitOfWork::ShowBooksWithAuthorByTitle(const std::string& book_title) {
+    return Execute<pqxx::read_transaction>(metrics::SHOW_BOOKS_WITH_AUTHOR_BY_TITLE, [&](pqxx::transaction_base& r) {
+        std::vector<domain::BookWithAuthor> books;
+        pqxx::result res = ExecPrepared(r, statements::SHOW_BOOKS_WITH_AUTHOR_BY_TITLE, book_title);
+        books.reserve(res.size());
+        for (const auto& row : res) {
+            books.emplace_back(BookWithAuthorFromRow(row, true));
+        }
+        return books;
+    });
 }
 
-}  // namespace postgres
\ No newline at end of file
+}  // namespace postgres
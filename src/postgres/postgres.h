@@ -1,24 +1,135 @@
 /*
  * Модуль хранения. Отвечает за запись и чтение данных в СУБД PostgreSQL
+ * Каждая операция UnitOfWork берёт соединение из пула на время своего выполнения,
+ * поэтому репозитории можно использовать из нескольких потоков одновременно
  */
 #pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <pqxx/connection>
+#include <pqxx/subtransaction>
 #include <pqxx/transaction>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "../domain/author.h"
+#include "../stats/stats.h"
+#include "connection_pool.h"
+#include "replica_set.h"
+#include "slow_query_log.h"
 
 namespace postgres {
 
+/* Группа своя у каждого потока. Пока она открыта, операции UnitOfWork из этого потока выполняются
+ * на одном соединении в её транзакции, команда - в подтранзакции (SAVEPOINT). Потоки без группы
+ * по-прежнему выполняют каждую операцию в отдельной транзакции на соединении из пула.
+ * Группа читает только с основного сервера: её транзакция видит её же изменения */
+class CommandBatchImpl : public domain::CommandBatch {
+public:
+    CommandBatchImpl(ConnectionPool& pool, ReplicaSet& replicas);
+    ~CommandBatchImpl();
+
+    void Begin() override;
+    void BeginCommand() override;
+    bool EndCommand() override;
+    void Commit() override;
+    void Rollback() noexcept override;
+    bool IsOpen() const noexcept override;
+
+    /* Транзакция текущей команды, если группу открыл вызывающий поток, иначе nullptr */
+    pqxx::transaction_base* GetTransaction() noexcept;
+    /* Ошибка сервера прервала подтранзакцию команды: EndCommand её откатит */
+    void MarkFailed() noexcept;
+
+private:
+    /* Транзакция группы одного потока */
+    struct Group {
+        std::optional<ConnectionPool::ConnectionWrapper> connection;
+        std::unique_ptr<pqxx::work> work;
+        std::unique_ptr<pqxx::subtransaction> command;
+        bool command_failed = false;
+    };
+
+    /* Группа вызывающего потока или nullptr */
+    Group* FindGroup() noexcept;
+
+    ConnectionPool& pool_;
+    ReplicaSet& replicas_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::thread::id, Group> groups_;
+};
+
+/* Снимок для чтения: транзакция REPEATABLE READ READ ONLY на одном соединении.
+ * Снимок свой у каждого потока-владельца, открывшего его Begin. Транзакция начинается при первом
+ * чтении после Begin, поэтому команда без чтения её не открывает. В снимке по очереди выполняются
+ * чтения владельца и потоков, присоединённых к нему Attach (фоновые запросы страниц), остальные
+ * потоки читают каждое в своей транзакции. Чтение в открытой вызывающим потоком группе команд
+ * выполняется в её транзакции. После ошибки СУБД снимок больше не используется:
+ * следующие чтения выполняются каждое в своей транзакции */
+class ReadSnapshotImpl : public domain::ReadSnapshot {
+    struct Snapshot;
+
+public:
+    using Transaction = pqxx::transaction<pqxx::isolation_level::repeatable_read, pqxx::write_policy::read_only>;
+
+    /* Снимок вызывающего потока, заблокированный на время одного чтения */
+    struct Lease {
+        std::shared_ptr<Snapshot> snapshot;
+        std::unique_lock<std::mutex> lock;
+    };
+
+    ReadSnapshotImpl(ConnectionPool& pool, ReplicaSet& replicas);
+    ~ReadSnapshotImpl();
+
+    void Begin() override;
+    void End() noexcept override;
+    void Release() noexcept override;
+    void Attach(std::thread::id owner) noexcept override;
+    void Detach() noexcept override;
+
+    /* Транзакция снимка, заблокированного в lease, или nullptr, если вызывающий поток читает вне снимка */
+    pqxx::transaction_base* Acquire(Lease& lease);
+    /* Вызывается с заблокированным снимком */
+    static void MarkFailed(Lease& lease) noexcept;
+
+private:
+    struct Snapshot {
+        std::mutex mutex;
+        bool open = true;
+        bool failed = false;
+        std::optional<ConnectionPool::ConnectionWrapper> connection;
+        std::unique_ptr<Transaction> transaction;
+
+        void Close() noexcept;
+    };
+
+    /* Снимок, в котором читает вызывающий поток, или nullptr */
+    std::shared_ptr<Snapshot> Find() const;
+    /* Снимок, открытый вызывающим потоком, исключается из снимков владельцев */
+    std::shared_ptr<Snapshot> Extract() noexcept;
+
+    ConnectionPool& pool_;
+    ReplicaSet& replicas_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::thread::id, std::shared_ptr<Snapshot>> snapshots_;
+    /* Присоединённый поток -> владелец снимка */
+    std::unordered_map<std::thread::id, std::thread::id> attached_;
+};
+
 class UnitOfWork {
 public:
-    explicit UnitOfWork(pqxx::connection& connection)
-                : connection_{connection}{}
+    UnitOfWork(ConnectionPool& pool, ReplicaSet& replicas, CommandBatchImpl& batch, ReadSnapshotImpl& snapshot,
+               SlowQueryLog& slow_log)
+                : pool_{pool}, replicas_{replicas}, batch_{batch}, snapshot_{snapshot}, slow_log_{slow_log}{}
     void AddAuthor(const domain::Author& author);
     std::string GetAuthorName(const domain::AuthorId& id);
     std::string GetAuthorID(const std::string& id);
     std::vector<domain::Author> ShowAuthors();
+    std::vector<domain::Author> ShowAuthorsPage(const std::optional<std::string>& after_name, size_t limit);
     void DeleteAuthor(const domain::AuthorId& id);
     void DeleteAuthor(const std::string& name);
     void EditAuthor(const domain::Author& new_author);
@@ -29,23 +140,58 @@ public:
     std::vector<domain::Book> ShowBooksByAuthor(const domain::AuthorId& author_id);
     domain::Book ShowBookInfoByID(const domain::BookId& book_id);
     std::vector<domain::Book> ShowBookInfoByTitle(const std::string& book_title);
+    std::vector<domain::BookWithAuthor> ShowAllBooksWithAuthors(bool with_tags);
+    std::vector<domain::BookWithAuthor> ShowBooksPage(const std::optional<domain::BookPageCursor>& after,
+                                                      size_t limit);
+    std::vector<domain::BookWithAuthor> ShowBooksPageByTags(const std::vector<std::string>& tags,
+                                                            domain::TagMatch match,
+                                                            const std::optional<domain::BookPageCursor>& after,
+                                                            size_t limit);
+    std::vector<domain::Book> ShowAuthorBooksPage(const domain::AuthorId& author_id,
+                                                  const std::optional<domain::AuthorBookPageCursor>& after,
+                                                  size_t limit);
+    domain::BookWithAuthor ShowBookWithAuthorByID(const domain::BookId& book_id);
+    std::vector<domain::BookWithAuthor> ShowBooksWithAuthorByTitle(const std::string& book_title);
+    std::vector<domain::BookSearchResult> SearchBooks(const std::string& query,
+                                                      const std::optional<domain::BookSearchCursor>& after,
+                                                      size_t limit);
     void DeleteBook(const domain::BookId& id);
     void EditBook(const domain::Book& new_book);
+    void ImportBooks(const std::vector<domain::CatalogRecord>& records);
+    void ExportBooks(const std::function<void(const domain::CatalogRecord&)>& visitor);
 
 private:
-    pqxx::connection& connection_;
+    template <typename Transaction, typename Operation>
+    auto Execute(stats::Metric& metric, Operation&& operation);
+
+    /* exec_prepared, exec_prepared0 и exec_prepared1 с замером времени запроса:
+     * медленный запрос передаётся журналу вместе с параметрами */
+    template <typename... Args>
+    pqxx::result ExecPrepared(pqxx::transaction_base& transaction, const char* statement, const Args&... args);
+    template <typename... Args>
+    pqxx::result ExecPrepared0(pqxx::transaction_base& transaction, const char* statement, const Args&... args);
+    template <typename... Args>
+    pqxx::row ExecPrepared1(pqxx::transaction_base& transaction, const char* statement, const Args&... args);
+
+    ConnectionPool& pool_;
+    ReplicaSet& replicas_;
+    CommandBatchImpl& batch_;
+    ReadSnapshotImpl& snapshot_;
+    SlowQueryLog& slow_log_;
 };
 
 class AuthorRepositoryImpl : public domain::AuthorRepository {
 public:
-    explicit AuthorRepositoryImpl(pqxx::connection& connection)
-        : unit_of_work_{connection} {
+    AuthorRepositoryImpl(ConnectionPool& pool, ReplicaSet& replicas, CommandBatchImpl& batch,
+                         ReadSnapshotImpl& snapshot, SlowQueryLog& slow_log)
+        : unit_of_work_{pool, replicas, batch, snapshot, slow_log} {
     }
 
     void Save(const domain::Author& author) override;
     std::string GetName(const domain::AuthorId& id) override;
     std::string GetID(const std::string& name) override;
     std::vector<domain::Author> Show() override;
+    std::vector<domain::Author> ShowPage(const std::optional<std::string>& after_name, size_t limit) override;
     void Delete(const domain::AuthorId& id) override;
     void Delete(const std::string& name) override;
     void Edit(const domain::Author& new_author) override;
@@ -57,16 +203,33 @@ private:
 
 class BookRepositoryImpl : public domain::BookRepository {
 public:
-    explicit BookRepositoryImpl(pqxx::connection& connection)
-                : unit_of_work_{connection} {}
+    BookRepositoryImpl(ConnectionPool& pool, ReplicaSet& replicas, CommandBatchImpl& batch,
+                       ReadSnapshotImpl& snapshot, SlowQueryLog& slow_log)
+                : unit_of_work_{pool, replicas, batch, snapshot, slow_log} {}
 
     void Save(const domain::Book& book) override;
     std::vector<domain::Book> ShowAll() override;
     std::vector<domain::Book> ShowByAuthor(const domain::AuthorId& author_id) override;
     domain::Book ShowInfoByID(const domain::BookId& book_id) override;
     std::vector<domain::Book> ShowInfoByTitle(const std::string& book_title) override;
+    std::vector<domain::BookWithAuthor> ShowAllWithAuthors(bool with_tags) override;
+    std::vector<domain::BookWithAuthor> ShowPageWithAuthors(const std::optional<domain::BookPageCursor>& after,
+                                                            size_t limit) override;
+    std::vector<domain::BookWithAuthor> ShowPageByTags(const std::vector<std::string>& tags, domain::TagMatch match,
+                                                       const std::optional<domain::BookPageCursor>& after,
+                                                       size_t limit) override;
+    std::vector<domain::Book> ShowPageByAuthor(const domain::AuthorId& author_id,
+                                               const std::optional<domain::AuthorBookPageCursor>& after,
+                                               size_t limit) override;
+    domain::BookWithAuthor ShowInfoWithAuthorByID(const domain::BookId& book_id) override;
+    std::vector<domain::BookWithAuthor> ShowInfoWithAuthorByTitle(const std::string& book_title) override;
+    std::vector<domain::BookSearchResult> Search(const std::string& query,
+                                                 const std::optional<domain::BookSearchCursor>& after,
+                                                 size_t limit) override;
     void Delete(const domain::BookId& id) override;
     void Edit(const domain::Book& new_book) override;
+    void Import(const std::vector<domain::CatalogRecord>& records) override;
+    void Export(const std::function<void(const domain::CatalogRecord&)>& visitor) override;
 
 private:
     UnitOfWork unit_of_work_;
@@ -74,7 +237,9 @@ private:
 
 class Database {
 public:
-    explicit Database(pqxx::connection connection);
+    /* Чтение распределяется по репликам replica_config.urls, если они заданы */
+    Database(const std::string& db_url, size_t pool_size, SlowQueryLogConfig slow_query_config = {},
+             ReplicaSetConfig replica_config = {});
 
     AuthorRepositoryImpl& GetAuthors() & {
         return authors_;
@@ -84,10 +249,26 @@ public:
         return books_;
     }
 
+    CommandBatchImpl& GetCommandBatch() & {
+        return batch_;
+    }
+
+    ReadSnapshotImpl& GetReadSnapshot() & {
+        return snapshot_;
+    }
+
+    ConnectionPool& GetConnectionPool() & {
+        return pool_;
+    }
+
 private:
-    pqxx::connection connection_;
-    AuthorRepositoryImpl authors_{connection_};
-    BookRepositoryImpl books_{connection_};
+    ConnectionPool pool_;
+    ReplicaSet replicas_;
+    SlowQueryLog slow_log_;
+    CommandBatchImpl batch_{pool_, replicas_};
+    ReadSnapshotImpl snapshot_{pool_, replicas_};
+    AuthorRepositoryImpl authors_{pool_, replicas_, batch_, snapshot_, slow_log_};
+    BookRepositoryImpl books_{pool_, replicas_, batch_, snapshot_, slow_log_};
 };
 
 }  // namespace postgres
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "replica_set.h"
+
+namespace postgres {
+
+ReplicaSet::Replica::Replica(std::string url, size_t pool_size, ConnectionPool::ConnectionFactory connection_factory)
+    : url_{std::move(url)}
+    , pool_{pool_size, std::move(connection_factory)} {
+}
+
+ReplicaSet::ReplicaSet(ReplicaSetConfig config, size_t pool_size, const FactoryMaker& make_factory)
+    : policy_{config.policy}
+    , pin_after_write_{config.pin_after_write}
+    , retry_after_failure_{config.retry_after_failure} {
+    replicas_.reserve(config.urls.size());
+    for (auto& url : config.urls) {
+        auto factory = make_factory(url);
+        replicas_.push_back(std::make_unique<Replica>(std::move(url), pool_size, std::move(factory)));
+    }
+}
+
+ReplicaSet::Replica* ReplicaSet::Select() noexcept {
+    if (replicas_.empty()) {
+        return nullptr;
+    }
+    const auto now = Clock::now();
+    if (now.time_since_epoch().count() < pinned_until_.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    // Поиск начинается с очередной реплики, поэтому при равном времени реплики чередуются
+    const size_t start = next_.fetch_add(1, std::memory_order_relaxed);
+    Replica* selected = nullptr;
+    for (size_t i = 0; i < replicas_.size(); ++i) {
+        Replica& replica = *replicas_[(start + i) % replicas_.size()];
+        if (!IsAvailable(replica, now)) {
+            continue;
+        }
+        if (policy_ == ReplicaPolicy::ROUND_ROBIN) {
+            return &replica;
+        }
+        if (!selected || replica.GetLatency() < selected->GetLatency()) {
+            selected = &replica;
+        }
+    }
+    return selected;
+}
+
+void ReplicaSet::MarkWrite() noexcept {
+    pinned_until_.store((Clock::now() + pin_after_write_).time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+void ReplicaSet::MarkFailed(Replica& replica) noexcept {
+    replica.unavailable_until_.store((Clock::now() + retry_after_failure_).time_since_epoch().count(),
+                                     std::memory_order_relaxed);
+    // После восстановления реплика снова выбирается по замерам
+    replica.latency_ns_.store(0, std::memory_order_relaxed);
+}
+
+void ReplicaSet::RecordLatency(Replica& replica, std::chrono::nanoseconds duration) noexcept {
+    const int64_t latency = replica.latency_ns_.load(std::memory_order_relaxed);
+    // Гонка между потоками может потерять один замер, что для среднего несущественно
+    replica.latency_ns_.store(latency == 0 ? duration.count()
+                                           : latency + (duration.count() - latency) / LATENCY_SMOOTHING,
+                              std::memory_order_relaxed);
+}
+
+bool ReplicaSet::IsAvailable(const Replica& replica, Clock::time_point now) const noexcept {
+    return now.time_since_epoch().count() >= replica.unavailable_until_.load(std::memory_order_relaxed);
+}
+
+}  // namespace postgres
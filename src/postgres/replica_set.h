@@ -0,0 +1,142 @@
+/*
+ * Реплики СУБД для чтения.
+ * Операции UnitOfWork, выполняемые в pqxx::read_transaction, отправляются на реплику,
+ * остальные - на основной сервер. У каждой реплики свой пул соединений того же размера.
+ * Реплика выбирается по очереди (ROUND_ROBIN) или по наименьшему среднему времени
+ * выполнения операций (LEAST_LATENCY).
+ * Чтение выполняется на основном сервере, если:
+ * - реплик нет;
+ * - после последней записи прошло меньше pin_after_write: реплика могла ещё не получить изменения,
+ *   а пользователь должен видеть свои изменения сразу;
+ * - ни к одной реплике не удаётся подключиться. Реплика, к которой не удалось подключиться
+ *   или соединение с которой разорвалось, не используется в течение retry_after_failure.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "connection_pool.h"
+
+namespace postgres {
+
+enum class ReplicaPolicy {
+    ROUND_ROBIN,
+    LEAST_LATENCY
+};
+
+struct ReplicaSetConfig {
+    std::vector<std::string> urls;
+    ReplicaPolicy policy = ReplicaPolicy::ROUND_ROBIN;
+    std::chrono::milliseconds pin_after_write{1'000};
+    std::chrono::milliseconds retry_after_failure{5'000};
+};
+
+class ReplicaSet {
+public:
+    using Clock = std::chrono::steady_clock;
+    /* Фабрика соединений с сервером по его URL */
+    using FactoryMaker = std::function<ConnectionPool::ConnectionFactory(const std::string& url)>;
+
+    class Replica {
+    public:
+        Replica(std::string url, size_t pool_size, ConnectionPool::ConnectionFactory connection_factory);
+
+        const std::string& GetUrl() const noexcept {
+            return url_;
+        }
+
+        ConnectionPool& GetPool() noexcept {
+            return pool_;
+        }
+
+        /* Среднее время операции (экспоненциальное скользящее), 0 - операций ещё не было */
+        std::chrono::nanoseconds GetLatency() const noexcept {
+            return std::chrono::nanoseconds{latency_ns_.load(std::memory_order_relaxed)};
+        }
+
+    private:
+        friend class ReplicaSet;
+
+        const std::string url_;
+        ConnectionPool pool_;
+        std::atomic<int64_t> latency_ns_{0};
+        std::atomic<Clock::rep> unavailable_until_{0};
+    };
+
+    /* Замеряет время операции на реплике. Операция, завершённая исключением, не учитывается */
+    class LatencyProbe {
+    public:
+        explicit LatencyProbe(Replica& replica) noexcept
+            : replica_{replica}
+            , exceptions_{std::uncaught_exceptions()} {
+        }
+
+        LatencyProbe(const LatencyProbe&) = delete;
+        LatencyProbe& operator=(const LatencyProbe&) = delete;
+
+        ~LatencyProbe() {
+            if (std::uncaught_exceptions() == exceptions_) {
+                ReplicaSet::RecordLatency(replica_, Clock::now() - start_);
+            }
+        }
+
+    private:
+        Replica& replica_;
+        int exceptions_;
+        Clock::time_point start_ = Clock::now();
+    };
+
+    /* Отмечает запись при разрушении, то есть после фиксации транзакции */
+    class WriteMark {
+    public:
+        explicit WriteMark(ReplicaSet& replicas) noexcept
+            : replicas_{replicas} {
+        }
+
+        WriteMark(const WriteMark&) = delete;
+        WriteMark& operator=(const WriteMark&) = delete;
+
+        ~WriteMark() {
+            replicas_.MarkWrite();
+        }
+
+    private:
+        ReplicaSet& replicas_;
+    };
+
+    ReplicaSet(ReplicaSetConfig config, size_t pool_size, const FactoryMaker& make_factory);
+
+    /* Реплика для очередного чтения или nullptr, если читать нужно с основного сервера */
+    Replica* Select() noexcept;
+
+    /* Вызывается после каждой записи на основной сервер */
+    void MarkWrite() noexcept;
+    void MarkFailed(Replica& replica) noexcept;
+
+    size_t GetSize() const noexcept {
+        return replicas_.size();
+    }
+
+private:
+    /* Вес нового замера в среднем времени операции */
+    static constexpr int64_t LATENCY_SMOOTHING = 8;
+
+    static void RecordLatency(Replica& replica, std::chrono::nanoseconds duration) noexcept;
+
+    bool IsAvailable(const Replica& replica, Clock::time_point now) const noexcept;
+
+    const ReplicaPolicy policy_;
+    const Clock::duration pin_after_write_;
+    const Clock::duration retry_after_failure_;
+    std::vector<std::unique_ptr<Replica>> replicas_;
+    std::atomic<size_t> next_{0};
+    std::atomic<Clock::rep> pinned_until_{Clock::time_point::min().time_since_epoch().count()};
+};
+
+}  // namespace postgres
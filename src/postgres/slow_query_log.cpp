@@ -0,0 +1,129 @@
+#include "slow_query_log.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <pqxx/pqxx>
+#include <stdexcept>
+#include <utility>
+
+namespace postgres {
+
+using namespace std::literals;
+
+SlowQueryLog::SlowQueryLog(SlowQueryLogConfig config, ConnectionPool::ConnectionFactory connection_factory)
+    : threshold_{config.threshold}
+    , explain_{config.explain}
+    , connection_factory_{std::move(connection_factory)}
+    , output_{&std::cerr} {
+    if (!threshold_) {
+        return;
+    }
+    if (!config.file.empty()) {
+        file_ = std::make_unique<std::ofstream>(config.file, std::ios::app);
+        if (!*file_) {
+            throw std::runtime_error("Failed to open slow query log "s + config.file);
+        }
+        output_ = file_.get();
+    }
+    worker_ = std::thread{[this] {
+        Run();
+    }};
+}
+
+SlowQueryLog::~SlowQueryLog() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard lock{mutex_};
+        stopping_ = true;
+    }
+    cond_var_.notify_one();
+    worker_.join();
+}
+
+void SlowQueryLog::Submit(Entry entry) {
+    {
+        std::lock_guard lock{mutex_};
+        if (pending_.size() >= MAX_PENDING) {
+            ++dropped_;
+            return;
+        }
+        pending_.push_back(std::move(entry));
+    }
+    cond_var_.notify_one();
+}
+
+void SlowQueryLog::Run() {
+    std::unique_lock lock{mutex_};
+    for (;;) {
+        cond_var_.wait(lock, [this] {
+            return stopping_ || !pending_.empty() || dropped_ != 0;
+        });
+        if (dropped_ != 0) {
+            *output_ << "slow query log: "sv << std::exchange(dropped_, 0) << " entries dropped"sv << std::endl;
+        }
+        if (pending_.empty()) {
+            if (stopping_) {
+                return;
+            }
+            continue;
+        }
+        Entry entry = std::move(pending_.front());
+        pending_.pop_front();
+        lock.unlock();
+        Write(entry);
+        lock.lock();
+    }
+}
+
+/* slow query: show_books_page 152.3 ms, 20 rows
+ *   $1 = 'Title', $2 = NULL */
+void SlowQueryLog::Write(const Entry& entry) {
+    *output_ << "slow query: "sv << entry.statement << ' ' << std::fixed << std::setprecision(1)
+             << std::chrono::duration<double, std::milli>{entry.duration}.count() << " ms, "sv << entry.rows
+             << " rows"sv << '\n';
+    for (size_t i = 0; i < entry.params.size(); ++i) {
+        *output_ << (i == 0 ? "  "sv : ", "sv) << '$' << i + 1 << " = "sv;
+        if (entry.params[i]) {
+            *output_ << std::quoted(*entry.params[i], '\'', '\'');
+        } else {
+            *output_ << "NULL"sv;
+        }
+    }
+    if (!entry.params.empty()) {
+        *output_ << '\n';
+    }
+    if (explain_ && entry.explain != Explain::NONE) {
+        WritePlan(entry);
+    }
+    output_->flush();
+}
+
+void SlowQueryLog::WritePlan(const Entry& entry) {
+    try {
+        if (!explain_connection_ || !explain_connection_->is_open()) {
+            explain_connection_ = connection_factory_();
+        }
+        pqxx::work work{*explain_connection_};
+        std::string query = (entry.explain == Explain::ANALYZE ? "EXPLAIN (ANALYZE, BUFFERS) EXECUTE "s
+                                                                : "EXPLAIN EXECUTE "s)
+                            + entry.statement;
+        for (size_t i = 0; i < entry.params.size(); ++i) {
+            query += i == 0 ? "("sv : ", "sv;
+            query += entry.params[i] ? work.quote(*entry.params[i]) : "NULL"s;
+        }
+        if (!entry.params.empty()) {
+            query += ')';
+        }
+        for (const auto& row : work.exec(query)) {
+            *output_ << "    "sv << row[0].view() << '\n';
+        }
+        // Транзакция откатывается: повторно выполненный читающий запрос не оставляет следов
+    } catch (const std::exception& e) {
+        *output_ << "    EXPLAIN failed: "sv << e.what() << '\n';
+    }
+}
+
+}  // namespace postgres
@@ -0,0 +1,89 @@
+/*
+ * Журнал медленных запросов.
+ * UnitOfWork замеряет каждый подготовленный запрос и передаёт журналу те, что выполнялись
+ * не меньше порога: имя запроса, параметры, длительность и число строк.
+ * Запись в журнал и получение плана выполняются в отдельном потоке, команда его не ждёт.
+ * План читающего запроса (EXPLAIN (ANALYZE, BUFFERS)) получается на собственном соединении журнала
+ * повторным выполнением запроса с теми же параметрами в транзакции, которая затем откатывается.
+ * Изменяющие запросы не выполняются повторно: для них выводится только план (EXPLAIN), иначе
+ * они блокировали бы затронутые строки и проверяли ограничения на время замера.
+ * Если поток журнала не успевает, новые записи отбрасываются, их число выводится в журнал.
+ */
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "connection_pool.h"
+
+namespace postgres {
+
+struct SlowQueryLogConfig {
+    std::optional<std::chrono::microseconds> threshold;  // не задан - журнал отключён
+    std::string file;  // пустой - журнал выводится в std::cerr
+    bool explain = false;
+};
+
+class SlowQueryLog {
+public:
+    /* Не больше стольких записей ожидают записи в журнал */
+    static constexpr size_t MAX_PENDING = 1'000;
+
+    /* Как получать план запроса */
+    enum class Explain {
+        ANALYZE,  // повторное выполнение с замером: только для читающих запросов
+        PLAN,     // план без выполнения
+        NONE      // план не получается, например, запрос читает временную таблицу своего соединения
+    };
+
+    struct Entry {
+        std::string statement;
+        std::vector<std::optional<std::string>> params;  // nullopt - NULL
+        std::chrono::nanoseconds duration;
+        size_t rows = 0;
+        Explain explain = Explain::ANALYZE;
+    };
+
+    /* connection_factory создаёт соединение с подготовленными запросами для получения планов */
+    SlowQueryLog(SlowQueryLogConfig config, ConnectionPool::ConnectionFactory connection_factory);
+
+    SlowQueryLog(const SlowQueryLog&) = delete;
+    SlowQueryLog& operator=(const SlowQueryLog&) = delete;
+
+    /* Дожидается записи принятых запросов */
+    ~SlowQueryLog();
+
+    bool IsSlow(std::chrono::nanoseconds duration) const noexcept {
+        return threshold_ && duration >= *threshold_;
+    }
+
+    void Submit(Entry entry);
+
+private:
+    void Run();
+    void Write(const Entry& entry);
+    void WritePlan(const Entry& entry);
+
+    const std::optional<std::chrono::nanoseconds> threshold_;
+    const bool explain_;
+    ConnectionPool::ConnectionFactory connection_factory_;
+    std::shared_ptr<pqxx::connection> explain_connection_;
+    std::unique_ptr<std::ostream> file_;
+    std::ostream* output_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_var_;
+    std::deque<Entry> pending_;
+    size_t dropped_ = 0;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+}  // namespace postgres
@@ -0,0 +1,55 @@
+/*
+ * Преобразование util::TaggedUUID в параметры запросов libpqxx и обратно.
+ * Идентификаторы передаются и читаются напрямую, например row[0].as<domain::BookId>(),
+ * без промежуточных std::string
+ */
+#pragma once
+#include <pqxx/except>
+#include <pqxx/strconv>
+
+#include "../util/tagged_uuid.h"
+
+namespace pqxx {
+
+template <typename Tag>
+struct nullness<util::TaggedUUID<Tag>> : no_null<util::TaggedUUID<Tag>> {};
+
+template <typename Tag>
+struct string_traits<util::TaggedUUID<Tag>> {
+    using UUID = util::TaggedUUID<Tag>;
+
+    static constexpr bool converts_to_string{true};
+    static constexpr bool converts_from_string{true};
+
+    static UUID from_string(std::string_view text) {
+        try {
+            return UUID{util::detail::UUIDFromString(text)};
+        } catch (const std::runtime_error&) {
+            throw conversion_error{"Invalid UUID: " + std::string{text}};
+        }
+    }
+
+    static char* into_buf(char* begin, char* end, const UUID& value) {
+        if (end - begin < static_cast<std::ptrdiff_t>(size_buffer(value))) {
+            throw conversion_overrun{"Not enough buffer space to store UUID"};
+        }
+        char* stop = util::detail::UUIDToChars(*value, begin);
+        *stop++ = '\0';
+        return stop;
+    }
+
+    static zview to_buf(char* begin, char* end, const UUID& value) {
+        char* stop = into_buf(begin, end, value);
+        return zview{begin, static_cast<std::size_t>(stop - begin - 1)};
+    }
+
+    static constexpr std::size_t size_buffer(const UUID&) noexcept {
+        return util::detail::UUID_STRING_SIZE + 1;
+    }
+};
+
+/* В тексте UUID нет символов, требующих кавычек в массивах и потоках COPY */
+template <typename Tag>
+inline constexpr bool is_unquoted_safe<util::TaggedUUID<Tag>>{true};
+
+}  // namespace pqxx
@@ -0,0 +1,193 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+using namespace std::literals;
+
+namespace stats {
+
+namespace {
+
+class Registry {
+public:
+    Metric& Get(std::string_view name) {
+        std::lock_guard lock{mutex_};
+        if (const auto it = metrics_.find(name); it != metrics_.end()) {
+            return it->second;
+        }
+        return metrics_.try_emplace(std::string{name}, std::string{name}).first->second;
+    }
+
+    template <typename Visitor>
+    void ForEach(Visitor&& visitor) {
+        std::lock_guard lock{mutex_};
+        for (auto& [name, metric] : metrics_) {
+            visitor(metric);
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    // Узлы std::map не перемещаются, поэтому выданные ссылки остаются действительными
+    std::map<std::string, Metric, std::less<>> metrics_;
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+}  // namespace
+
+Metric::Metric(std::string name)
+    : name_{std::move(name)} {
+}
+
+size_t Metric::BucketIndex(uint64_t nanoseconds) noexcept {
+    if (nanoseconds < SUB_BUCKETS) {
+        return nanoseconds;
+    }
+    if (nanoseconds >= uint64_t{1} << MAX_EXPONENT) {
+        return BUCKETS - 1;
+    }
+    // Старшая единица и SUB_BUCKET_BITS следующих битов определяют корзину
+    const size_t shift = std::bit_width(nanoseconds) - 1 - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((nanoseconds >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint64_t Metric::BucketUpperBound(size_t index) noexcept {
+    const size_t group = index / SUB_BUCKETS;
+    const uint64_t sub_bucket = index % SUB_BUCKETS;
+    if (group == 0) {
+        return sub_bucket;
+    }
+    const size_t shift = group - 1;
+    return ((SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+}
+
+void Metric::Record(std::chrono::nanoseconds duration, bool failed) noexcept {
+    const uint64_t ns = std::max<int64_t>(duration.count(), 0);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    if (failed) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    total_ns_.fetch_add(ns, std::memory_order_relaxed);
+    buckets_[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = max_ns_.load(std::memory_order_relaxed);
+    while (ns > max && !max_ns_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+/* Счётчики читаются по отдельности, поэтому снимок во время записи может быть
+ * не согласован на несколько последних вызовов */
+Metric::Snapshot Metric::GetSnapshot() const {
+    Snapshot snapshot;
+    snapshot.name = name_;
+    snapshot.count = count_.load(std::memory_order_relaxed);
+    snapshot.errors = errors_.load(std::memory_order_relaxed);
+    snapshot.total = std::chrono::nanoseconds{total_ns_.load(std::memory_order_relaxed)};
+    snapshot.max = std::chrono::nanoseconds{max_ns_.load(std::memory_order_relaxed)};
+    snapshot.buckets.reserve(BUCKETS);
+    for (const auto& bucket : buckets_) {
+        snapshot.buckets.push_back(bucket.load(std::memory_order_relaxed));
+    }
+    return snapshot;
+}
+
+void Metric::Reset() noexcept {
+    count_.store(0, std::memory_order_relaxed);
+    errors_.store(0, std::memory_order_relaxed);
+    total_ns_.store(0, std::memory_order_relaxed);
+    max_ns_.store(0, std::memory_order_relaxed);
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::chrono::nanoseconds Metric::Snapshot::Percentile(double percentile) const {
+    uint64_t recorded = 0;
+    for (const uint64_t bucket : buckets) {
+        recorded += bucket;
+    }
+    if (recorded == 0) {
+        return {};
+    }
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100 * recorded)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // Граница корзины не может быть больше наибольшей записанной длительности
+            return std::min(std::chrono::nanoseconds{BucketUpperBound(i)}, max);
+        }
+    }
+    return max;
+}
+
+std::chrono::nanoseconds Metric::Snapshot::Mean() const {
+    return count == 0 ? std::chrono::nanoseconds{} : total / static_cast<int64_t>(count);
+}
+
+Metric& GetMetric(std::string_view name) {
+    return GetRegistry().Get(name);
+}
+
+std::vector<Metric::Snapshot> GetSnapshots() {
+    std::vector<Metric::Snapshot> snapshots;
+    GetRegistry().ForEach([&snapshots](const Metric& metric) {
+        auto snapshot = metric.GetSnapshot();
+        if (snapshot.count != 0) {
+            snapshots.push_back(std::move(snapshot));
+        }
+    });
+    return snapshots;
+}
+
+void ResetAll() noexcept {
+    GetRegistry().ForEach([](Metric& metric) {
+        metric.Reset();
+    });
+}
+
+void WriteReport(std::ostream& output) {
+    const auto snapshots = GetSnapshots();
+    if (snapshots.empty()) {
+        output << "No operations recorded"sv << '\n';
+        return;
+    }
+    size_t name_width = "Operation"sv.size();
+    for (const auto& snapshot : snapshots) {
+        name_width = std::max(name_width, snapshot.name.size());
+    }
+
+    const auto old_flags = output.flags();
+    const auto old_precision = output.precision();
+    auto microseconds = [](std::chrono::nanoseconds duration) {
+        return std::chrono::duration<double, std::micro>{duration}.count();
+    };
+    output << std::left << std::setw(name_width + 1) << "Operation"sv << std::right << std::setw(10) << "Count"sv
+           << std::setw(8) << "Errors"sv;
+    for (const auto column : {"Mean, us"sv, "p50"sv, "p90"sv, "p99"sv, "p99.9"sv, "Max"sv}) {
+        output << std::setw(11) << column;
+    }
+    output << '\n' << std::fixed << std::setprecision(1);
+    for (const auto& snapshot : snapshots) {
+        output << std::left << std::setw(name_width + 1) << snapshot.name << std::right << std::setw(10)
+               << snapshot.count << std::setw(8) << snapshot.errors;
+        for (const auto duration : {snapshot.Mean(), snapshot.Percentile(50), snapshot.Percentile(90),
+                                    snapshot.Percentile(99), snapshot.Percentile(99.9), snapshot.max}) {
+            output << std::setw(11) << microseconds(duration);
+        }
+        output << '\n';
+    }
+    output.flags(old_flags);
+    output.precision(old_precision);
+}
+
+}  // namespace stats
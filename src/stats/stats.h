@@ -0,0 +1,108 @@
+/*
+ * Модуль статистики времени выполнения.
+ * Metric - число вызовов, число ошибок и гистограмма длительностей одной операции
+ * (запроса модуля хранения или команды меню). Счётчики атомарные, запись не берёт блокировок:
+ * длительность относится к корзине гистограммы несколькими битовыми операциями.
+ * Корзины логарифмические, каждая степень двойки делится на SUB_BUCKETS равных частей (как в HdrHistogram),
+ * поэтому относительная погрешность перцентилей не больше 1/SUB_BUCKETS.
+ * Метрики создаются по имени в общем реестре (GetMetric) и живут до конца работы программы.
+ */
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stats {
+
+class Metric {
+public:
+    static constexpr size_t SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+    /* Длительности от 2^MAX_EXPONENT нс (около 18 минут) попадают в последнюю корзину */
+    static constexpr size_t MAX_EXPONENT = 40;
+    static constexpr size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    struct Snapshot {
+        std::string name;
+        uint64_t count = 0;
+        uint64_t errors = 0;
+        std::chrono::nanoseconds total{};
+        std::chrono::nanoseconds max{};
+        std::vector<uint64_t> buckets;
+
+        /* Верхняя граница корзины, в которую попал перцентиль percentile (0..100) */
+        std::chrono::nanoseconds Percentile(double percentile) const;
+        std::chrono::nanoseconds Mean() const;
+    };
+
+    explicit Metric(std::string name);
+
+    Metric(const Metric&) = delete;
+    Metric& operator=(const Metric&) = delete;
+
+    void Record(std::chrono::nanoseconds duration, bool failed) noexcept;
+
+    Snapshot GetSnapshot() const;
+    void Reset() noexcept;
+
+    static size_t BucketIndex(uint64_t nanoseconds) noexcept;
+    /* Наибольшая длительность в нс, попадающая в корзину index */
+    static uint64_t BucketUpperBound(size_t index) noexcept;
+
+private:
+    const std::string name_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> errors_{0};
+    std::atomic<uint64_t> total_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+};
+
+/* Метрика с именем name. При первом обращении создаётся, ссылка действительна до конца работы программы.
+ * Поиск по имени берёт блокировку, поэтому ссылку следует получать один раз и сохранять */
+Metric& GetMetric(std::string_view name);
+
+/* Снимки всех метрик, упорядоченные по имени. Метрики без вызовов пропускаются */
+std::vector<Metric::Snapshot> GetSnapshots();
+
+void ResetAll() noexcept;
+
+/* Таблица: операция, вызовы, ошибки, среднее, p50, p90, p99, p99.9 и максимум в микросекундах */
+void WriteReport(std::ostream& output);
+
+/* Замеряет время жизни объекта. Ошибкой считается выход из области видимости по исключению
+ * или вызов Fail (ошибка, обработанная без исключения) */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Metric& metric) noexcept
+        : metric_{metric}
+        , exceptions_{std::uncaught_exceptions()}
+        , start_{std::chrono::steady_clock::now()} {
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        metric_.Record(std::chrono::steady_clock::now() - start_,
+                       failed_ || std::uncaught_exceptions() > exceptions_);
+    }
+
+    void Fail() noexcept {
+        failed_ = true;
+    }
+
+private:
+    Metric& metric_;
+    int exceptions_;
+    bool failed_ = false;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace stats
@@ -0,0 +1,314 @@
+#include "renderer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <ostream>
+
+using namespace std::literals;
+
+namespace ui {
+
+std::optional<OutputFormat> OutputFormatFromString(std::string_view name) {
+    if (name == "text"sv) {
+        return OutputFormat::TEXT;
+    }
+    if (name == "tsv"sv) {
+        return OutputFormat::TSV;
+    }
+    if (name == "jsonl"sv) {
+        return OutputFormat::JSON_LINES;
+    }
+    return std::nullopt;
+}
+
+Renderer::Renderer(std::ostream& output, OutputFormat format)
+    : output_{output}
+    , format_{format} {
+    buffer_.reserve(BUFFER_SIZE);
+}
+
+Renderer::~Renderer() {
+    try {
+        Flush();
+    } catch (...) {
+    }
+}
+
+void Renderer::AuthorRow(size_t index, std::string_view id, std::string_view name) {
+    BeginRow(Table::AUTHORS, "index\tid\tname"sv);
+    switch (format_) {
+        case OutputFormat::TEXT:
+            AppendNumber(index);
+            Append(' ');
+            Append(name);
+            break;
+        case OutputFormat::TSV:
+            AppendNumber(index);
+            Append('\t');
+            AppendTsvField(id);
+            Append('\t');
+            AppendTsvField(name);
+            break;
+        case OutputFormat::JSON_LINES:
+            AppendJsonKey("index"sv, true);
+            AppendNumber(index);
+            AppendJsonKey("id"sv);
+            AppendJsonString(id);
+            AppendJsonKey("name"sv);
+            AppendJsonString(name);
+            Append('}');
+            break;
+    }
+    EndRow();
+}
+
+void Renderer::AuthorBookRow(size_t index, std::string_view id, std::string_view title, int publication_year) {
+    BeginRow(Table::AUTHOR_BOOKS, "index\tid\ttitle\tpublication_year"sv);
+    switch (format_) {
+        case OutputFormat::TEXT:
+            AppendNumber(index);
+            Append(' ');
+            Append(title);
+            Append(", "sv);
+            AppendNumber(publication_year);
+            break;
+        case OutputFormat::TSV:
+            AppendNumber(index);
+            Append('\t');
+            AppendTsvField(id);
+            Append('\t');
+            AppendTsvField(title);
+            Append('\t');
+            AppendNumber(publication_year);
+            break;
+        case OutputFormat::JSON_LINES:
+            AppendJsonKey("index"sv, true);
+            AppendNumber(index);
+            AppendJsonKey("id"sv);
+            AppendJsonString(id);
+            AppendJsonKey("title"sv);
+            AppendJsonString(title);
+            AppendJsonKey("publication_year"sv);
+            AppendNumber(publication_year);
+            Append('}');
+            break;
+    }
+    EndRow();
+}
+
+void Renderer::BookRow(size_t index, std::string_view id, std::string_view title, std::string_view author_name,
+                       int publication_year) {
+    BeginRow(Table::BOOKS, "index\tid\ttitle\tauthor\tpublication_year"sv);
+    switch (format_) {
+        case OutputFormat::TEXT:
+            AppendNumber(index);
+            Append(' ');
+            Append(title);
+            Append(" by "sv);
+            Append(author_name);
+            Append(", "sv);
+            AppendNumber(publication_year);
+            break;
+        case OutputFormat::TSV:
+            AppendNumber(index);
+            Append('\t');
+            AppendTsvField(id);
+            Append('\t');
+            AppendTsvField(title);
+            Append('\t');
+            AppendTsvField(author_name);
+            Append('\t');
+            AppendNumber(publication_year);
+            break;
+        case OutputFormat::JSON_LINES:
+            AppendJsonKey("index"sv, true);
+            AppendNumber(index);
+            AppendJsonKey("id"sv);
+            AppendJsonString(id);
+            AppendJsonKey("title"sv);
+            AppendJsonString(title);
+            AppendJsonKey("author"sv);
+            AppendJsonString(author_name);
+            AppendJsonKey("publication_year"sv);
+            AppendNumber(publication_year);
+            Append('}');
+            break;
+    }
+    EndRow();
+}
+
+void Renderer::BookDetails(std::string_view id, std::string_view title, std::string_view author_name,
+                           int publication_year, const std::vector<std::string>& tags) {
+    BeginRow(Table::BOOK_DETAILS, "id\ttitle\tauthor\tpublication_year\ttags"sv);
+    switch (format_) {
+        case OutputFormat::TEXT:
+            Append("Title: "sv);
+            Append(title);
+            Append("\nAuthor: "sv);
+            Append(author_name);
+            Append("\nPublication year: "sv);
+            AppendNumber(publication_year);
+            if (!tags.empty()) {
+                Append("\nTags: "sv);
+                for (size_t i = 0; i < tags.size(); ++i) {
+                    if (i != 0) {
+                        Append(", "sv);
+                    }
+                    Append(tags[i]);
+                }
+            }
+            break;
+        case OutputFormat::TSV:
+            AppendTsvField(id);
+            Append('\t');
+            AppendTsvField(title);
+            Append('\t');
+            AppendTsvField(author_name);
+            Append('\t');
+            AppendNumber(publication_year);
+            Append('\t');
+            for (size_t i = 0; i < tags.size(); ++i) {
+                if (i != 0) {
+                    Append(',');
+                }
+                AppendTsvField(tags[i]);
+            }
+            break;
+        case OutputFormat::JSON_LINES:
+            AppendJsonKey("id"sv, true);
+            AppendJsonString(id);
+            AppendJsonKey("title"sv);
+            AppendJsonString(title);
+            AppendJsonKey("author"sv);
+            AppendJsonString(author_name);
+            AppendJsonKey("publication_year"sv);
+            AppendNumber(publication_year);
+            AppendJsonKey("tags"sv);
+            Append('[');
+            for (size_t i = 0; i < tags.size(); ++i) {
+                if (i != 0) {
+                    Append(',');
+                }
+                AppendJsonString(tags[i]);
+            }
+            Append("]}"sv);
+            break;
+    }
+    EndRow();
+}
+
+void Renderer::Flush() {
+    if (!buffer_.empty()) {
+        output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+    output_.flush();
+}
+
+void Renderer::BeginRow(Table table, std::string_view tsv_header) {
+    if (format_ == OutputFormat::TSV && table_ != table) {
+        Append(tsv_header);
+        Append('\n');
+    }
+    table_ = table;
+}
+
+/* Заполненный буфер записывается в поток без сброса */
+void Renderer::EndRow() {
+    Append('\n');
+    if (buffer_.size() >= BUFFER_SIZE) {
+        output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+}
+
+void Renderer::Append(std::string_view text) {
+    buffer_.append(text);
+}
+
+void Renderer::Append(char c) {
+    buffer_.push_back(c);
+}
+
+void Renderer::AppendNumber(size_t value) {
+    char digits[20];
+    const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+    buffer_.append(digits, result.ptr);
+}
+
+void Renderer::AppendTsvField(std::string_view value) {
+    // Обычно экранировать нечего, и значение добавляется целиком
+    if (std::none_of(value.begin(), value.end(), [](char c) {
+            return c == '\t' || c == '\n' || c == '\r' || c == '\\';
+        })) {
+        Append(value);
+        return;
+    }
+    for (const char c : value) {
+        switch (c) {
+            case '\t':
+                Append("\\t"sv);
+                break;
+            case '\n':
+                Append("\\n"sv);
+                break;
+            case '\r':
+                Append("\\r"sv);
+                break;
+            case '\\':
+                Append("\\\\"sv);
+                break;
+            default:
+                Append(c);
+        }
+    }
+}
+
+void Renderer::AppendJsonString(std::string_view value) {
+    constexpr char HEX_DIGITS[]{"0123456789abcdef"};
+    Append('"');
+    if (std::none_of(value.begin(), value.end(), [](char c) {
+            return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+        })) {
+        Append(value);
+        Append('"');
+        return;
+    }
+    for (const char c : value) {
+        switch (c) {
+            case '"':
+                Append("\\\""sv);
+                break;
+            case '\\':
+                Append("\\\\"sv);
+                break;
+            case '\n':
+                Append("\\n"sv);
+                break;
+            case '\r':
+                Append("\\r"sv);
+                break;
+            case '\t':
+                Append("\\t"sv);
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    Append("\\u00"sv);
+                    Append(HEX_DIGITS[c >> 4]);
+                    Append(HEX_DIGITS[c & 0x0f]);
+                } else {
+                    Append(c);
+                }
+        }
+    }
+    Append('"');
+}
+
+void Renderer::AppendJsonKey(std::string_view key, bool first) {
+    Append(first ? '{' : ',');
+    Append('"');
+    Append(key);
+    Append("\":"sv);
+}
+
+}  // namespace ui
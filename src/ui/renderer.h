@@ -0,0 +1,75 @@
+/*
+ * Вывод результатов команд (списки авторов и книг, информация о книге) в выбранном формате:
+ * - TEXT - для чтения человеком, как в интерактивном режиме;
+ * - TSV - строка заголовка и строки значений через табуляцию,
+ *   символы \t, \n, \r и \ в значениях экранируются обратной косой чертой;
+ * - JSON_LINES - по одному JSON-объекту в строке.
+ * Строки накапливаются в буфере и записываются в поток блоками, без сброса (flush)
+ * после каждой строки. Поток сбрасывается в конце команды - вызовом Flush или в деструкторе.
+ */
+#pragma once
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ui {
+
+enum class OutputFormat {
+    TEXT,
+    TSV,
+    JSON_LINES
+};
+
+/* text, tsv или jsonl */
+std::optional<OutputFormat> OutputFormatFromString(std::string_view name);
+
+class Renderer {
+public:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    Renderer(std::ostream& output, OutputFormat format);
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    ~Renderer();
+
+    void AuthorRow(size_t index, std::string_view id, std::string_view name);
+    /* Книга автора в списке его книг */
+    void AuthorBookRow(size_t index, std::string_view id, std::string_view title, int publication_year);
+    void BookRow(size_t index, std::string_view id, std::string_view title, std::string_view author_name,
+                 int publication_year);
+    void BookDetails(std::string_view id, std::string_view title, std::string_view author_name,
+                     int publication_year, const std::vector<std::string>& tags);
+
+    void Flush();
+
+private:
+    enum class Table {
+        NONE,
+        AUTHORS,
+        AUTHOR_BOOKS,
+        BOOKS,
+        BOOK_DETAILS
+    };
+
+    /* Строка заголовка TSV выводится перед первой строкой таблицы */
+    void BeginRow(Table table, std::string_view tsv_header);
+    void EndRow();
+
+    void Append(std::string_view text);
+    void Append(char c);
+    void AppendNumber(size_t value);
+    void AppendTsvField(std::string_view value);
+    void AppendJsonString(std::string_view value);
+    void AppendJsonKey(std::string_view key, bool first = false);
+
+    std::ostream& output_;
+    OutputFormat format_;
+    Table table_ = Table::NONE;
+    std::string buffer_;
+};
+
+}  // namespace ui
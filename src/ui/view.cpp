@@ -3,11 +3,18 @@
 #include <algorithm>
 #include <boost/algorithm/string/trim.hpp>
 #include <cassert>
+#include <fstream>
+#include <future>
 #include <iostream>
 #include <set>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 #include <utility>
 
+#include "../app/async_runner.h"
 #include "../app/use_cases.h"
+#include "../domain/author.h"
 #include "../menu/menu.h"
 
 using namespace std::literals;
@@ -21,16 +28,15 @@ std::ostream& operator<<(std::ostream& out, const AuthorInfo& author) {
     return out;
 }
 
-std::ostream& operator<<(std::ostream& out, const BookInfo& book) {
-    out << book.title << ", " << book.publication_year;
-    return out;
-}
-
 std::ostream& operator<<(std::ostream& out, const BookFullInfo& book) {
     out << book.title << " by " << book.author_name << ", " << book.publication_year;
     return out;
 }
 
+std::ostream& operator<<(std::ostream& out, const FoundBook& found) {
+    return out << found.book;
+}
+
 }  // namespace detail
 
 std::ostream &operator<<(std::ostream &out, const std::vector<std::string> &tags) {
@@ -47,22 +53,154 @@ std::ostream &operator<<(std::ostream &out, const std::vector<std::string> &tags
 }
 
 template <typename T>
-void PrintVector(std::ostream& out, const std::vector<T>& vector) {
-    int i = 1;
+void PrintVector(std::ostream& out, const std::vector<T>& vector, size_t first_index = 1) {
+    size_t i = first_index;
     for (auto& value : vector) {
-        out << i++ << " " << value << std::endl;
+        out << i++ << " " << value << '\n';
+    }
+}
+
+/* Фоновые запросы страниц: runner их выполняет, use_cases - читает в снимке потока команды */
+struct Prefetch {
+    app::AsyncRunner* runner;
+    app::UseCases& use_cases;
+};
+
+/* Запрос страницы: в фоне, если задан prefetch.runner, иначе - при получении результата.
+ * Фоновый запрос читает в снимке потока, поставившего его, остальные потоки читают вне снимка */
+template <typename Cursor, typename FetchPage>
+auto FetchPageAsync(const Prefetch& prefetch, FetchPage& fetch_page, std::optional<Cursor> cursor, size_t limit) {
+    if (prefetch.runner) {
+        return prefetch.runner->Submit([&use_cases = prefetch.use_cases, owner = std::this_thread::get_id(),
+                                        &fetch_page, cursor = std::move(cursor), limit] {
+            app::AttachedReadScope read{use_cases, owner};
+            return fetch_page(cursor, limit);
+        });
+    }
+    auto task = [&fetch_page, cursor = std::move(cursor), limit] {
+        return fetch_page(cursor, limit);
+    };
+    return app::Pending<std::invoke_result_t<decltype(task)>>{std::async(std::launch::deferred, std::move(task))};
+}
+
+/* Постраничный обход списка (keyset pagination): следующая страница запрашивается
+ * с курсором, построенным по последнему элементу предыдущей, пока выводится текущая */
+template <typename Cursor, typename FetchPage, typename MakeCursor, typename Visitor>
+void ForEachPage(const Prefetch& prefetch, size_t page_size, FetchPage fetch_page, MakeCursor make_cursor,
+                 Visitor visitor) {
+    auto next_page = FetchPageAsync<Cursor>(prefetch, fetch_page, std::nullopt, page_size);
+    for (;;) {
+        auto page = next_page.Get();
+        const bool is_last_page = page.size() < page_size;
+        if (!is_last_page) {
+            next_page = FetchPageAsync<Cursor>(prefetch, fetch_page, make_cursor(page.back()), page_size);
+        }
+        for (const auto& item : page) {
+            visitor(item);
+        }
+        if (is_last_page) {
+            break;
+        }
     }
 }
 
-void PrintFullInfoOfBook(std::ostream& out, const detail::BookFullInfo& book_info) {
-    out << "Title: "sv << book_info.title << std::endl;
-    out << "Author: "sv << book_info.author_name << std::endl;
-    out << "Publication year: "sv << book_info.publication_year << std::endl;
-    if (!book_info.tags.empty()) {
-        out << "Tags: "sv << book_info.tags << std::endl;
+/* Выбор элемента из постраничного списка. Номера элементов сквозные.
+ * Если страниц несколько, вводом n и p можно перейти на следующую и предыдущую страницу.
+ * Следующая страница запрашивается, пока пользователь читает текущую. Ответ читается read_answer
+ * после получения этой страницы: пока ответ не введён, снимок чтения не открыт (см. View::ReadAnswer) */
+template <typename Cursor, typename FetchPage, typename MakeCursor, typename ReadAnswer>
+auto SelectFromPages(const Prefetch& prefetch, ReadAnswer read_answer, std::ostream& output,
+                     std::string_view prompt, size_t page_size, FetchPage fetch_page, MakeCursor make_cursor)
+        -> std::optional<typename std::invoke_result_t<FetchPage, const std::optional<Cursor>&, size_t>::value_type> {
+    std::vector<std::optional<Cursor>> page_cursors{std::nullopt};
+    auto next_page = FetchPageAsync<Cursor>(prefetch, fetch_page, std::nullopt, page_size + 1);
+    for (;;) {
+        auto page = next_page.IsValid() ? next_page.Get() : fetch_page(page_cursors.back(), page_size + 1);
+        const bool has_next_page = page.size() > page_size;
+        if (has_next_page) {
+            page.pop_back();
+        }
+        const bool has_prev_page = page_cursors.size() > 1;
+        const size_t first_index = (page_cursors.size() - 1) * page_size + 1;
+        PrintVector(output, page, first_index);
+        if (has_next_page || has_prev_page) {
+            output << "Enter n for next page or p for previous page"sv << std::endl;
+        }
+        output << prompt << std::endl;
+        if (has_next_page) {
+            next_page = FetchPageAsync<Cursor>(prefetch, fetch_page, make_cursor(page.back()), page_size + 1);
+            next_page.Wait();
+        }
+
+        std::string str;
+        if (!read_answer(str) || str.empty()) {
+            return std::nullopt;
+        }
+        if (str == "n"sv && has_next_page) {
+            page_cursors.push_back(make_cursor(page.back()));
+            continue;
+        }
+        if (str == "p"sv && has_prev_page) {
+            page_cursors.pop_back();
+            next_page = {};
+            continue;
+        }
+
+        int idx;
+        try {
+            idx = std::stoi(str);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Invalid item num");
+        }
+        if (idx < static_cast<int>(first_index) || idx >= static_cast<int>(first_index + page.size())) {
+            throw std::runtime_error("Invalid item num");
+        }
+        return std::move(page[idx - first_index]);
     }
 }
 
+domain::AuthorBookPageCursor MakeAuthorBookPageCursor(const detail::BookInfo& book) {
+    return {static_cast<uint64_t>(book.publication_year), book.title, domain::BookId::FromString(book.id)};
+}
+
+domain::BookSearchCursor MakeBookSearchCursor(const detail::FoundBook& found) {
+    return {found.rank, domain::BookId::FromString(found.book.id)};
+}
+
+detail::BookFullInfo ToBookFullInfo(domain::BookWithAuthor&& book_with_author) {
+    const domain::Book& book = book_with_author.GetBook();
+    return {book.GetId().ToString(),
+            book.GetAuthorId().ToString(),
+            book.GetTitle(),
+            static_cast<int>(book.GetPublicationYear()),
+            book_with_author.GetAuthorName(),
+            book.GetTags()};
+}
+
+domain::BookPageCursor MakeBookPageCursor(const detail::BookFullInfo& book) {
+    return {book.title, book.author_name, static_cast<uint64_t>(book.publication_year),
+            domain::BookId::FromString(book.id)};
+}
+
+/* Вывод нумерованного списка книг, получаемого от fetch_page постранично */
+template <typename FetchPage>
+void PrintBooks(const Prefetch& prefetch, Renderer& renderer, size_t page_size, FetchPage fetch_page) {
+    size_t index = 1;
+    ForEachPage<domain::BookPageCursor>(
+        prefetch, page_size,
+        [&fetch_page](const std::optional<domain::BookPageCursor>& after, size_t limit) {
+            std::vector<detail::BookFullInfo> books;
+            for (auto& book : fetch_page(after, limit)) {
+                books.emplace_back(ToBookFullInfo(std::move(book)));
+            }
+            return books;
+        },
+        MakeBookPageCursor,
+        [&renderer, &index](const detail::BookFullInfo& book) {
+            renderer.BookRow(index++, book.id, book.title, book.author_name, book.publication_year);
+        });
+}
+
 std::vector<std::string> SplitIntoWords(const std::string& text, char delim) {
     const size_t max_len_of_tag = 30;
     std::set<std::string> words;
@@ -90,11 +228,14 @@ std::vector<std::string> SplitIntoWords(const std::string& text, char delim) {
     return {words.begin(), words.end()};
 }
 
-View::View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std::ostream& output)
+View::View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std::ostream& output,
+           OutputFormat format, app::AsyncRunner* async_runner)
     : menu_{menu}
     , use_cases_{use_cases}
     , input_{input}
-    , output_{output} {
+    , output_{output}
+    , format_{format}
+    , async_runner_{async_runner} {
     menu_.AddAction(  //
         "AddAuthor"s, "name"s, "Adds author"s, std::bind(&View::AddAuthor, this, ph::_1)
         // ����
@@ -116,6 +257,18 @@ View::View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std:
                     std::bind(&View::DeleteBook, this, ph::_1));
     menu_.AddAction("EditBook"s, "<title>"s, "Edit book"s,
                     std::bind(&View::EditBook, this, ph::_1));
+    menu_.AddAction("ShowBooksByTag"s, "<tag>"s, "Show books with the tag"s,
+                    std::bind(&View::ShowBooksByTag, this, ph::_1));
+    menu_.AddAction("ShowBooksByTags"s, "<any|all> <tags>"s, "Show books with any or all of comma separated tags"s,
+                    std::bind(&View::ShowBooksByTags, this, ph::_1));
+    menu_.AddAction("SearchBooks"s, "<query>"s, "Search books by title, author or tag fragments"s,
+                    std::bind(&View::SearchBooks, this, ph::_1));
+    menu_.AddAction("ImportCatalog"s, "<file> [<batch size>]"s, "Import books from CSV or NDJSON file"s,
+                    std::bind(&View::ImportCatalog, this, ph::_1));
+    menu_.AddAction("ExportCatalog"s, "<file>"s, "Export books to CSV or NDJSON file"s,
+                    std::bind(&View::ExportCatalog, this, ph::_1));
+    menu_.AddAction("OutputFormat"s, "<text|tsv|jsonl>"s, "Set output format of lists and book info"s,
+                    std::bind(&View::SetOutputFormat, this, ph::_1));
 }
 
 bool View::AddAuthor(std::istream& cmd_input) const {
@@ -126,8 +279,11 @@ bool View::AddAuthor(std::istream& cmd_input) const {
         if (name.empty()) {
             throw std::runtime_error("Empty author"s);
         }
+        app::WorkScope work{use_cases_};
         use_cases_.AddAuthor(std::move(name));
+        work.Commit();
     } catch (const std::exception&) {
+        menu_.ReportFailure();
         output_ << "Failed to add author"sv << std::endl;
     }
     return true;
@@ -135,6 +291,7 @@ bool View::AddAuthor(std::istream& cmd_input) const {
 
 bool View::DeleteAuthor(std::istream& cmd_input) const {
     try {
+        app::WorkScope work{use_cases_};
         auto author = GetAuthorParams(cmd_input);
         if (author.first == detail::AuthorEnteredAs::NAME) {
             use_cases_.DeleteAuthorByName(author.second);
@@ -143,7 +300,9 @@ bool View::DeleteAuthor(std::istream& cmd_input) const {
         } else {
             throw std::runtime_error("Author not found"s);
         }
+        work.Commit();
     } catch(const std::exception&) {
+        menu_.ReportFailure();
         output_ << "Failed to delete author"sv << std::endl;
     }
     return true;
@@ -151,6 +310,7 @@ bool View::DeleteAuthor(std::istream& cmd_input) const {
 
 bool View::EditAuthor(std::istream &cmd_input) const {
     try {
+        app::WorkScope work{use_cases_};
         auto author = GetAuthorParams(cmd_input);
         if (author.first == detail::AuthorEnteredAs::REJECT) {
             return true;
@@ -160,7 +320,7 @@ bool View::EditAuthor(std::istream &cmd_input) const {
         }
         output_ << "Enter new name:"sv << std::endl;
         std::string new_name;
-        std::getline(input_, new_name);
+        ReadAnswer(new_name);
         boost::algorithm::trim(new_name);
         if (new_name.empty()) {
             throw std::runtime_error("Empty author"s);
@@ -170,7 +330,9 @@ bool View::EditAuthor(std::istream &cmd_input) const {
         } else {
             use_cases_.EditAuthorByID(author.second, new_name);
         }
+        work.Commit();
     } catch (const std::exception &) {
+        menu_.ReportFailure();
         output_ << "Failed to edit author"sv << std::endl;
     }
     return true;
@@ -193,25 +355,31 @@ std::pair<detail::AuthorEnteredAs, std::string> View::GetAuthorParams(std::istre
 }
 
 void View::CheckAuthorPresenceByName(const std::string& author_name) const {
-    auto authors = GetAuthors();
-    auto it = std::find_if(authors.begin(), authors.end(),
-                [&author_name] (const detail::AuthorInfo& author) {
-                    return (author.name == author_name);
-                });
-    if (it == authors.end()) {
+    if (!FindAuthorIdByName(author_name)) {
         throw std::runtime_error("No such author"s);
     }
 }
 
+std::optional<std::string> View::FindAuthorIdByName(const std::string& author_name) const {
+    try {
+        return use_cases_.GetAuthorID(author_name);
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
 bool View::AddBook(std::istream& cmd_input) const {
     try {
+        app::WorkScope work{use_cases_};
         if (auto params = GetBookParams(cmd_input)) {
             use_cases_.AddBook(params->author_id,
                                params->title,
                                params->publication_year,
                                params->tags);
         }
+        work.Commit();
     } catch (const std::exception&) {
+        menu_.ReportFailure();
         output_ << "Failed to add book"sv << std::endl;
     }
     return true;
@@ -224,17 +392,18 @@ bool View::AddBook(std::istream& cmd_input) const {
  * 4) Если с указанным названием найдено несколько книг, предлагаем выбрать какую удалить */
 bool View::DeleteBook(std::istream& cmd_input) const {
     try {
+        app::WorkScope work{use_cases_};
         std::string title;
         std::getline(cmd_input, title);
         if (title.empty()) {
             if (auto id = SelectBook()) {
                 use_cases_.DeleteBook(id.value());
-                return true;
             }
         } else {
             boost::algorithm::trim(title);
             auto books = GetBookByTitle(title);
             if(books.size() == 0) {
+                menu_.ReportFailure();
                 output_ << "Book not found"s << std::endl;
             } else if (books.size() == 1) {
                 use_cases_.DeleteBook(books[0].id);
@@ -244,7 +413,9 @@ bool View::DeleteBook(std::istream& cmd_input) const {
                 }
             }
         }
+        work.Commit();
     } catch(const std::exception&) {
+        menu_.ReportFailure();
         output_ << "Failed to delete book"sv << std::endl;
     }
     return true;
@@ -252,6 +423,7 @@ bool View::DeleteBook(std::istream& cmd_input) const {
 
 bool View::EditBook(std::istream& cmd_input) const {
     try {
+        app::WorkScope work{use_cases_};
         detail::BookFullInfo new_book;
         std::string title;
         std::getline(cmd_input, title);
@@ -280,34 +452,184 @@ bool View::EditBook(std::istream& cmd_input) const {
                             new_book.title,
                             new_book.publication_year,
                             new_book.tags);
+        work.Commit();
     } catch(const std::exception&) {
+        menu_.ReportFailure();
         output_ << "Book not found"sv << std::endl;
     }
     return true;
 }
 
+/* Массовый импорт каталога из файла .csv, .ndjson или .jsonl.
+ * Книги фиксируются пакетами, размер пакета можно указать вторым аргументом */
+bool View::ImportCatalog(std::istream& cmd_input) const {
+    try {
+        std::string file_name;
+        if (!(cmd_input >> file_name)) {
+            throw std::runtime_error("File name is empty"s);
+        }
+        size_t batch_size = DEFAULT_IMPORT_BATCH_SIZE;
+        if (std::string batch_size_str; cmd_input >> batch_size_str) {
+            batch_size = std::stoul(batch_size_str);
+        }
+        auto format = app::CatalogFormatFromFileName(file_name);
+        if (!format) {
+            throw std::runtime_error("Unknown catalog format"s);
+        }
+        std::ifstream file{file_name};
+        if (!file) {
+            throw std::runtime_error("Failed to open file"s);
+        }
+        const size_t imported = use_cases_.ImportCatalog(file, *format, batch_size);
+        output_ << "Imported "sv << imported << " books"sv << std::endl;
+    } catch (const std::exception&) {
+        menu_.ReportFailure();
+        output_ << "Failed to import catalog"sv << std::endl;
+    }
+    return true;
+}
+
+/* Экспорт каталога в файл .csv, .ndjson или .jsonl */
+bool View::ExportCatalog(std::istream& cmd_input) const {
+    try {
+        std::string file_name;
+        if (!(cmd_input >> file_name)) {
+            throw std::runtime_error("File name is empty"s);
+        }
+        auto format = app::CatalogFormatFromFileName(file_name);
+        if (!format) {
+            throw std::runtime_error("Unknown catalog format"s);
+        }
+        std::ofstream file{file_name};
+        if (!file) {
+            throw std::runtime_error("Failed to open file"s);
+        }
+        const size_t exported = use_cases_.ExportCatalog(file, *format);
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Failed to write file"s);
+        }
+        output_ << "Exported "sv << exported << " books"sv << std::endl;
+    } catch (const std::exception&) {
+        menu_.ReportFailure();
+        output_ << "Failed to export catalog"sv << std::endl;
+    }
+    return true;
+}
+
 bool View::ShowAuthors() const {
-    PrintVector(output_, GetAuthors());
+    app::ReadScope snapshot{use_cases_};
+    Renderer renderer{output_, format_};
+    size_t index = 1;
+    ForEachPage<std::string>(
+        Prefetch{async_runner_, use_cases_}, LIST_PAGE_SIZE,
+        [this](const std::optional<std::string>& after, size_t limit) {
+            return GetAuthorsPage(after, limit);
+        },
+        [](const detail::AuthorInfo& author) {
+            return author.name;
+        },
+        [&renderer, &index](const detail::AuthorInfo& author) {
+            renderer.AuthorRow(index++, author.id, author.name);
+        });
     return true;
 }
 
 bool View::ShowBooks() const {
-    PrintVector(output_, GetBooks());
+    app::ReadScope snapshot{use_cases_};
+    Renderer renderer{output_, format_};
+    PrintBooks(Prefetch{async_runner_, use_cases_}, renderer, LIST_PAGE_SIZE,
+               [this](const std::optional<domain::BookPageCursor>& after, size_t limit) {
+                   return use_cases_.ShowBooksPage(after, limit);
+               });
+    return true;
+}
+
+/* Книги с тегом. Тег нормализуется так же, как при добавлении книги */
+bool View::ShowBooksByTag(std::istream& cmd_input) const {
+    try {
+        app::ReadScope snapshot{use_cases_};
+        std::string tag_raw;
+        std::getline(cmd_input, tag_raw);
+        auto tags = SplitIntoWords(tag_raw, ',');
+        if (tags.size() != 1) {
+            throw std::runtime_error("Exactly one tag expected"s);
+        }
+        Renderer renderer{output_, format_};
+        PrintBooks(Prefetch{async_runner_, use_cases_}, renderer, LIST_PAGE_SIZE,
+                   [this, &tags](const std::optional<domain::BookPageCursor>& after, size_t limit) {
+                       return use_cases_.ShowBooksByTag(tags.front(), after, limit);
+                   });
+    } catch (const std::exception&) {
+        menu_.ReportFailure();
+        output_ << "Failed to show books"sv << std::endl;
+    }
+    return true;
+}
+
+/* Книги с любым (any) или со всеми (all) тегами из списка через запятую */
+bool View::ShowBooksByTags(std::istream& cmd_input) const {
+    try {
+        app::ReadScope snapshot{use_cases_};
+        std::string match_str;
+        cmd_input >> match_str;
+        domain::TagMatch match;
+        if (match_str == "any"sv) {
+            match = domain::TagMatch::ANY;
+        } else if (match_str == "all"sv) {
+            match = domain::TagMatch::ALL;
+        } else {
+            throw std::runtime_error("Tag match must be any or all"s);
+        }
+        std::string tags_raw;
+        std::getline(cmd_input, tags_raw);
+        auto tags = SplitIntoWords(tags_raw, ',');
+        if (tags.empty()) {
+            throw std::runtime_error("No tags"s);
+        }
+        Renderer renderer{output_, format_};
+        PrintBooks(Prefetch{async_runner_, use_cases_}, renderer, LIST_PAGE_SIZE,
+                   [this, &tags, match](const std::optional<domain::BookPageCursor>& after, size_t limit) {
+                       return use_cases_.ShowBooksByTags(tags, match, after, limit);
+                   });
+    } catch (const std::exception&) {
+        menu_.ReportFailure();
+        output_ << "Failed to show books"sv << std::endl;
+    }
     return true;
 }
 
+void View::PrintAuthorBooks(const std::string& author_id) const {
+    Renderer renderer{output_, format_};
+    size_t index = 1;
+    ForEachPage<domain::AuthorBookPageCursor>(
+        Prefetch{async_runner_, use_cases_}, LIST_PAGE_SIZE,
+        [this, &author_id](const std::optional<domain::AuthorBookPageCursor>& after, size_t limit) {
+            return GetAuthorBooksPage(author_id, after, limit);
+        },
+        MakeAuthorBookPageCursor,
+        [&renderer, &index](const detail::BookInfo& book) {
+            renderer.AuthorBookRow(index++, book.id, book.title, book.publication_year);
+        });
+}
+
+void View::PrintFullInfoOfBook(const detail::BookFullInfo& book) const {
+    Renderer renderer{output_, format_};
+    renderer.BookDetails(book.id, book.title, book.author_name, book.publication_year, book.tags);
+}
+
 bool View::ShowAuthorBooks(std::istream& cmd_input) const {
     try {
+        app::ReadScope snapshot{use_cases_};
         std::string title;
         std::getline(cmd_input, title);
         boost::algorithm::trim(title);
         if (title.empty()) {
             if (auto author_id = SelectAuthor()) {
-                PrintVector(output_, GetAuthorBooks(*author_id));
+                PrintAuthorBooks(*author_id);
             }
         } else {
-            std::string author_id = use_cases_.GetAuthorID(title);
-            PrintVector(output_, GetAuthorBooks(author_id));
+            PrintAuthorBooks(use_cases_.GetAuthorID(title));
         }
     } catch (const std::exception&) {
         throw std::runtime_error("Failed to Show Books");
@@ -323,26 +645,72 @@ bool View::ShowAuthorBooks(std::istream& cmd_input) const {
  * и выводим её*/
 bool View::ShowBook(std::istream& cmd_input) const {
     try {
+        app::ReadScope snapshot{use_cases_};
         std::string title;
         std::getline(cmd_input, title);
         boost::algorithm::trim(title);
         if (title.empty()) {
             if (auto id = SelectBook()) {
-                PrintFullInfoOfBook(output_, GetBookById(id.value()));
+                PrintFullInfoOfBook(GetBookById(id.value()));
             }
         } else {
             auto books = GetBookByTitle(title);
             if (books.size() == 0) {
                 return true;
             } else if (books.size() == 1) {
-                PrintFullInfoOfBook(output_, books[0]);
+                PrintFullInfoOfBook(books[0]);
             } else {
                 if (auto book_idx = SelectFromBooks(books)) {
-                    PrintFullInfoOfBook(output_, books[book_idx.value()]);
+                    PrintFullInfoOfBook(books[book_idx.value()]);
                 }
             }
         }
-    } catch(const std::exception&) {}
+    } catch(const std::exception&) {
+        menu_.ReportFailure();
+    }
+    return true;
+}
+
+/* Поиск книг по фрагменту названия, имени автора или тега (допускаются опечатки).
+ * Найденные книги выводятся по убыванию релевантности, по выбранной выводится полная информация */
+bool View::SearchBooks(std::istream& cmd_input) const {
+    try {
+        app::ReadScope snapshot{use_cases_};
+        std::string query;
+        std::getline(cmd_input, query);
+        boost::algorithm::trim(query);
+        if (query.empty()) {
+            throw std::runtime_error("Search query is empty"s);
+        }
+        auto found = SelectFromPages<domain::BookSearchCursor>(
+            Prefetch{async_runner_, use_cases_},
+            [this](std::string& answer) {
+                return ReadAnswer(answer);
+            },
+            output_, "Enter the book # or empty line to cancel:"sv, LIST_PAGE_SIZE,
+            [this, &query](const std::optional<domain::BookSearchCursor>& after, size_t limit) {
+                return SearchBooksPage(query, after, limit);
+            },
+            MakeBookSearchCursor);
+        if (found) {
+            PrintFullInfoOfBook(found->book);
+        }
+    } catch (const std::exception&) {
+        menu_.ReportFailure();
+        output_ << "Failed to search books"sv << std::endl;
+    }
+    return true;
+}
+
+bool View::SetOutputFormat(std::istream& cmd_input) {
+    std::string name;
+    cmd_input >> name;
+    if (auto format = OutputFormatFromString(name)) {
+        format_ = *format;
+    } else {
+        menu_.ReportFailure();
+        output_ << "Unknown output format"sv << std::endl;
+    }
     return true;
 }
 
@@ -366,24 +734,20 @@ std::optional<detail::AddBookParams> View::GetBookParams(std::istream& cmd_input
 
     output_ << "Enter author name or empty line to select from list:"sv << std::endl;
     std::string author_name;
-    std::getline(input_, author_name);
+    ReadAnswer(author_name);
     if (!author_name.empty()) {
         boost::algorithm::trim(author_name);
-        auto authors = GetAuthors();
-        auto author_it = std::find_if(authors.begin(), authors.end(),
-                                      [&author_name](const ui::detail::AuthorInfo &author_info) {
-                                          return (author_info.name == author_name);
-                                      });
-        if (author_it == authors.end()) {
+        auto author_id = FindAuthorIdByName(author_name);
+        if (!author_id) {
             output_ << "No author found. Do you want to add "s + author_name + " (y/n)?"s << std::endl;
             std::string answer;
-            std::getline(input_, answer);
+            ReadAnswer(answer);
             if ((answer != "y") && (answer != "Y")) {
                 throw std::runtime_error("There is no author in base"s);
             }
             params.author_id = use_cases_.AddAuthor(std::move(author_name)).ToString();
         } else {
-            params.author_id = author_it->id;
+            params.author_id = std::move(*author_id);
         }
     } else {
         auto author_id = SelectAuthor();
@@ -396,7 +760,7 @@ std::optional<detail::AddBookParams> View::GetBookParams(std::istream& cmd_input
 
     output_ << "Enter tags (comma separated):"sv << std::endl;
     std::string tags_raw;
-    std::getline(input_, tags_raw);
+    ReadAnswer(tags_raw);
     params.tags = SplitIntoWords(tags_raw, ',');
     return params;
 }
@@ -409,7 +773,7 @@ detail::BookFullInfo View::GetEditBookParams(const detail::BookFullInfo& old_boo
     output_ << "Enter new title or empty line to use the current one ("s
             << old_book.title << "):"s << std::endl;
     std::string new_title;
-    std::getline(input_, new_title);
+    ReadAnswer(new_title);
     boost::algorithm::trim(new_title);
     if (!new_title.empty()) {
         new_book.title = std::move(new_title);
@@ -418,7 +782,7 @@ detail::BookFullInfo View::GetEditBookParams(const detail::BookFullInfo& old_boo
     output_ << "Enter publication year or empty line to use the current one ("s
             << old_book.publication_year << "):"s << std::endl;
     std::string new_year;
-    std::getline(input_, new_year);
+    ReadAnswer(new_year);
     boost::algorithm::trim(new_year);
     if (!new_year.empty()) {
         try {
@@ -430,61 +794,55 @@ detail::BookFullInfo View::GetEditBookParams(const detail::BookFullInfo& old_boo
 
     output_ << "Enter tags (current tags: "s << old_book.tags << "):"s << std::endl;
     std::string new_tags;
-    std::getline(input_, new_tags);
+    ReadAnswer(new_tags);
     //if (!new_tags.empty()) {
         new_book.tags = SplitIntoWords(new_tags, ',');
     //}
     return new_book;
 }
 
+/* Пока пользователь вводит ответ, транзакция снимка чтения закрыта: иначе она удерживала бы
+ * соединение пула и мешала очистке старых версий строк. Следующее чтение команды откроет новый снимок */
+bool View::ReadAnswer(std::string& answer) const {
+    use_cases_.ReleaseRead();
+    return static_cast<bool>(std::getline(input_, answer));
+}
+
 std::optional<std::string> View::SelectAuthor() const {
     output_ << "Select author:" << std::endl;
-    auto authors = GetAuthors();
-    PrintVector(output_, authors);
-    output_ << "Enter author # or empty line to cancel" << std::endl;
-
-    std::string str;
-    if (!std::getline(input_, str) || str.empty()) {
+    auto author = SelectFromPages<std::string>(
+        Prefetch{async_runner_, use_cases_},
+        [this](std::string& answer) {
+            return ReadAnswer(answer);
+        },
+        output_, "Enter author # or empty line to cancel"sv, LIST_PAGE_SIZE,
+        [this](const std::optional<std::string>& after, size_t limit) {
+            return GetAuthorsPage(after, limit);
+        },
+        [](const detail::AuthorInfo& author) {
+            return author.name;
+        });
+    if (!author) {
         return std::nullopt;
     }
-
-    int author_idx;
-    try {
-        author_idx = std::stoi(str);
-    } catch (const std::exception&) {
-        throw std::runtime_error("Invalid author num");
-    }
-
-    --author_idx;
-    if (author_idx < 0 or author_idx >= authors.size()) {
-        throw std::runtime_error("Invalid author num");
-    }
-
-    return authors[author_idx].id;
+    return std::move(author->id);
 }
 
 std::optional<std::string> View::SelectBook() const {
-    auto books = GetBooks();
-    PrintVector(output_, books);
-    output_ << "Enter the book # or empty line to cancel:" << std::endl;
-
-    std::string str;
-    if (!std::getline(input_, str) || str.empty()) {
+    auto book = SelectFromPages<domain::BookPageCursor>(
+        Prefetch{async_runner_, use_cases_},
+        [this](std::string& answer) {
+            return ReadAnswer(answer);
+        },
+        output_, "Enter the book # or empty line to cancel:"sv, LIST_PAGE_SIZE,
+        [this](const std::optional<domain::BookPageCursor>& after, size_t limit) {
+            return GetBooksPage(after, limit);
+        },
+        MakeBookPageCursor);
+    if (!book) {
         return std::nullopt;
     }
-
-    int book_idx;
-    try {
-        book_idx = std::stoi(str);
-    } catch (const std::exception&) {
-        throw std::runtime_error("Invalid book num");
-    }
-
-    --book_idx;
-    if (book_idx < 0 or book_idx >= books.size()) {
-        throw std::runtime_error("Invalid book num");
-    }
-    return books[book_idx].id;
+    return std::move(book->id);
 }
 
 std::optional<size_t> View::SelectFromBooks(const std::vector<detail::BookFullInfo>& books) const {
@@ -492,7 +850,7 @@ std::optional<size_t> View::SelectFromBooks(const std::vector<detail::BookFullIn
     output_ << "Enter the book # or empty line to cancel:" << std::endl;
 
     std::string str;
-    if (!std::getline(input_, str) || str.empty()) {
+    if (!ReadAnswer(str) || str.empty()) {
         return std::nullopt;
     }
 
@@ -510,64 +868,58 @@ std::optional<size_t> View::SelectFromBooks(const std::vector<detail::BookFullIn
     return static_cast<size_t>(book_idx);
 }
 
-std::vector<detail::AuthorInfo> View::GetAuthors() const {
+std::vector<detail::AuthorInfo> View::GetAuthorsPage(const std::optional<std::string>& after,
+                                                     size_t limit) const {
     std::vector<detail::AuthorInfo> dst_authors;
 
-    for (auto& author : use_cases_.ShowAuthors()) {
-        dst_authors.emplace_back(std::move(author.GetId().ToString()), std::move(author.GetName()));
+    for (auto& author : use_cases_.ShowAuthorsPage(after, limit)) {
+        dst_authors.emplace_back(author.GetId().ToString(), author.GetName());
     }
     return dst_authors;
 }
 
-std::vector<detail::BookFullInfo> View::GetBooks() const {
+std::vector<detail::BookFullInfo> View::GetBooksPage(const std::optional<domain::BookPageCursor>& after,
+                                                     size_t limit) const {
     std::vector<detail::BookFullInfo> dst_books;
 
-    for (auto &book : use_cases_.ShowAllBooks()) {
-        std::string author_name;
-        try {
-            author_name = use_cases_.GetAuthorName(book.GetAuthorId().ToString());
-        } catch (const std::exception&) {
-            continue;
-        }
-        dst_books.emplace_back(std::move(book.GetId().ToString()),
-                               std::move(book.GetAuthorId().ToString()),
-                               std::move(book.GetTitle()),
-                               book.GetPublicationYear(),
-                               std::move(author_name));
+    for (auto& book : use_cases_.ShowBooksPage(after, limit)) {
+        dst_books.emplace_back(ToBookFullInfo(std::move(book)));
     }
     return dst_books;
 }
 
-std::vector<detail::BookInfo> View::GetAuthorBooks(const std::string& author_id) const {
+std::vector<detail::BookInfo> View::GetAuthorBooksPage(const std::string& author_id,
+                                                       const std::optional<domain::AuthorBookPageCursor>& after,
+                                                       size_t limit) const {
     std::vector<detail::BookInfo> dst_books;
-    std::string author_name = use_cases_.GetAuthorName(author_id);
-    for (auto& book : use_cases_.ShowAuthorBooks(author_id)) {
-        dst_books.emplace_back(std::move(book.GetId().ToString()),
-                               std::move(book.GetTitle()),
+
+    for (auto& book : use_cases_.ShowAuthorBooksPage(author_id, after, limit)) {
+        dst_books.emplace_back(book.GetId().ToString(),
+                               book.GetTitle(),
                                book.GetPublicationYear());
     }
     return dst_books;
 }
 
+std::vector<detail::FoundBook> View::SearchBooksPage(const std::string& query,
+                                                     const std::optional<domain::BookSearchCursor>& after,
+                                                     size_t limit) const {
+    std::vector<detail::FoundBook> dst_books;
+
+    for (auto& found : use_cases_.SearchBooks(query, after, limit)) {
+        dst_books.push_back({ToBookFullInfo(std::move(found.book)), found.rank});
+    }
+    return dst_books;
+}
+
 detail::BookFullInfo View::GetBookById(const std::string& book_id) const {
-    auto book = use_cases_.ShowBookInfoByID(book_id);
-    return {std::move(book.GetId().ToString()),
-            book.GetAuthorId().ToString(),
-            std::move(book.GetTitle()),
-            static_cast<int>(book.GetPublicationYear()),
-            use_cases_.GetAuthorName(book.GetAuthorId().ToString()),
-            std::move(book.GetTags())};
+    return ToBookFullInfo(use_cases_.ShowBookFullInfoByID(book_id));
 }
 std::vector<detail::BookFullInfo> View::GetBookByTitle(const std::string& book_title) const {
     std::vector<detail::BookFullInfo> dst_books;
 
-    for (auto& book : use_cases_.ShowBookInfoByTitle(book_title)) {
-        dst_books.emplace_back(std::move(book.GetId().ToString()),
-                               book.GetAuthorId().ToString(),
-                               std::move(book.GetTitle()),
-                               book.GetPublicationYear(),
-                               use_cases_.GetAuthorName(book.GetAuthorId().ToString()),
-                               std::move(book.GetTags()));
+    for (auto& book : use_cases_.ShowBookFullInfoByTitle(book_title)) {
+        dst_books.emplace_back(ToBookFullInfo(std::move(book)));
     }
     return dst_books;
 }
@@ -8,12 +8,21 @@
 #include <utility>
 #include <vector>
 
+#include "renderer.h"
+
 namespace menu {
 class Menu;
 }
 
 namespace app {
 class UseCases;
+class AsyncRunner;
+}
+
+namespace domain {
+struct BookPageCursor;
+struct AuthorBookPageCursor;
+struct BookSearchCursor;
 }
 
 namespace ui {
@@ -46,6 +55,12 @@ struct BookFullInfo {
     std::vector<std::string> tags;
 };
 
+/* Книга из результатов поиска: релевантность нужна для перехода к следующей странице */
+struct FoundBook {
+    BookFullInfo book;
+    double rank = 0;
+};
+
 enum class AuthorEnteredAs {
     REJECT,
     ID,
@@ -56,7 +71,14 @@ enum class AuthorEnteredAs {
 
 class View {
 public:
-    View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std::ostream& output);
+    static constexpr size_t DEFAULT_IMPORT_BATCH_SIZE = 10'000;
+    /* Списки выводятся и запрашиваются у модуля хранения страницами такого размера */
+    static constexpr size_t LIST_PAGE_SIZE = 50;
+
+    /* Если задан async_runner, следующая страница списка запрашивается, пока выводится текущая
+     * или пользователь выбирает элемент. Фоновый запрос читает в снимке потока команды */
+    View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std::ostream& output,
+         OutputFormat format = OutputFormat::TEXT, app::AsyncRunner* async_runner = nullptr);
 
 private:
     bool AddAuthor(std::istream& cmd_input) const;
@@ -66,21 +88,37 @@ private:
     bool AddBook(std::istream& cmd_input) const;
     bool DeleteBook(std::istream& cmd_input) const;
     bool EditBook(std::istream& cmd_input) const;
+    bool ImportCatalog(std::istream& cmd_input) const;
+    bool ExportCatalog(std::istream& cmd_input) const;
     bool ShowAuthors() const;
     bool ShowBooks() const;
+    bool ShowBooksByTag(std::istream& cmd_input) const;
+    bool ShowBooksByTags(std::istream& cmd_input) const;
     bool ShowAuthorBooks(std::istream& cmd_input) const;
     bool ShowBook(std::istream& cmd_input) const;
+    bool SearchBooks(std::istream& cmd_input) const;
+    bool SetOutputFormat(std::istream& cmd_input);
 
     std::optional<detail::AddBookParams> GetBookParams(std::istream& cmd_input) const;
     detail::BookFullInfo GetEditBookParams(const detail::BookFullInfo& old_book) const;
     std::optional<std::string> SelectAuthor() const;
     std::optional<std::string> SelectBook() const;
     std::optional<size_t> SelectFromBooks(const std::vector<detail::BookFullInfo>& books) const;
+    bool ReadAnswer(std::string& answer) const;
 
-    std::vector<detail::AuthorInfo> GetAuthors() const;
+    std::vector<detail::AuthorInfo> GetAuthorsPage(const std::optional<std::string>& after, size_t limit) const;
     void CheckAuthorPresenceByName(const std::string& author_name) const;
-    std::vector<detail::BookFullInfo> GetBooks() const;
-    std::vector<detail::BookInfo> GetAuthorBooks(const std::string& author_id) const;
+    std::optional<std::string> FindAuthorIdByName(const std::string& author_name) const;
+    std::vector<detail::BookFullInfo> GetBooksPage(const std::optional<domain::BookPageCursor>& after,
+                                                   size_t limit) const;
+    std::vector<detail::BookInfo> GetAuthorBooksPage(const std::string& author_id,
+                                                     const std::optional<domain::AuthorBookPageCursor>& after,
+                                                     size_t limit) const;
+    std::vector<detail::FoundBook> SearchBooksPage(const std::string& query,
+                                                   const std::optional<domain::BookSearchCursor>& after,
+                                                   size_t limit) const;
+    void PrintAuthorBooks(const std::string& author_id) const;
+    void PrintFullInfoOfBook(const detail::BookFullInfo& book) const;
     detail::BookFullInfo GetBookById(const std::string& book_id) const;
     std::vector<detail::BookFullInfo> GetBookByTitle(const std::string& book_title) const;
 
@@ -90,6 +128,8 @@ private:
     app::UseCases& use_cases_;
     std::istream& input_;
     std::ostream& output_;
+    OutputFormat format_;
+    app::AsyncRunner* async_runner_;
 };
 
 }  // namespace ui
\ No newline at end of file
@@ -1,24 +1,217 @@
 #include "tagged_uuid.h"
 
 #include <boost/uuid/random_generator.hpp>
-#include <boost/uuid/string_generator.hpp>
-#include <boost/uuid/uuid_io.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std::literals;
 
 namespace util {
 namespace detail {
 
+namespace {
+
+/* Позиции дефисов в текстовом виде 8-4-4-4-12 */
+constexpr size_t DASH_POSITIONS[]{8, 13, 18, 23};
+constexpr size_t HEX_DIGITS_SIZE = 32;
+
+[[noreturn]] void ThrowInvalidUUID() {
+    throw std::runtime_error("invalid uuid string"s);
+}
+
+#if defined(__SSE2__)
+
+/* 16 байт -> 32 шестнадцатеричные цифры в нижнем регистре */
+void EncodeHex(const uint8_t* bytes, char* out) noexcept {
+    const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    const __m128i low_mask = _mm_set1_epi8(0x0f);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(value, 4), low_mask);
+    const __m128i low = _mm_and_si128(value, low_mask);
+    auto to_chars = [](__m128i nibbles) {
+        // '0' + n для цифр и 'a' + n - 10 для букв
+        const __m128i is_letter = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+        const __m128i offset = _mm_add_epi8(_mm_set1_epi8('0'),
+                                            _mm_and_si128(is_letter, _mm_set1_epi8('a' - '0' - 10)));
+        return _mm_add_epi8(nibbles, offset);
+    };
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), to_chars(_mm_unpacklo_epi8(high, low)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), to_chars(_mm_unpackhi_epi8(high, low)));
+}
+
+/* 16 символов -> маска допустимых цифр и их значения */
+__m128i DecodeHexChars(__m128i chars, int& valid_mask) noexcept {
+    const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    // Сравнения знаковые: сдвиг на 0x80 переводит их в беззнаковые
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i is_digit = _mm_cmplt_epi8(_mm_xor_si128(digit, bias), _mm_set1_epi8(static_cast<char>(10 ^ 0x80)));
+    const __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i is_letter = _mm_cmplt_epi8(_mm_xor_si128(letter, bias), _mm_set1_epi8(static_cast<char>(6 ^ 0x80)));
+    valid_mask &= _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter));
+    return _mm_or_si128(_mm_and_si128(is_digit, digit),
+                        _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+/* 32 шестнадцатеричные цифры -> 16 байт. false, если встретился другой символ */
+bool DecodeHex(const char* hex, uint8_t* bytes) noexcept {
+    int valid_mask = 0xffff;
+    const __m128i first = DecodeHexChars(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex)), valid_mask);
+    const __m128i second = DecodeHexChars(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + 16)), valid_mask);
+    if (valid_mask != 0xffff) {
+        return false;
+    }
+    // В каждом 16-битном слове младший байт - старшая тетрада, старший байт - младшая
+    auto pack = [](__m128i nibbles) {
+        const __m128i high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4);
+        return _mm_or_si128(high, _mm_srli_epi16(nibbles, 8));
+    };
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), _mm_packus_epi16(pack(first), pack(second)));
+    return true;
+}
+
+#else
+
+constexpr char HEX_DIGITS[]{"0123456789abcdef"};
+
+/* Значение шестнадцатеричной цифры по символу, 0xff - не цифра */
+constexpr std::array<uint8_t, 256> MakeHexValues() {
+    std::array<uint8_t, 256> values{};
+    values.fill(0xff);
+    for (uint8_t i = 0; i < 10; ++i) {
+        values['0' + i] = i;
+    }
+    for (uint8_t i = 0; i < 6; ++i) {
+        values['a' + i] = 10 + i;
+        values['A' + i] = 10 + i;
+    }
+    return values;
+}
+constexpr auto HEX_VALUES = MakeHexValues();
+
+void EncodeHex(const uint8_t* bytes, char* out) noexcept {
+    for (size_t i = 0; i < 16; ++i) {
+        out[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        out[2 * i + 1] = HEX_DIGITS[bytes[i] & 0x0f];
+    }
+}
+
+bool DecodeHex(const char* hex, uint8_t* bytes) noexcept {
+    uint8_t invalid = 0;
+    for (size_t i = 0; i < 16; ++i) {
+        const uint8_t high = HEX_VALUES[static_cast<uint8_t>(hex[2 * i])];
+        const uint8_t low = HEX_VALUES[static_cast<uint8_t>(hex[2 * i + 1])];
+        invalid |= (high | low) & 0xf0;
+        bytes[i] = static_cast<uint8_t>(high << 4 | low);
+    }
+    return invalid == 0;
+}
+
+#endif
+
+std::atomic<UUIDVersion> uuid_version{UUIDVersion::RANDOM};
+
+/* Генератор создаётся и инициализируется из источника энтропии ОС один раз на поток */
+boost::uuids::random_generator_mt19937& RandomGenerator() {
+    thread_local boost::uuids::random_generator_mt19937 generator;
+    return generator;
+}
+
+/* UUIDv7 (RFC 9562): 48 бит - миллисекунды Unix-времени, 12 бит rand_a - счётчик внутри миллисекунды,
+ * остальное - случайные биты. Идентификаторы одного потока строго возрастают */
+UUIDType NewTimeOrderedUUID() {
+    thread_local uint64_t last_ms = 0;
+    thread_local uint16_t sequence = 0;
+
+    UUIDType uuid = RandomGenerator()();
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    const uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    if (ms > last_ms) {
+        last_ms = ms;
+        // Случайное начало счётчика в младшей половине оставляет запас для следующих ключей
+        sequence = (uuid.data[6] << 8 | uuid.data[7]) & 0x7ff;
+    } else if (++sequence > 0xfff) {
+        // Счётчик исчерпан: ключ берётся в счёт следующей миллисекунды
+        ++last_ms;
+        sequence = 0;
+    }
+
+    for (size_t i = 0; i < 6; ++i) {
+        uuid.data[i] = static_cast<uint8_t>(last_ms >> (40 - 8 * i));
+    }
+    uuid.data[6] = static_cast<uint8_t>(0x70 | sequence >> 8);
+    uuid.data[7] = static_cast<uint8_t>(sequence);
+    return uuid;
+}
+
+}  // namespace
+
 UUIDType NewUUID() {
-    return boost::uuids::random_generator()();
+    return uuid_version.load(std::memory_order_relaxed) == UUIDVersion::TIME_ORDERED ? NewTimeOrderedUUID()
+                                                                                     : RandomGenerator()();
 }
 
-std::string UUIDToString(const UUIDType& uuid) {
-    return to_string(uuid);
+char* UUIDToChars(const UUIDType& uuid, char* out) noexcept {
+    char hex[HEX_DIGITS_SIZE];
+    EncodeHex(uuid.data, hex);
+    std::memcpy(out, hex, 8);
+    out[8] = '-';
+    std::memcpy(out + 9, hex + 8, 4);
+    out[13] = '-';
+    std::memcpy(out + 14, hex + 12, 4);
+    out[18] = '-';
+    std::memcpy(out + 19, hex + 16, 4);
+    out[23] = '-';
+    std::memcpy(out + 24, hex + 20, 12);
+    return out + UUID_STRING_SIZE;
 }
 
+/* Принимает те же формы, что и boost::uuids::string_generator:
+ * 8-4-4-4-12, 32 цифры без дефисов и любую из них в фигурных скобках */
 UUIDType UUIDFromString(std::string_view str) {
-    boost::uuids::string_generator gen;
-    return gen(str.begin(), str.end());
+    if (str.size() >= 2 && str.front() == '{' && str.back() == '}') {
+        str = str.substr(1, str.size() - 2);
+    }
+    char hex[HEX_DIGITS_SIZE];
+    if (str.size() == UUID_STRING_SIZE) {
+        for (size_t pos : DASH_POSITIONS) {
+            if (str[pos] != '-') {
+                ThrowInvalidUUID();
+            }
+        }
+        std::memcpy(hex, str.data(), 8);
+        std::memcpy(hex + 8, str.data() + 9, 4);
+        std::memcpy(hex + 12, str.data() + 14, 4);
+        std::memcpy(hex + 16, str.data() + 19, 4);
+        std::memcpy(hex + 20, str.data() + 24, 12);
+    } else if (str.size() == HEX_DIGITS_SIZE) {
+        std::memcpy(hex, str.data(), HEX_DIGITS_SIZE);
+    } else {
+        ThrowInvalidUUID();
+    }
+    UUIDType uuid;
+    if (!DecodeHex(hex, uuid.data)) {
+        ThrowInvalidUUID();
+    }
+    return uuid;
+}
+
+std::string UUIDToString(const UUIDType& uuid) {
+    std::string str(UUID_STRING_SIZE, '\0');
+    UUIDToChars(uuid, str.data());
+    return str;
 }
 
 }  // namespace detail
+
+void SetUUIDVersion(UUIDVersion version) {
+    detail::uuid_version.store(version, std::memory_order_relaxed);
+}
+
 }  // namespace util
@@ -2,11 +2,21 @@
 #include <boost/uuid/nil_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <string>
+#include <string_view>
 
 #include "tagged.h"
 
 namespace util {
 
+/* Версия создаваемых идентификаторов */
+enum class UUIDVersion {
+    RANDOM,       // v4: случайные
+    TIME_ORDERED  // v7: начинаются с времени создания, поэтому новые ключи добавляются в конец индекса
+};
+
+/* Действует на все последующие вызовы TaggedUUID::New() во всех потоках */
+void SetUUIDVersion(UUIDVersion version);
+
 namespace detail {
 
 using UUIDType = boost::uuids::uuid;
@@ -14,7 +24,14 @@ using UUIDType = boost::uuids::uuid;
 UUIDType NewUUID();
 constexpr UUIDType ZeroUUID{{0}};
 
+/* Длина текстового вида UUID (8-4-4-4-12) без завершающего нуля */
+constexpr size_t UUID_STRING_SIZE = 36;
+
+/* Записывает текстовый вид UUID в out (не менее UUID_STRING_SIZE символов, без нуля в конце)
+ * и возвращает указатель за последним записанным символом. Память не выделяется */
+char* UUIDToChars(const UUIDType& uuid, char* out) noexcept;
 std::string UUIDToString(const UUIDType& uuid);
+/* Разбор без выделения памяти. При неверном формате бросает std::runtime_error */
 UUIDType UUIDFromString(std::string_view str);
 
 }  // namespace detail
@@ -33,7 +50,7 @@ public:
         return TaggedUUID{detail::NewUUID()};
     }
 
-    static TaggedUUID FromString(const std::string& uuid_as_text) {
+    static TaggedUUID FromString(std::string_view uuid_as_text) {
         return TaggedUUID{detail::UUIDFromString(uuid_as_text)};
     }
 
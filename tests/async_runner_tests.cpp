@@ -0,0 +1,50 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../src/app/async_runner.h"
+
+using namespace std::literals;
+
+TEST_CASE("Async runner returns results and exceptions of tasks") {
+    app::AsyncRunner runner{2};
+    auto sum = runner.Submit([] {
+        return 2 + 2;
+    });
+    auto failed = runner.Submit([]() -> int {
+        throw std::runtime_error("failed"s);
+    });
+    CHECK(sum.Get() == 4);
+    CHECK_THROWS_AS(failed.Get(), std::runtime_error);
+}
+
+TEST_CASE("Independent tasks run at the same time") {
+    app::AsyncRunner runner{2};
+    std::atomic<int> started{0};
+    auto wait_for_other = [&started] {
+        ++started;
+        while (started < 2) {
+            std::this_thread::yield();
+        }
+        return true;
+    };
+    auto first = runner.Submit(wait_for_other);
+    auto second = runner.Submit(wait_for_other);
+    CHECK(first.Get());
+    CHECK(second.Get());
+}
+
+TEST_CASE("Pending result waits for its task on destruction") {
+    app::AsyncRunner runner{1};
+    std::vector<int> values;
+    {
+        auto pending = runner.Submit([&values] {
+            std::this_thread::sleep_for(10ms);
+            values.push_back(1);
+        });
+    }
+    CHECK(values == std::vector<int>{1});
+}
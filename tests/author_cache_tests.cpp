@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+#include <map>
+#include <stdexcept>
+
+#include "../src/cache/author_cache.h"
+
+using namespace std::literals;
+
+namespace {
+
+/* Репозиторий в памяти, считающий обращения на чтение */
+struct CountingAuthorRepository : domain::AuthorRepository {
+    std::map<std::string, domain::Author> authors;  // name -> author
+    int get_name_calls = 0;
+    int get_id_calls = 0;
+
+    void Save(const domain::Author& author) override {
+        authors.insert_or_assign(author.GetName(), author);
+    }
+    std::string GetName(const domain::AuthorId& id) override {
+        ++get_name_calls;
+        for (const auto& [name, author] : authors) {
+            if (author.GetId() == id) {
+                return name;
+            }
+        }
+        throw std::runtime_error("No such author"s);
+    }
+    std::string GetID(const std::string& name) override {
+        ++get_id_calls;
+        return authors.at(name).GetId().ToString();
+    }
+    std::vector<domain::Author> Show() override {
+        return {};
+    }
+    std::vector<domain::Author> ShowPage(const std::optional<std::string>& after_name, size_t limit) override {
+        return {};
+    }
+    void Delete(const domain::AuthorId& id) override {
+        Delete(GetName(id));
+    }
+    void Delete(const std::string& name) override {
+        authors.erase(name);
+    }
+    void Edit(const domain::Author& new_author) override {
+        Delete(new_author.GetId());
+        Save(new_author);
+    }
+    void Edit(const std::string& old_name, const std::string& new_name) override {
+        auto id = authors.at(old_name).GetId();
+        authors.erase(old_name);
+        Save({id, new_name});
+    }
+};
+
+}  // namespace
+
+SCENARIO("Author cache") {
+    GIVEN("a cache over a repository with an author") {
+        CountingAuthorRepository repository;
+        const auto id = domain::AuthorId::New();
+        repository.Save({id, "Jack London"s});
+        cache::CachingAuthorRepository authors{repository, 2};
+
+        WHEN("the author name is requested twice") {
+            CHECK(authors.GetName(id) == "Jack London"s);
+            CHECK(authors.GetName(id) == "Jack London"s);
+
+            THEN("the repository is read once") {
+                CHECK(repository.get_name_calls == 1);
+                CHECK(authors.GetStats().hits == 1);
+                CHECK(authors.GetStats().misses == 1);
+            }
+            THEN("the reverse lookup is served from the cache as well") {
+                CHECK(authors.GetID("Jack London"s) == id.ToString());
+                CHECK(repository.get_id_calls == 0);
+            }
+        }
+
+        WHEN("the author is renamed") {
+            authors.GetName(id);
+            authors.Edit("Jack London"s, "John Griffith Chaney"s);
+
+            THEN("the next lookup returns the new name") {
+                CHECK(authors.GetName(id) == "John Griffith Chaney"s);
+                CHECK(repository.get_name_calls == 2);
+                CHECK_THROWS(authors.GetID("Jack London"s));
+            }
+        }
+
+        WHEN("the author is deleted") {
+            authors.GetName(id);
+            authors.Delete(id);
+
+            THEN("the cached name is dropped") {
+                CHECK_THROWS(authors.GetName(id));
+            }
+        }
+
+        WHEN("more authors are read than the cache holds") {
+            const auto second = domain::AuthorId::New();
+            const auto third = domain::AuthorId::New();
+            repository.Save({second, "Herman Melville"s});
+            repository.Save({third, "Joanne Rowling"s});
+            authors.GetName(id);
+            authors.GetName(second);
+            authors.GetName(third);
+
+            THEN("the least recently used entry is evicted") {
+                CHECK(authors.GetStats().size == 2);
+                CHECK(authors.GetStats().evictions == 1);
+                authors.GetName(id);
+                CHECK(repository.get_name_calls == 4);
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <stdexcept>
+
+#include "../src/app/catalog_io.h"
+
+using namespace std::literals;
+using app::CatalogFormat;
+using app::CatalogReader;
+
+TEST_CASE("Catalog format is detected by file extension") {
+    CHECK(app::CatalogFormatFromFileName("books.csv"s) == CatalogFormat::CSV);
+    CHECK(app::CatalogFormatFromFileName("books.ndjson"s) == CatalogFormat::NDJSON);
+    CHECK(app::CatalogFormatFromFileName("books.jsonl"s) == CatalogFormat::NDJSON);
+    CHECK_FALSE(app::CatalogFormatFromFileName("books.txt"s).has_value());
+}
+
+TEST_CASE("CSV catalog reading") {
+    std::istringstream input{
+        "author,title,publication_year,tags\n"
+        "Jack London,White Fang,1906,adventure; gold   rush ;dog;;dog\n"
+        "\"Saint-Exupery, Antoine de\",\"The \"\"Little\"\" Prince\",1943,\n"
+        "Herman Melville,\"Moby-Dick\nor The Whale\",1851,sea\n"};
+    CatalogReader reader{input, CatalogFormat::CSV};
+
+    auto first = reader.Next();
+    REQUIRE(first.has_value());
+    CHECK(first->author_name == "Jack London"s);
+    CHECK(first->title == "White Fang"s);
+    CHECK(first->publication_year == 1906);
+    CHECK(first->tags == std::vector{"adventure"s, "dog"s, "gold rush"s});
+
+    auto second = reader.Next();
+    REQUIRE(second.has_value());
+    CHECK(second->author_name == "Saint-Exupery, Antoine de"s);
+    CHECK(second->title == "The \"Little\" Prince"s);
+    CHECK(second->tags.empty());
+
+    auto third = reader.Next();
+    REQUIRE(third.has_value());
+    CHECK(third->title == "Moby-Dick\nor The Whale"s);
+
+    CHECK_FALSE(reader.Next().has_value());
+}
+
+TEST_CASE("CSV catalog without header is rejected") {
+    std::istringstream input{"Jack London,White Fang,1906,\n"};
+    CHECK_THROWS_AS(CatalogReader(input, CatalogFormat::CSV), std::runtime_error);
+}
+
+TEST_CASE("NDJSON catalog reading") {
+    std::istringstream input{
+        R"({"author": "Jack London", "title": "White Fang", "publication_year": 1906, "tags": ["dog", " dog "]})"
+        "\n\n"
+        R"({"author": "Herman Melville", "title": "Moby-Dick", "publication_year": 1851})"
+        "\n"
+        R"({"author": "", "title": "Untitled", "publication_year": 2000})"
+        "\n"};
+    CatalogReader reader{input, CatalogFormat::NDJSON};
+
+    auto first = reader.Next();
+    REQUIRE(first.has_value());
+    CHECK(first->author_name == "Jack London"s);
+    CHECK(first->tags == std::vector{"dog"s});
+
+    auto second = reader.Next();
+    REQUIRE(second.has_value());
+    CHECK(second->title == "Moby-Dick"s);
+    CHECK(second->tags.empty());
+
+    CHECK_THROWS_AS(reader.Next(), std::runtime_error);
+}
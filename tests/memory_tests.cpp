@@ -0,0 +1,228 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <thread>
+
+#include "../src/memory/memory.h"
+
+using namespace std::literals;
+
+SCENARIO("In-memory storage") {
+    GIVEN("two authors with books") {
+        memory::Database db;
+        auto& authors = db.GetAuthors();
+        auto& books = db.GetBooks();
+
+        const auto london = domain::AuthorId::New();
+        const auto melville = domain::AuthorId::New();
+        authors.Save({london, "Jack London"s});
+        authors.Save({melville, "Herman Melville"s});
+
+        const auto white_fang = domain::BookId::New();
+        const auto moby_dick = domain::BookId::New();
+        const auto martin_eden = domain::BookId::New();
+        books.Save({white_fang, london, "White Fang"s, 1906, {"wolf"s, "adventure"s}});
+        books.Save({moby_dick, melville, "Moby-Dick"s, 1851, {"whale"s}});
+        books.Save({martin_eden, london, "Martin Eden"s, 1909});
+
+        THEN("authors are listed by name") {
+            const auto list = authors.Show();
+            REQUIRE(list.size() == 2);
+            CHECK(list[0].GetName() == "Herman Melville"s);
+            CHECK(list[1].GetName() == "Jack London"s);
+            CHECK(authors.GetID("Jack London"s) == london.ToString());
+        }
+
+        THEN("books are listed by title, and by year within an author") {
+            const auto all = books.ShowAllWithAuthors(false);
+            REQUIRE(all.size() == 3);
+            CHECK(all[0].GetBook().GetTitle() == "Martin Eden"s);
+            CHECK(all[1].GetAuthorName() == "Herman Melville"s);
+            CHECK(all[2].GetBook().GetTitle() == "White Fang"s);
+
+            const auto by_london = books.ShowByAuthor(london);
+            REQUIRE(by_london.size() == 2);
+            CHECK(by_london[0].GetTitle() == "White Fang"s);
+            CHECK(by_london[1].GetTitle() == "Martin Eden"s);
+        }
+
+        THEN("tags are returned sorted") {
+            const auto info = books.ShowInfoByID(white_fang);
+            CHECK(info.GetTags() == std::vector{"adventure"s, "wolf"s});
+        }
+
+        THEN("pages continue after the cursor") {
+            const auto first = books.ShowPageWithAuthors(std::nullopt, 2);
+            REQUIRE(first.size() == 2);
+            const auto& last = first.back();
+            const auto second = books.ShowPageWithAuthors(
+                    domain::BookPageCursor{last.GetBook().GetTitle(), last.GetAuthorName(),
+                                           last.GetBook().GetPublicationYear(), last.GetBook().GetId()}, 2);
+            REQUIRE(second.size() == 1);
+            CHECK(second[0].GetBook().GetTitle() == "White Fang"s);
+        }
+
+        WHEN("an author is renamed") {
+            authors.Edit("Jack London"s, "Another Author"s);
+
+            THEN("the book order follows the new name") {
+                CHECK(books.ShowInfoWithAuthorByID(martin_eden).GetAuthorName() == "Another Author"s);
+                CHECK_THROWS(authors.GetID("Jack London"s));
+            }
+        }
+
+        WHEN("an author is deleted") {
+            authors.Delete(london);
+
+            THEN("the author's books are deleted too") {
+                CHECK(books.ShowAll().size() == 1);
+                CHECK(books.ShowByAuthor(london).empty());
+                CHECK_THROWS(books.ShowInfoByID(white_fang));
+                CHECK(books.ShowInfoByTitle("White Fang"s).empty());
+            }
+        }
+
+        WHEN("a book is edited") {
+            books.Edit({white_fang, london, "White Fang"s, 1905, {"dog"s}});
+
+            THEN("its year and tags are replaced") {
+                const auto info = books.ShowInfoByID(white_fang);
+                CHECK(info.GetPublicationYear() == 1905);
+                CHECK(info.GetTags() == std::vector{"dog"s});
+            }
+        }
+
+        THEN("constraint violations are reported") {
+            CHECK_THROWS(authors.Save({domain::AuthorId::New(), "Jack London"s}));
+            CHECK_THROWS(books.Save({domain::BookId::New(), domain::AuthorId::New(), "Orphan"s, 2000}));
+            CHECK_THROWS(books.Delete(domain::BookId::New()));
+            CHECK_THROWS(authors.Delete("Nobody"s));
+        }
+
+        THEN("books are selected by any or all of the tags") {
+            books.Save({domain::BookId::New(), melville, "Typee"s, 1846, {"adventure"s, "sea"s}});
+
+            const auto adventure = books.ShowPageByTags({"adventure"s}, domain::TagMatch::ANY, std::nullopt, 10);
+            REQUIRE(adventure.size() == 2);
+            CHECK(adventure[0].GetBook().GetTitle() == "Typee"s);
+            CHECK(adventure[1].GetBook().GetTitle() == "White Fang"s);
+
+            const auto any = books.ShowPageByTags({"whale"s, "wolf"s}, domain::TagMatch::ANY, std::nullopt, 10);
+            REQUIRE(any.size() == 2);
+            CHECK(any[0].GetBook().GetTitle() == "Moby-Dick"s);
+
+            const auto all = books.ShowPageByTags({"sea"s, "adventure"s}, domain::TagMatch::ALL, std::nullopt, 10);
+            REQUIRE(all.size() == 1);
+            CHECK(all[0].GetBook().GetTitle() == "Typee"s);
+            CHECK(books.ShowPageByTags({"sea"s, "wolf"s}, domain::TagMatch::ALL, std::nullopt, 10).empty());
+
+            const auto& first = adventure[0];
+            const auto next = books.ShowPageByTags(
+                    {"adventure"s}, domain::TagMatch::ANY,
+                    domain::BookPageCursor{first.GetBook().GetTitle(), first.GetAuthorName(),
+                                           first.GetBook().GetPublicationYear(), first.GetBook().GetId()}, 10);
+            REQUIRE(next.size() == 1);
+            CHECK(next[0].GetBook().GetTitle() == "White Fang"s);
+        }
+
+        THEN("search finds books by fragments and misspellings") {
+            const auto by_title = books.Search("fang"s, std::nullopt, 10);
+            REQUIRE(by_title.size() == 1);
+            CHECK(by_title[0].book.GetBook().GetId() == white_fang);
+
+            const auto by_author = books.Search("Jack Londn"s, std::nullopt, 10);
+            CHECK(by_author.size() == 2);
+
+            const auto by_tag = books.Search("whale"s, std::nullopt, 10);
+            REQUIRE(by_tag.size() == 1);
+            CHECK(by_tag[0].book.GetAuthorName() == "Herman Melville"s);
+
+            CHECK(books.Search("zzz"s, std::nullopt, 10).empty());
+        }
+
+        THEN("search pages follow the rank order") {
+            const auto all = books.Search("london"s, std::nullopt, 10);
+            REQUIRE(all.size() == 2);
+            CHECK(all[0].rank >= all[1].rank);
+            const auto first = books.Search("london"s, std::nullopt, 1);
+            REQUIRE(first.size() == 1);
+            const auto second = books.Search(
+                    "london"s, domain::BookSearchCursor{first[0].rank, first[0].book.GetBook().GetId()}, 1);
+            REQUIRE(second.size() == 1);
+            CHECK(second[0].book.GetBook().GetId() == all[1].book.GetBook().GetId());
+        }
+
+        WHEN("a catalog batch is imported") {
+            books.Import({{"Jack London"s, "The Call of the Wild"s, 1903, {}},
+                          {"Leo Tolstoy"s, "War and Peace"s, 1869, {"war"s}}});
+
+            THEN("books join existing authors and new authors are added") {
+                CHECK(books.ShowByAuthor(london).size() == 3);
+                CHECK(authors.Show().size() == 3);
+                size_t exported = 0;
+                books.Export([&exported](const domain::CatalogRecord&) {
+                    ++exported;
+                });
+                CHECK(exported == 5);
+            }
+        }
+
+        WHEN("a command batch is rolled back while another thread writes") {
+            auto& batch = db.GetCommandBatch();
+            const auto twain = domain::AuthorId::New();
+            batch.Begin();
+            batch.BeginCommand();
+            books.Edit({white_fang, london, "White Fang"s, 1905, {"dog"s}});
+            authors.Delete(melville);
+            authors.Edit("Jack London"s, "John Griffith London"s);
+            books.Import({{"Leo Tolstoy"s, "War and Peace"s, 1869, {"war"s}}});
+            bool open_in_other_thread = true;
+            std::thread other{[&] {
+                open_in_other_thread = batch.IsOpen();
+                authors.Save({twain, "Mark Twain"s});
+                books.Save({domain::BookId::New(), twain, "Roughing It"s, 1872});
+            }};
+            other.join();
+            CHECK(batch.EndCommand());
+            batch.Rollback();
+
+            THEN("only the changes of the batch are undone") {
+                CHECK_FALSE(open_in_other_thread);
+                CHECK_FALSE(batch.IsOpen());
+                CHECK(authors.GetName(london) == "Jack London"s);
+                CHECK(authors.GetName(melville) == "Herman Melville"s);
+                CHECK_THROWS(authors.GetID("Leo Tolstoy"s));
+                const auto info = books.ShowInfoByID(white_fang);
+                CHECK(info.GetPublicationYear() == 1906);
+                CHECK(info.GetTags() == std::vector{"adventure"s, "wolf"s});
+                CHECK(books.ShowInfoWithAuthorByID(moby_dick).GetAuthorName() == "Herman Melville"s);
+                CHECK(books.ShowAll().size() == 4);
+                CHECK(authors.GetName(twain) == "Mark Twain"s);
+                CHECK(books.ShowByAuthor(twain).size() == 1);
+            }
+        }
+
+        WHEN("a command of a batch violates a constraint") {
+            auto& batch = db.GetCommandBatch();
+            const auto tolstoy = domain::AuthorId::New();
+            const auto twain = domain::AuthorId::New();
+            batch.Begin();
+            batch.BeginCommand();
+            authors.Save({tolstoy, "Leo Tolstoy"s});
+            CHECK_THROWS(authors.Save({domain::AuthorId::New(), "Jack London"s}));
+            const bool failed_command_kept = batch.EndCommand();
+            batch.BeginCommand();
+            // Ненайденная книга - не нарушение ограничения: команда не отменяется
+            CHECK_THROWS(books.Delete(domain::BookId::New()));
+            authors.Save({twain, "Mark Twain"s});
+            const bool command_kept = batch.EndCommand();
+            batch.Commit();
+
+            THEN("only that command is undone") {
+                CHECK_FALSE(failed_command_kept);
+                CHECK(command_kept);
+                CHECK_THROWS(authors.GetName(tolstoy));
+                CHECK(authors.GetName(twain) == "Mark Twain"s);
+            }
+        }
+    }
+}
@@ -0,0 +1,584 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <pqxx/pqxx>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/bookypedia.h"
+#include "../src/postgres/migrations.h"
+#include "../src/postgres/postgres.h"
+
+using namespace std::literals;
+
+namespace {
+
+/* Тесты модуля хранения выполняются только при заданной переменной окружения,
+ * поскольку требуют запущенного сервера PostgreSQL */
+constexpr const char TEST_DB_URL_ENV_NAME[]{"BOOKYPEDIA_TEST_DB_URL"};
+
+/* Подсчёт сообщений, отправленных клиентом серверу, по трассировке libpq (PQtrace).
+ * Одинаковое число сообщений означает одинаковое число выполненных команд.
+ * Пул должен состоять из одного соединения: тогда трассируется то же соединение,
+ * которое используют репозитории */
+class FrontendMessageCounter {
+public:
+    explicit FrontendMessageCounter(postgres::ConnectionPool& pool)
+        : pool_{pool}
+        , trace_file_{std::tmpfile()} {
+        pool_.GetConnection()->trace(trace_file_);
+    }
+
+    FrontendMessageCounter(const FrontendMessageCounter&) = delete;
+    FrontendMessageCounter& operator=(const FrontendMessageCounter&) = delete;
+
+    ~FrontendMessageCounter() {
+        pool_.GetConnection()->trace(nullptr);
+        std::fclose(trace_file_);
+    }
+
+    size_t Count() {
+        std::fflush(trace_file_);
+        std::rewind(trace_file_);
+        std::string trace;
+        char buffer[4096];
+        while (size_t read = std::fread(buffer, 1, sizeof(buffer), trace_file_)) {
+            trace.append(buffer, read);
+        }
+
+        size_t count = 0;
+        size_t line_start = 0;
+        while (line_start < trace.size()) {
+            size_t line_end = trace.find('\n', line_start);
+            if (line_end == std::string::npos) {
+                line_end = trace.size();
+            }
+            std::string_view line{trace.data() + line_start, line_end - line_start};
+            // libpq >= 14: "<time>\tF\t<len>\t<message>", libpq < 14: "To backend> Msg <type>"
+            if (line.find("\tF\t"sv) != std::string_view::npos || line.starts_with("F\t"sv)
+                || line.starts_with("To backend> Msg"sv)) {
+                ++count;
+            }
+            line_start = line_end + 1;
+        }
+        return count;
+    }
+
+private:
+    postgres::ConnectionPool& pool_;
+    std::FILE* trace_file_;
+};
+
+}  // namespace
+
+TEST_CASE("Book lookup costs a constant number of statements") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::Database db{db_url, 1};
+    auto& authors = db.GetAuthors();
+    auto& books = db.GetBooks();
+
+    const auto author_id = domain::AuthorId::New();
+    authors.Save({author_id, "Author "s + author_id.ToString()});
+    const std::string single_title = "Single "s + author_id.ToString();
+    const std::string popular_title = "Popular "s + author_id.ToString();
+    const auto single_id = domain::BookId::New();
+    books.Save({single_id, author_id, single_title, 2000, {"b"s, "a"s}});
+    for (uint64_t year = 2001; year <= 2005; ++year) {
+        books.Save({domain::BookId::New(), author_id, popular_title, year, {"x"s, "y"s}});
+    }
+
+    auto count_by_title = [&](const std::string& title) {
+        FrontendMessageCounter counter{db.GetConnectionPool()};
+        auto found = books.ShowInfoByTitle(title);
+        return std::pair{found, counter.Count()};
+    };
+    auto [single_books, single_count] = count_by_title(single_title);
+    auto [popular_books, popular_count] = count_by_title(popular_title);
+
+    REQUIRE(single_books.size() == 1);
+    REQUIRE(popular_books.size() == 5);
+    CHECK(single_books[0].GetTags() == std::vector{"a"s, "b"s});
+    for (const auto& book : popular_books) {
+        CHECK(book.GetTags() == std::vector{"x"s, "y"s});
+    }
+    CHECK(single_count == popular_count);
+
+    size_t by_id_count = 0;
+    {
+        FrontendMessageCounter counter{db.GetConnectionPool()};
+        auto book = books.ShowInfoByID(single_id);
+        by_id_count = counter.Count();
+        CHECK(book.GetTags() == std::vector{"a"s, "b"s});
+    }
+    CHECK(by_id_count == single_count);
+
+    authors.Delete(author_id);
+}
+
+TEST_CASE("Tag writes cost a constant number of statements") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::Database db{db_url, 1};
+    auto& authors = db.GetAuthors();
+    auto& books = db.GetBooks();
+
+    const auto author_id = domain::AuthorId::New();
+    authors.Save({author_id, "Author "s + author_id.ToString()});
+    std::vector<std::string> many_tags;
+    for (char tag = 'a'; tag <= 'z'; ++tag) {
+        many_tags.emplace_back(1, tag);
+    }
+
+    auto count_save = [&](const domain::Book& book) {
+        FrontendMessageCounter counter{db.GetConnectionPool()};
+        books.Save(book);
+        return counter.Count();
+    };
+    const auto tagged_id = domain::BookId::New();
+    const size_t one_tag_count = count_save({domain::BookId::New(), author_id, "One tag"s, 2000, {"a"s}});
+    const size_t many_tags_count = count_save({tagged_id, author_id, "Many tags"s, 2000, many_tags});
+    CHECK(one_tag_count == many_tags_count);
+
+    auto count_edit = [&](const std::vector<std::string>& tags) {
+        FrontendMessageCounter counter{db.GetConnectionPool()};
+        books.Edit({tagged_id, author_id, "Many tags"s, 2001, tags});
+        return counter.Count();
+    };
+    std::vector<std::string> edited_tags{many_tags.begin() + 1, many_tags.end()};
+    edited_tags.emplace_back("new"s);
+    const size_t unchanged_count = count_edit(many_tags);
+    const size_t edited_count = count_edit(edited_tags);
+    CHECK(unchanged_count == edited_count);
+    CHECK(unchanged_count == one_tag_count);
+
+    std::sort(edited_tags.begin(), edited_tags.end());
+    const auto book = books.ShowInfoByID(tagged_id);
+    CHECK(book.GetPublicationYear() == 2001);
+    CHECK(book.GetTags() == edited_tags);
+
+    authors.Delete(author_id);
+}
+
+TEST_CASE("Command batch rolls back only the failed command") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    // Пул из одного соединения: чтения внутри группы должны идти через её соединение
+    postgres::Database db{db_url, 1};
+    auto& authors = db.GetAuthors();
+    auto& batch = db.GetCommandBatch();
+
+    const auto first = domain::AuthorId::New();
+    const auto duplicate = domain::AuthorId::New();
+    const auto second = domain::AuthorId::New();
+    const std::string first_name = "Author "s + first.ToString();
+    const std::string second_name = "Author "s + second.ToString();
+
+    batch.Begin();
+    batch.BeginCommand();
+    authors.Save({first, first_name});
+    CHECK(batch.EndCommand());
+    batch.BeginCommand();
+    CHECK_THROWS(authors.Save({duplicate, first_name}));
+    CHECK_FALSE(batch.EndCommand());
+    batch.BeginCommand();
+    CHECK(authors.GetID(first_name) == first.ToString());
+    authors.Save({second, second_name});
+    CHECK(batch.EndCommand());
+    batch.Commit();
+
+    CHECK(authors.GetName(first) == first_name);
+    CHECK(authors.GetName(second) == second_name);
+    CHECK_THROWS(authors.GetName(duplicate));
+
+    batch.Begin();
+    batch.BeginCommand();
+    authors.Delete(first);
+    batch.EndCommand();
+    batch.Rollback();
+    CHECK(authors.GetName(first) == first_name);
+
+    authors.Delete(first);
+    authors.Delete(second);
+}
+
+TEST_CASE("Command batches of different threads use separate transactions") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::Database db{db_url, 2};
+    auto& authors = db.GetAuthors();
+    auto& batch = db.GetCommandBatch();
+    const auto first = domain::AuthorId::New();
+    const auto second = domain::AuthorId::New();
+    const std::string first_name = "Author "s + first.ToString();
+    const std::string second_name = "Author "s + second.ToString();
+
+    batch.Begin();
+    authors.Save({first, first_name});
+    bool other_committed = false;
+    std::thread other{[&] {
+        try {
+            batch.Begin();
+            authors.Save({second, second_name});
+            batch.Commit();
+            other_committed = true;
+        } catch (const std::exception&) {
+        }
+    }};
+    other.join();
+    CHECK(other_committed);
+    batch.Rollback();
+
+    CHECK_THROWS(authors.GetName(first));
+    CHECK(authors.GetName(second) == second_name);
+    authors.Delete(second);
+}
+
+TEST_CASE("Several imports in one command batch add each book once") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::Database db{db_url, 1};
+    auto& authors = db.GetAuthors();
+    auto& books = db.GetBooks();
+    auto& batch = db.GetCommandBatch();
+    const std::string author_name = "Author "s + domain::AuthorId::New().ToString();
+
+    // Второй пакет того же автора: временная таблица импорта к нему должна быть пуста
+    batch.Begin();
+    batch.BeginCommand();
+    books.Import({{author_name, "First batch"s, 1901, {"import"s}}});
+    books.Import({{author_name, "Second batch"s, 1902, {"import"s}}});
+    CHECK(batch.EndCommand());
+    batch.Commit();
+
+    const auto author_books = books.ShowByAuthor(domain::AuthorId::FromString(authors.GetID(author_name)));
+    REQUIRE(author_books.size() == 2);
+    CHECK(author_books[0].GetTitle() == "First batch"s);
+    CHECK(author_books[1].GetTitle() == "Second batch"s);
+
+    authors.Delete(author_name);
+}
+
+TEST_CASE("Connections dropped by the server are replaced without failing commands") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::Database db{db_url, 2};
+    auto& authors = db.GetAuthors();
+    const auto id = domain::AuthorId::New();
+    const std::string name = "Author "s + id.ToString();
+    authors.Save({id, name});
+
+    // Оба соединения пула разрываются сервером, как при его перезапуске
+    std::vector<int> pids;
+    {
+        auto first = db.GetConnectionPool().GetConnection();
+        auto second = db.GetConnectionPool().GetConnection();
+        pids = {first->backendpid(), second->backendpid()};
+    }
+    pqxx::connection admin{db_url};
+    pqxx::nontransaction terminate{admin};
+    for (int pid : pids) {
+        // Ожидание завершения процесса сервера (до 5 с)
+        terminate.exec_params("SELECT pg_terminate_backend($1, 5000)", pid);
+    }
+
+    CHECK(authors.GetName(id) == name);
+    CHECK_NOTHROW(authors.Delete(id));
+}
+
+TEST_CASE("Script keeps an author added after a failed lookup") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    bookypedia::AppConfig config;
+    config.db_url = db_url;
+    config.db_pool_size = 1;
+    bookypedia::Application app{config};
+
+    // Поиск автора по имени не находит его, и AddBook добавляет автора вместе с книгой
+    const auto suffix = domain::AuthorId::New().ToString();
+    const std::string author_name = "Author "s + suffix;
+    const std::string title = "Book "s + suffix;
+    std::istringstream script{"AddBook 2000 "s + title + '\n' + author_name + "\ny\n\n"s};
+    const auto stats = app.ExecuteScript(script, 10);
+    CHECK(stats.commands == 1);
+    CHECK(stats.rolled_back == 0);
+
+    postgres::Database db{db_url, 1};
+    const auto author_id = domain::AuthorId::FromString(db.GetAuthors().GetID(author_name));
+    const auto books = db.GetBooks().ShowByAuthor(author_id);
+    REQUIRE(books.size() == 1);
+    CHECK(books[0].GetTitle() == title);
+    db.GetAuthors().Delete(author_id);
+}
+
+TEST_CASE("Slow query log records statements with parameters and plans") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    const auto log_path = std::filesystem::temp_directory_path() / "bookypedia_slow_query_test.log";
+    std::filesystem::remove(log_path);
+    const auto id = domain::AuthorId::New();
+    const std::string name = "Author "s + id.ToString();
+    {
+        // Нулевой порог: в журнал попадает каждый запрос
+        postgres::Database db{db_url, 1, {std::chrono::microseconds{0}, log_path.string(), true}};
+        auto& authors = db.GetAuthors();
+        authors.Save({id, name});
+        CHECK(authors.GetName(id) == name);
+        authors.Delete(id);
+    }
+
+    std::ifstream log_file{log_path};
+    const std::string log{std::istreambuf_iterator<char>{log_file}, std::istreambuf_iterator<char>{}};
+    CHECK(log.find("slow query: get_author_name "s) != std::string::npos);
+    CHECK(log.find("$1 = '"s + id.ToString() + "'"s) != std::string::npos);
+    CHECK(log.find("Execution Time"s) != std::string::npos);
+    CHECK(log.find("EXPLAIN failed"s) == std::string::npos);
+    // Изменяющий запрос не выполняется повторно: в его плане нет замеров
+    const auto add_author = log.find("slow query: add_author "s);
+    REQUIRE(add_author != std::string::npos);
+    const std::string add_author_entry = log.substr(add_author, log.find("slow query: "s, add_author + 1) - add_author);
+    CHECK(add_author_entry.find("Insert on authors"s) != std::string::npos);
+    CHECK(add_author_entry.find("actual time"s) == std::string::npos);
+    std::filesystem::remove(log_path);
+}
+
+TEST_CASE("Reads fall back to the primary when a replica is unreachable") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::ReplicaSetConfig replicas{{"postgresql://127.0.0.1:1/bookypedia"s}};
+    replicas.pin_after_write = std::chrono::milliseconds{0};
+    postgres::Database db{db_url, 1, {}, std::move(replicas)};
+    auto& authors = db.GetAuthors();
+    const auto id = domain::AuthorId::New();
+    const std::string name = "Author "s + id.ToString();
+    authors.Save({id, name});
+    CHECK(authors.GetName(id) == name);
+    CHECK(authors.GetName(id) == name);
+    authors.Delete(id);
+}
+
+/* Вторым сервером может быть отдельный экземпляр PostgreSQL, а не настоящая реплика:
+ * автор, записанный только на него, виден лишь при чтении с реплики */
+constexpr const char TEST_DB_REPLICA_URL_ENV_NAME[]{"BOOKYPEDIA_TEST_DB_REPLICA_URL"};
+
+TEST_CASE("Reads go to a replica except right after a write") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    const char* replica_url = std::getenv(TEST_DB_REPLICA_URL_ENV_NAME);
+    if (!db_url || !replica_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " and "s + TEST_DB_REPLICA_URL_ENV_NAME + " are not set, skipping"s);
+        return;
+    }
+    const auto replica_only = domain::AuthorId::New();
+    const std::string replica_only_name = "Author "s + replica_only.ToString();
+    postgres::Database replica_db{replica_url, 1};
+    replica_db.GetAuthors().Save({replica_only, replica_only_name});
+
+    const auto id = domain::AuthorId::New();
+    const std::string name = "Author "s + id.ToString();
+    {
+        postgres::ReplicaSetConfig replicas{{replica_url}};
+        replicas.pin_after_write = std::chrono::milliseconds{0};
+        postgres::Database db{db_url, 1, {}, std::move(replicas)};
+        CHECK(db.GetAuthors().GetName(replica_only) == replica_only_name);
+    }
+    {
+        postgres::ReplicaSetConfig replicas{{replica_url}};
+        replicas.pin_after_write = std::chrono::minutes{1};
+        postgres::Database db{db_url, 1, {}, std::move(replicas)};
+        auto& authors = db.GetAuthors();
+        CHECK(authors.GetName(replica_only) == replica_only_name);
+        authors.Save({id, name});
+        // Сразу после записи чтение идёт на основной сервер, где этого автора нет
+        CHECK(authors.GetName(id) == name);
+        CHECK_THROWS(authors.GetName(replica_only));
+        authors.Delete(id);
+    }
+    replica_db.GetAuthors().Delete(replica_only);
+}
+
+TEST_CASE("Reads of a command share one snapshot") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::Database db{db_url, 1};
+    postgres::Database other_client{db_url, 1};
+    auto& authors = db.GetAuthors();
+    auto& snapshot = db.GetReadSnapshot();
+
+    const auto id = domain::AuthorId::New();
+    const std::string name = "Author "s + id.ToString();
+    const std::string new_name = "Renamed "s + id.ToString();
+    authors.Save({id, name});
+
+    // Снимок закрывается до подсчёта: счётчику нужно единственное соединение пула
+    auto count_reads = [&](bool in_snapshot) {
+        FrontendMessageCounter counter{db.GetConnectionPool()};
+        if (in_snapshot) {
+            snapshot.Begin();
+        }
+        authors.GetName(id);
+        authors.GetID(name);
+        snapshot.End();
+        return counter.Count();
+    };
+    const size_t separate_count = count_reads(false);
+    const size_t snapshot_count = count_reads(true);
+    CHECK(snapshot_count < separate_count);
+
+    snapshot.Begin();
+    CHECK(authors.GetName(id) == name);
+    other_client.GetAuthors().Edit({id, new_name});
+    CHECK(authors.GetName(id) == name);
+    // Ненайденный автор не прерывает снимок
+    CHECK_THROWS(authors.GetName(domain::AuthorId::New()));
+    CHECK(authors.GetID(name) == id.ToString());
+    snapshot.End();
+    CHECK(authors.GetName(id) == new_name);
+
+    // После Release снимок открыт, но следующее чтение видит изменения других клиентов
+    snapshot.Begin();
+    CHECK(authors.GetName(id) == new_name);
+    other_client.GetAuthors().Edit({id, name});
+    snapshot.Release();
+    CHECK(authors.GetName(id) == name);
+    other_client.GetAuthors().Edit({id, new_name});
+    CHECK(authors.GetName(id) == name);
+    snapshot.End();
+
+    authors.Delete(id);
+}
+
+TEST_CASE("Read snapshots belong to the threads that begin them") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::Database db{db_url, 3};
+    postgres::Database other_client{db_url, 1};
+    auto& authors = db.GetAuthors();
+    auto& snapshot = db.GetReadSnapshot();
+
+    const auto id = domain::AuthorId::New();
+    const std::string name = "Author "s + id.ToString();
+    const std::string new_name = "Renamed "s + id.ToString();
+    authors.Save({id, name});
+
+    snapshot.Begin();
+    CHECK(authors.GetName(id) == name);
+    other_client.GetAuthors().Edit({id, new_name});
+
+    // Проверки выполняются после join: Catch2 не проверяет из других потоков
+    const auto owner = std::this_thread::get_id();
+    std::string outside_name;
+    std::string attached_name;
+    std::string own_snapshot_name;
+    bool own_snapshot_began = false;
+    std::thread other{[&] {
+        outside_name = authors.GetName(id);
+        snapshot.Attach(owner);
+        attached_name = authors.GetName(id);
+        snapshot.Detach();
+        try {
+            snapshot.Begin();
+            own_snapshot_began = true;
+            own_snapshot_name = authors.GetName(id);
+            snapshot.End();
+        } catch (const std::exception&) {
+        }
+    }};
+    other.join();
+
+    CHECK(outside_name == new_name);
+    CHECK(attached_name == name);
+    CHECK(own_snapshot_began);
+    CHECK(own_snapshot_name == new_name);
+    CHECK(authors.GetName(id) == name);
+    snapshot.End();
+
+    authors.Delete(id);
+}
+
+TEST_CASE("Startup with an up-to-date schema costs one statement") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::Database db{db_url, 1};
+    postgres::ConnectionPool pool{1, [db_url] {
+                                      return std::make_shared<pqxx::connection>(db_url);
+                                  }};
+
+    FrontendMessageCounter counter{pool};
+    auto connection = pool.GetConnection();
+    CHECK(postgres::MigrateSchema(*connection) == 0);
+    CHECK(counter.Count() == 1);
+}
+
+TEST_CASE("Concurrently starting instances apply a pending migration once") {
+    const char* db_url = std::getenv(TEST_DB_URL_ENV_NAME);
+    if (!db_url) {
+        WARN(TEST_DB_URL_ENV_NAME + " is not set, skipping"s);
+        return;
+    }
+    postgres::Database db{db_url, 1};
+    const int latest = postgres::GetLatestSchemaVersion();
+    pqxx::connection connection{db_url};
+    // Последняя миграция повторно применима: она снова считается ожидающей
+    pqxx::nontransaction{connection}.exec_params("DELETE FROM schema_version WHERE version = $1", latest);
+
+    constexpr size_t INSTANCES = 4;
+    std::atomic<size_t> applied{0};
+    std::vector<std::thread> instances;
+    for (size_t i = 0; i < INSTANCES; ++i) {
+        instances.emplace_back([db_url, &applied] {
+            pqxx::connection instance_connection{db_url};
+            applied += postgres::MigrateSchema(instance_connection);
+        });
+    }
+    for (auto& instance : instances) {
+        instance.join();
+    }
+
+    CHECK(applied == 1);
+    CHECK(pqxx::nontransaction{connection}.query_value<int>("SELECT max(version) FROM schema_version")
+          == latest);
+}
@@ -0,0 +1,60 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+
+#include "../src/ui/renderer.h"
+
+using namespace std::literals;
+using ui::OutputFormat;
+using ui::Renderer;
+
+namespace {
+
+std::string RenderBooks(OutputFormat format) {
+    std::ostringstream out;
+    {
+        Renderer renderer{out, format};
+        renderer.BookRow(1, "id-1"sv, "Title\twith \"tab\""sv, "Author\\1"sv, 2001);
+        renderer.BookRow(2, "id-2"sv, "Second"sv, "Author 2"sv, 2002);
+    }
+    return out.str();
+}
+
+}  // namespace
+
+TEST_CASE("Output format names") {
+    CHECK(ui::OutputFormatFromString("text"sv) == OutputFormat::TEXT);
+    CHECK(ui::OutputFormatFromString("tsv"sv) == OutputFormat::TSV);
+    CHECK(ui::OutputFormatFromString("jsonl"sv) == OutputFormat::JSON_LINES);
+    CHECK_FALSE(ui::OutputFormatFromString("json"sv).has_value());
+}
+
+TEST_CASE("Text rows match the interactive format") {
+    CHECK(RenderBooks(OutputFormat::TEXT) == "1 Title\twith \"tab\" by Author\\1, 2001\n"
+                                             "2 Second by Author 2, 2002\n"s);
+}
+
+TEST_CASE("TSV rows have a header and escaped fields") {
+    CHECK(RenderBooks(OutputFormat::TSV) == "index\tid\ttitle\tauthor\tpublication_year\n"
+                                            "1\tid-1\tTitle\\twith \"tab\"\tAuthor\\\\1\t2001\n"
+                                            "2\tid-2\tSecond\tAuthor 2\t2002\n"s);
+}
+
+TEST_CASE("JSON lines rows are escaped objects") {
+    CHECK(RenderBooks(OutputFormat::JSON_LINES)
+          == R"({"index":1,"id":"id-1","title":"Title\twith \"tab\"","author":"Author\\1","publication_year":2001})"
+             "\n"
+             R"({"index":2,"id":"id-2","title":"Second","author":"Author 2","publication_year":2002})"
+             "\n"s);
+}
+
+TEST_CASE("Book details list tags") {
+    std::ostringstream out;
+    {
+        Renderer renderer{out, OutputFormat::JSON_LINES};
+        renderer.BookDetails("id"sv, "Title"sv, "Author"sv, 1999, {"a"s, "b\x01"s});
+    }
+    CHECK(out.str()
+          == R"({"id":"id","title":"Title","author":"Author","publication_year":1999,"tags":["a","b\u0001"]})"
+             "\n"s);
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "../src/postgres/replica_set.h"
+
+using namespace std::literals;
+
+namespace {
+
+/* Пулы реплик создают соединения по требованию, поэтому выбор реплики проверяется без сервера */
+postgres::ConnectionPool::ConnectionFactory MakeUnusedFactory(const std::string&) {
+    return []() -> std::shared_ptr<pqxx::connection> {
+        throw std::logic_error("Connections are not expected"s);
+    };
+}
+
+postgres::ReplicaSetConfig MakeConfig(postgres::ReplicaPolicy policy) {
+    postgres::ReplicaSetConfig config{{"replica-1"s, "replica-2"s}, policy};
+    config.pin_after_write = 0ms;
+    return config;
+}
+
+}  // namespace
+
+TEST_CASE("Without replicas reads go to the primary") {
+    postgres::ReplicaSet replicas{{}, 1, MakeUnusedFactory};
+    CHECK(replicas.Select() == nullptr);
+}
+
+TEST_CASE("Round robin alternates replicas") {
+    postgres::ReplicaSet replicas{MakeConfig(postgres::ReplicaPolicy::ROUND_ROBIN), 1, MakeUnusedFactory};
+    auto* first = replicas.Select();
+    auto* second = replicas.Select();
+    REQUIRE(first != nullptr);
+    REQUIRE(second != nullptr);
+    CHECK(first != second);
+    CHECK(replicas.Select() == first);
+}
+
+TEST_CASE("Least latency prefers the faster replica") {
+    postgres::ReplicaSet replicas{MakeConfig(postgres::ReplicaPolicy::LEAST_LATENCY), 1, MakeUnusedFactory};
+    auto* slow = replicas.Select();
+    auto* fast = replicas.Select();
+    REQUIRE(slow != fast);
+    {
+        postgres::ReplicaSet::LatencyProbe probe{*slow};
+        std::this_thread::sleep_for(20ms);
+    }
+    {
+        postgres::ReplicaSet::LatencyProbe probe{*fast};
+    }
+    CHECK(replicas.Select() == fast);
+    CHECK(replicas.Select() == fast);
+}
+
+TEST_CASE("Failed replica is skipped until the retry interval passes") {
+    auto config = MakeConfig(postgres::ReplicaPolicy::ROUND_ROBIN);
+    config.retry_after_failure = 1h;
+    postgres::ReplicaSet replicas{std::move(config), 1, MakeUnusedFactory};
+    auto* failed = replicas.Select();
+    auto* working = replicas.Select();
+    replicas.MarkFailed(*failed);
+    CHECK(replicas.Select() == working);
+    CHECK(replicas.Select() == working);
+    replicas.MarkFailed(*working);
+    CHECK(replicas.Select() == nullptr);
+}
+
+TEST_CASE("Reads go to the primary right after a write") {
+    auto config = MakeConfig(postgres::ReplicaPolicy::ROUND_ROBIN);
+    config.pin_after_write = 20ms;
+    postgres::ReplicaSet replicas{std::move(config), 1, MakeUnusedFactory};
+    CHECK(replicas.Select() != nullptr);
+    {
+        postgres::ReplicaSet::WriteMark write_mark{replicas};
+    }
+    CHECK(replicas.Select() == nullptr);
+    std::this_thread::sleep_for(30ms);
+    CHECK(replicas.Select() != nullptr);
+}
@@ -0,0 +1,69 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <stdexcept>
+
+#include "../src/stats/stats.h"
+
+using namespace std::literals;
+using stats::Metric;
+
+TEST_CASE("Every duration falls into a bucket with a close upper bound") {
+    for (uint64_t ns = 0; ns < 100'000; ns = ns * 5 / 4 + 1) {
+        const size_t index = Metric::BucketIndex(ns);
+        REQUIRE(index < Metric::BUCKETS);
+        const uint64_t upper = Metric::BucketUpperBound(index);
+        CHECK(ns <= upper);
+        CHECK(upper - ns <= ns / Metric::SUB_BUCKETS);
+        if (index != 0) {
+            CHECK(Metric::BucketUpperBound(index - 1) < ns);
+        }
+    }
+    CHECK(Metric::BucketIndex(uint64_t{1} << 62) == Metric::BUCKETS - 1);
+}
+
+TEST_CASE("Percentiles are taken from the histogram") {
+    Metric metric{"test"s};
+    for (int i = 1; i <= 100; ++i) {
+        metric.Record(std::chrono::microseconds{i}, i % 10 == 0);
+    }
+    const auto snapshot = metric.GetSnapshot();
+    CHECK(snapshot.count == 100);
+    CHECK(snapshot.errors == 10);
+    CHECK(snapshot.max == std::chrono::microseconds{100});
+    CHECK(snapshot.Mean() == std::chrono::nanoseconds{50'500});
+
+    const auto p50 = snapshot.Percentile(50);
+    CHECK(p50 >= std::chrono::microseconds{50});
+    CHECK(p50 <= std::chrono::nanoseconds{50'000 + 50'000 / Metric::SUB_BUCKETS});
+    CHECK(snapshot.Percentile(100) == snapshot.max);
+
+    metric.Reset();
+    CHECK(metric.GetSnapshot().count == 0);
+    CHECK(metric.GetSnapshot().Percentile(99) == std::chrono::nanoseconds{});
+}
+
+TEST_CASE("Scoped timer counts exceptions and reported failures as errors") {
+    auto& metric = stats::GetMetric("test/ScopedTimer"sv);
+    CHECK(&metric == &stats::GetMetric("test/ScopedTimer"sv));
+    metric.Reset();
+    {
+        stats::ScopedTimer timer{metric};
+    }
+    try {
+        stats::ScopedTimer timer{metric};
+        throw std::runtime_error("failed"s);
+    } catch (const std::runtime_error&) {
+    }
+    {
+        stats::ScopedTimer timer{metric};
+        timer.Fail();
+    }
+    const auto snapshot = metric.GetSnapshot();
+    CHECK(snapshot.count == 3);
+    CHECK(snapshot.errors == 2);
+
+    std::ostringstream report;
+    stats::WriteReport(report);
+    CHECK(report.str().find("test/ScopedTimer"s) != std::string::npos);
+}
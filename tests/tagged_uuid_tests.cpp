@@ -1,7 +1,12 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <boost/uuid/uuid_io.hpp>
+
+#include <vector>
+
 #include "../src/util/tagged_uuid.h"
 
+using namespace std::literals;
 using util::TaggedUUID;
 
 namespace {
@@ -13,4 +18,45 @@ TEST_CASE("UUID-String conversion") {
     auto uuid = TestUUID::New();
     auto s = uuid.ToString();
     CHECK(TestUUID::FromString(s) == uuid);
-}
\ No newline at end of file
+}
+TEST_CASE("UUID text form matches Boost") {
+    for (int i = 0; i < 100; ++i) {
+        auto uuid = TestUUID::New();
+        auto s = uuid.ToString();
+        CHECK(s == boost::uuids::to_string(*uuid));
+        CHECK(TestUUID::FromString(s) == uuid);
+    }
+}
+
+TEST_CASE("UUID parsing accepts Boost forms and rejects garbage") {
+    const auto expected = TestUUID::FromString("0123abcd-4567-89ef-0123-456789abcdef"s);
+    CHECK(expected.ToString() == "0123abcd-4567-89ef-0123-456789abcdef"s);
+    CHECK(TestUUID::FromString("0123ABCD-4567-89EF-0123-456789ABCDEF"s) == expected);
+    CHECK(TestUUID::FromString("0123abcd456789ef0123456789abcdef"s) == expected);
+    CHECK(TestUUID::FromString("{0123abcd-4567-89ef-0123-456789abcdef}"s) == expected);
+
+    CHECK_THROWS(TestUUID::FromString(""s));
+    CHECK_THROWS(TestUUID::FromString("0123abcd-4567-89ef-0123-456789abcde"s));
+    CHECK_THROWS(TestUUID::FromString("0123abcd+4567-89ef-0123-456789abcdef"s));
+    CHECK_THROWS(TestUUID::FromString("0123abcg-4567-89ef-0123-456789abcdef"s));
+    CHECK_THROWS(TestUUID::FromString("0123abcd-4567-89ef-0123-456789abcde/"s));
+    CHECK_THROWS(TestUUID::FromString("0123abcd-4567-89ef-0123-456789abcde:"s));
+    CHECK_THROWS(TestUUID::FromString("0123abcd-4567-89ef-0123-456789abcde@"s));
+    CHECK_THROWS(TestUUID::FromString("0123abcd-4567-89ef-0123-456789abcde\xc1"s));
+}
+
+TEST_CASE("Time-ordered UUIDs grow within a thread") {
+    util::SetUUIDVersion(util::UUIDVersion::TIME_ORDERED);
+    std::vector<TestUUID> ids;
+    for (int i = 0; i < 10'000; ++i) {
+        ids.push_back(TestUUID::New());
+    }
+    util::SetUUIDVersion(util::UUIDVersion::RANDOM);
+
+    for (size_t i = 1; i < ids.size(); ++i) {
+        REQUIRE(ids[i - 1].ToString() < ids[i].ToString());
+    }
+    CHECK((*ids.front()).data[6] >> 4 == 7);
+    CHECK((*ids.front()).variant() == boost::uuids::uuid::variant_rfc_4122);
+    CHECK((*TestUUID::New()).version() == boost::uuids::uuid::version_random_number_based);
+}
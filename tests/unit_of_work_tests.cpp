@@ -0,0 +1,165 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+#include <thread>
+
+#include "../src/app/unit_of_work.h"
+#include "../src/memory/memory.h"
+
+using namespace std::literals;
+
+namespace {
+
+/* Группа команд хранилища, считающая открытые и зафиксированные транзакции */
+struct CountingCommandBatch : domain::CommandBatch {
+    explicit CountingCommandBatch(domain::CommandBatch& batch)
+        : batch{batch} {
+    }
+
+    void Begin() override {
+        ++begins;
+        batch.Begin();
+    }
+    void BeginCommand() override {
+        batch.BeginCommand();
+    }
+    bool EndCommand() override {
+        return batch.EndCommand();
+    }
+    void Commit() override {
+        ++commits;
+        batch.Commit();
+    }
+    void Rollback() noexcept override {
+        ++rollbacks;
+        batch.Rollback();
+    }
+    bool IsOpen() const noexcept override {
+        return batch.IsOpen();
+    }
+
+    domain::CommandBatch& batch;
+    int begins = 0;
+    int commits = 0;
+    int rollbacks = 0;
+};
+
+}  // namespace
+
+SCENARIO("Unit of work") {
+    memory::Database db;
+    CountingCommandBatch batch{db.GetCommandBatch()};
+    app::UnitOfWork work{db.GetAuthors(), db.GetBooks(), &batch};
+    auto& authors = work.GetAuthors();
+    auto& books = work.GetBooks();
+
+    const auto london = domain::AuthorId::New();
+    db.GetAuthors().Save({london, "Jack London"s});
+
+    GIVEN("changes of several objects") {
+        work.Begin();
+        const auto melville = domain::AuthorId::New();
+        const auto moby_dick = domain::BookId::New();
+        authors.Save({melville, "Herman Melville"s});
+        books.Save({moby_dick, melville, "Moby-Dick"s, 1851});
+        authors.Edit("Jack London"s, "John Griffith London"s);
+
+        THEN("they are visible through the unit of work only") {
+            CHECK(authors.GetName(melville) == "Herman Melville"s);
+            CHECK(authors.GetID("John Griffith London"s) == london.ToString());
+            CHECK_THROWS_AS(authors.GetID("Jack London"s), std::runtime_error);
+            CHECK(books.ShowInfoWithAuthorByID(moby_dick).GetAuthorName() == "Herman Melville"s);
+            CHECK_THROWS_AS(db.GetAuthors().GetName(melville), std::runtime_error);
+            CHECK(db.GetAuthors().GetName(london) == "Jack London"s);
+        }
+
+        WHEN("the unit of work is committed") {
+            work.Commit();
+
+            THEN("they are written in one transaction") {
+                CHECK(batch.begins == 1);
+                CHECK(batch.commits == 1);
+                CHECK(db.GetAuthors().GetName(london) == "John Griffith London"s);
+                CHECK(db.GetBooks().ShowInfoByID(moby_dick).GetTitle() == "Moby-Dick"s);
+            }
+        }
+
+        WHEN("the unit of work is rolled back") {
+            work.Rollback();
+
+            THEN("nothing is written") {
+                CHECK(batch.begins == 0);
+                CHECK(db.GetAuthors().Show().size() == 1);
+                CHECK(db.GetAuthors().GetName(london) == "Jack London"s);
+            }
+        }
+    }
+
+    GIVEN("a new author and its book deleted in the same unit of work") {
+        work.Begin();
+        const auto melville = domain::AuthorId::New();
+        authors.Save({melville, "Herman Melville"s});
+        books.Save({domain::BookId::New(), melville, "Moby-Dick"s, 1851});
+        authors.Delete(melville);
+
+        THEN("commit has nothing to write") {
+            work.Commit();
+            CHECK(batch.begins == 0);
+            CHECK(db.GetBooks().ShowAll().empty());
+        }
+    }
+
+    GIVEN("a failing change") {
+        work.Begin();
+        books.Save({domain::BookId::New(), london, "White Fang"s, 1906});
+        books.Delete(domain::BookId::New());
+
+        THEN("commit rolls back the transaction and ends the unit of work") {
+            CHECK_THROWS_AS(work.Commit(), std::runtime_error);
+            CHECK(batch.rollbacks == 1);
+            CHECK(batch.commits == 0);
+            CHECK(db.GetBooks().ShowInfoByTitle("White Fang"s).empty());
+            work.Begin();
+            work.Commit();
+        }
+    }
+
+    GIVEN("a unit of work opened by another thread") {
+        work.Begin();
+
+        THEN("changes of other threads are written at once") {
+            const auto melville = domain::AuthorId::New();
+            std::thread other{[&] {
+                authors.Save({melville, "Herman Melville"s});
+            }};
+            other.join();
+            CHECK(db.GetAuthors().GetName(melville) == "Herman Melville"s);
+            work.Commit();
+            CHECK(batch.begins == 0);
+        }
+
+        THEN("another thread commits its own unit of work in its own transaction") {
+            const auto london_book = domain::BookId::New();
+            books.Save({london_book, london, "White Fang"s, 1906});
+            const auto melville = domain::AuthorId::New();
+            bool other_committed = false;
+            std::thread other{[&] {
+                try {
+                    work.Begin();
+                    authors.Save({melville, "Herman Melville"s});
+                    work.Commit();
+                    other_committed = true;
+                } catch (const std::exception&) {
+                }
+            }};
+            other.join();
+            CHECK(other_committed);
+            CHECK(db.GetAuthors().GetName(melville) == "Herman Melville"s);
+            CHECK_THROWS(db.GetBooks().ShowInfoByID(london_book));
+            work.Commit();
+            CHECK(db.GetBooks().ShowInfoByID(london_book).GetTitle() == "White Fang"s);
+            CHECK(batch.begins == 2);
+            CHECK(batch.commits == 2);
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include <catch2/catch_test_macros.hpp>
+#include <sstream>
 
 #include "../src/app/use_cases_impl.h"
 #include "../src/domain/author.h"
@@ -14,6 +15,9 @@ struct MockAuthorRepository : domain::AuthorRepository {
     std::vector<domain::Author> Show() override {
         return {};
     }
+    std::vector<domain::Author> ShowPage(const std::optional<std::string> &after_name, size_t limit) override {
+        return {};
+    }
     std::string GetName(const domain::AuthorId &id) override {return {};}
     std::string GetID(const std::string &name) override { return {}; }
     void Delete(const domain::AuthorId &id) override {}
@@ -42,8 +46,98 @@ struct MockBookRepository : domain::BookRepository {
                 {}};
     }
     std::vector<domain::Book> ShowInfoByTitle(const std::string &book_title) override {return {};}
+    std::vector<domain::BookWithAuthor> ShowAllWithAuthors(bool with_tags) override {
+        return {};
+    }
+    std::vector<domain::BookWithAuthor> ShowPageWithAuthors(const std::optional<domain::BookPageCursor> &after,
+                                                            size_t limit) override {
+        return {};
+    }
+    std::vector<domain::BookWithAuthor> ShowPageByTags(const std::vector<std::string> &tags, domain::TagMatch match,
+                                                       const std::optional<domain::BookPageCursor> &after,
+                                                       size_t limit) override {
+        return {};
+    }
+    std::vector<domain::Book> ShowPageByAuthor(const domain::AuthorId &author_id,
+                                               const std::optional<domain::AuthorBookPageCursor> &after,
+                                               size_t limit) override {
+        return {};
+    }
+    domain::BookWithAuthor ShowInfoWithAuthorByID(const domain::BookId &book_id) override {
+        return {ShowInfoByID(book_id), {}};
+    }
+    std::vector<domain::BookWithAuthor> ShowInfoWithAuthorByTitle(const std::string &book_title) override {
+        return {};
+    }
+    std::vector<domain::BookSearchResult> Search(const std::string &query,
+                                                 const std::optional<domain::BookSearchCursor> &after,
+                                                 size_t limit) override {
+        return {};
+    }
     void Delete(const domain::BookId &id) override {}
     void Edit(const domain::Book &new_book) override {}
+    void Import(const std::vector<domain::CatalogRecord> &records) override {
+        imported_batches.emplace_back(records);
+    }
+    void Export(const std::function<void(const domain::CatalogRecord&)>& visitor) override {
+        for (const auto& batch : imported_batches) {
+            for (const auto& record : batch) {
+                visitor(record);
+            }
+        }
+    }
+
+    std::vector<std::vector<domain::CatalogRecord>> imported_batches;
+};
+
+/* Группа команд и снимок записывают свои вызовы в общий журнал */
+struct MockCommandBatch : domain::CommandBatch {
+    std::vector<std::string>& calls;
+
+    explicit MockCommandBatch(std::vector<std::string>& calls)
+        : calls{calls} {
+    }
+
+    void Begin() override {
+        calls.emplace_back("batch begin");
+    }
+    void BeginCommand() override {
+    }
+    bool EndCommand() override {
+        return true;
+    }
+    void Commit() override {
+        calls.emplace_back("batch commit");
+    }
+    void Rollback() noexcept override {
+        calls.emplace_back("batch rollback");
+    }
+    bool IsOpen() const noexcept override {
+        return false;
+    }
+};
+
+struct MockSnapshot : domain::ReadSnapshot {
+    std::vector<std::string>& calls;
+
+    explicit MockSnapshot(std::vector<std::string>& calls)
+        : calls{calls} {
+    }
+    void Begin() override {
+        calls.emplace_back("snapshot begin");
+    }
+    void End() noexcept override {
+        calls.emplace_back("snapshot end");
+    }
+    void Release() noexcept override {
+        calls.emplace_back("snapshot release");
+    }
+    void Attach(std::thread::id) noexcept override {
+        calls.emplace_back("snapshot attach");
+    }
+    void Detach() noexcept override {
+        calls.emplace_back("snapshot detach");
+    }
 };
 
 struct Fixture {
@@ -68,4 +162,84 @@ SCENARIO_METHOD(Fixture, "Book Adding") {
             }
         }
     }
-}
\ No newline at end of file
+}
+
+SCENARIO_METHOD(Fixture, "Catalog Import") {
+    GIVEN("Use cases") {
+        app::UseCasesImpl use_cases{authors, books};
+
+        WHEN("Importing a catalog larger than a batch") {
+            std::istringstream catalog{
+                "author,title,publication_year,tags\n"
+                "Jack London,White Fang,1906,adventure;dog\n"
+                "Jack London,The Call of the Wild,1903,\n"
+                "Herman Melville,Moby-Dick,1851,sea\n"};
+            const size_t imported = use_cases.ImportCatalog(catalog, app::CatalogFormat::CSV, 2);
+
+            THEN("records are passed to repository in batches") {
+                CHECK(imported == 3);
+                REQUIRE(books.imported_batches.size() == 2);
+                CHECK(books.imported_batches.at(0).size() == 2);
+                CHECK(books.imported_batches.at(1).size() == 1);
+                CHECK(books.imported_batches.at(1).at(0).title == "Moby-Dick");
+            }
+        }
+    }
+}
+
+SCENARIO_METHOD(Fixture, "Catalog Export") {
+    GIVEN("Use cases with imported books") {
+        app::UseCasesImpl use_cases{authors, books};
+        books.imported_batches.push_back({{"Jack London", "White Fang", 1906, {"adventure", "dog"}},
+                                          {"Herman Melville", "Moby-Dick, or The Whale", 1851, {}}});
+
+        WHEN("Exporting the catalog as CSV") {
+            std::ostringstream output;
+            const size_t exported = use_cases.ExportCatalog(output, app::CatalogFormat::CSV);
+
+            THEN("every record is written after the header") {
+                CHECK(exported == 2);
+                CHECK(output.str() == "author,title,publication_year,tags\n"
+                                      "Jack London,White Fang,1906,adventure;dog\n"
+                                      "Herman Melville,\"Moby-Dick, or The Whale\",1851,\n");
+            }
+        }
+    }
+}
+
+SCENARIO_METHOD(Fixture, "Command Unit Of Work") {
+    GIVEN("Use cases with a command batch and a read snapshot") {
+        std::vector<std::string> calls;
+        MockCommandBatch batch{calls};
+        MockSnapshot snapshot{calls};
+        app::UseCasesImpl use_cases{authors, books, &batch, &snapshot};
+
+        WHEN("a command adds an author and a book") {
+            {
+                app::WorkScope work{use_cases};
+                const auto author_id = use_cases.AddAuthor("Jack London");
+                use_cases.AddBook(author_id.ToString(), "White Fang", 1906, {});
+                CHECK(authors.saved_authors.empty());
+                work.Commit();
+            }
+
+            THEN("reads share a snapshot closed before the single write transaction") {
+                CHECK(calls == std::vector<std::string>{"snapshot begin", "snapshot end", "batch begin",
+                                                        "batch commit"});
+                CHECK(authors.saved_authors.size() == 1);
+                CHECK(books.saved_books.size() == 1);
+            }
+        }
+
+        WHEN("a command only reads") {
+            {
+                app::ReadScope read{use_cases};
+                use_cases.ShowBookInfoByID(domain::BookId::New().ToString());
+            }
+
+            THEN("no write transaction is opened") {
+                CHECK(calls == std::vector<std::string>{"snapshot begin", "snapshot end"});
+            }
+        }
+    }
+}
@@ -0,0 +1,246 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/app/async_runner.h"
+#include "../src/app/use_cases_impl.h"
+#include "../src/memory/memory.h"
+#include "../src/menu/menu.h"
+#include "../src/ui/view.h"
+
+using namespace std::literals;
+
+namespace {
+
+/* Хранилище авторов, запоминающее запросы страниц: курсор и число полученных строк */
+struct PageRecordingAuthors : domain::AuthorRepository {
+    struct PageRequest {
+        std::optional<std::string> after;
+        size_t rows;
+    };
+
+    explicit PageRecordingAuthors(domain::AuthorRepository& authors)
+        : authors{authors} {
+    }
+
+    void Save(const domain::Author& author) override {
+        authors.Save(author);
+    }
+    std::string GetName(const domain::AuthorId& id) override {
+        return authors.GetName(id);
+    }
+    std::string GetID(const std::string& name) override {
+        return authors.GetID(name);
+    }
+    std::vector<domain::Author> Show() override {
+        return authors.Show();
+    }
+    std::vector<domain::Author> ShowPage(const std::optional<std::string>& after_name, size_t limit) override {
+        auto page = authors.ShowPage(after_name, limit);
+        requests.push_back({after_name, page.size()});
+        return page;
+    }
+    void Delete(const domain::AuthorId& id) override {
+        authors.Delete(id);
+    }
+    void Delete(const std::string& name) override {
+        authors.Delete(name);
+    }
+    void Edit(const domain::Author& new_author) override {
+        authors.Edit(new_author);
+    }
+    void Edit(const std::string& old_name, const std::string& new_name) override {
+        authors.Edit(old_name, new_name);
+    }
+
+    domain::AuthorRepository& authors;
+    std::vector<PageRequest> requests;
+};
+
+/* Снимок, запоминающий, сколько страниц было запрошено к моменту каждого Release,
+ * и владельцев снимков, к которым присоединялись фоновые запросы */
+struct ReleaseRecordingSnapshot : domain::ReadSnapshot {
+    explicit ReleaseRecordingSnapshot(const PageRecordingAuthors& authors)
+        : authors{authors} {
+    }
+
+    void Begin() override {
+    }
+    void End() noexcept override {
+    }
+    void Release() noexcept override {
+        released_after.push_back(authors.requests.size());
+    }
+    void Attach(std::thread::id owner) noexcept override {
+        attached_to.push_back(owner);
+    }
+    void Detach() noexcept override {
+    }
+
+    const PageRecordingAuthors& authors;
+    std::vector<size_t> released_after;
+    std::vector<std::thread::id> attached_to;
+};
+
+/* Имена упорядочены так же, как номера: Author 000, Author 001, ... */
+std::string AuthorName(size_t index) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "Author %03zu", index);
+    return name;
+}
+
+struct Fixture {
+    explicit Fixture(app::AsyncRunner* async_runner = nullptr)
+        : view{menu, use_cases, input, output, ui::OutputFormat::TEXT, async_runner} {
+    }
+
+    memory::Database db;
+    PageRecordingAuthors authors{db.GetAuthors()};
+    ReleaseRecordingSnapshot snapshot{authors};
+    app::UseCasesImpl use_cases{authors, db.GetBooks(), nullptr, &snapshot};
+    std::istringstream input;
+    std::ostringstream output;
+    menu::Menu menu{input, output};
+    ui::View view;
+
+    void AddAuthors(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            db.GetAuthors().Save({domain::AuthorId::New(), AuthorName(i)});
+        }
+    }
+
+    /* Команда с ответами на её вопросы */
+    std::vector<std::string> Execute(const std::string& command, const std::string& answers = {}) {
+        input.str(answers);
+        input.clear();
+        output.str({});
+        menu.Execute(command);
+        std::vector<std::string> lines;
+        std::istringstream printed{output.str()};
+        for (std::string line; std::getline(printed, line);) {
+            lines.push_back(std::move(line));
+        }
+        return lines;
+    }
+};
+
+/* Следующие страницы запрашиваются в фоне */
+struct PrefetchFixture : Fixture {
+    PrefetchFixture()
+        : Fixture{&runner} {
+    }
+
+    app::AsyncRunner runner{1};
+};
+
+}  // namespace
+
+SCENARIO_METHOD(Fixture, "Listing authors page by page") {
+    constexpr size_t PAGE_SIZE = ui::View::LIST_PAGE_SIZE;
+
+    GIVEN("no authors") {
+        THEN("the list is empty and takes one request") {
+            CHECK(Execute("ShowAuthors"s).empty());
+            REQUIRE(authors.requests.size() == 1);
+            CHECK_FALSE(authors.requests[0].after.has_value());
+        }
+    }
+
+    GIVEN("an exact multiple of the page size") {
+        AddAuthors(2 * PAGE_SIZE);
+
+        THEN("every author is listed once with through numbering") {
+            const auto lines = Execute("ShowAuthors"s);
+            REQUIRE(lines.size() == 2 * PAGE_SIZE);
+            CHECK(lines.front() == "1 "s + AuthorName(0));
+            CHECK(lines[PAGE_SIZE] == std::to_string(PAGE_SIZE + 1) + ' ' + AuthorName(PAGE_SIZE));
+            CHECK(lines.back() == std::to_string(2 * PAGE_SIZE) + ' ' + AuthorName(2 * PAGE_SIZE - 1));
+        }
+
+        THEN("the page after the last row is requested with its cursor and is empty") {
+            Execute("ShowAuthors"s);
+            REQUIRE(authors.requests.size() == 3);
+            CHECK(authors.requests[1].after == AuthorName(PAGE_SIZE - 1));
+            CHECK(authors.requests[2].after == AuthorName(2 * PAGE_SIZE - 1));
+            CHECK(authors.requests[2].rows == 0);
+        }
+
+        THEN("an author on the last page is selected by its through number") {
+            const auto lines = Execute("ShowAuthorBooks"s, "n\n"s + std::to_string(2 * PAGE_SIZE) + '\n');
+            CHECK(std::count(lines.begin(), lines.end(), "Enter n for next page or p for previous page"s) == 2);
+            CHECK(std::count(lines.begin(), lines.end(),
+                             std::to_string(2 * PAGE_SIZE) + ' ' + AuthorName(2 * PAGE_SIZE - 1)) == 1);
+            CHECK(authors.requests.back().after == AuthorName(PAGE_SIZE - 1));
+            CHECK(authors.requests.back().rows == PAGE_SIZE);
+        }
+
+        THEN("the snapshot is released before every answer, after the next page is fetched") {
+            Execute("ShowAuthorBooks"s, "n\n\n"s);
+            CHECK(snapshot.released_after == std::vector<size_t>{2, 2});
+        }
+
+        THEN("the previous page is shown again") {
+            const auto lines = Execute("ShowAuthorBooks"s, "n\np\n\n"s);
+            CHECK(std::count(lines.begin(), lines.end(), "1 "s + AuthorName(0)) == 2);
+        }
+    }
+
+    GIVEN("exactly one page") {
+        AddAuthors(PAGE_SIZE);
+
+        THEN("selection offers no other pages") {
+            const auto lines = Execute("ShowAuthorBooks"s, "\n"s);
+            CHECK(std::count(lines.begin(), lines.end(), "Enter n for next page or p for previous page"s) == 0);
+            CHECK(std::count(lines.begin(), lines.end(),
+                             std::to_string(PAGE_SIZE) + ' ' + AuthorName(PAGE_SIZE - 1)) == 1);
+        }
+    }
+}
+
+SCENARIO_METHOD(PrefetchFixture, "Prefetching pages in the background") {
+    constexpr size_t PAGE_SIZE = ui::View::LIST_PAGE_SIZE;
+    AddAuthors(PAGE_SIZE * 2 + 1);
+
+    WHEN("the authors are listed") {
+        const auto lines = Execute("ShowAuthors"s);
+
+        THEN("every page is read in the snapshot of the command thread") {
+            CHECK(lines.size() == PAGE_SIZE * 2 + 1);
+            CHECK(authors.requests.size() == 3);
+            CHECK(snapshot.attached_to == std::vector(3, std::this_thread::get_id()));
+        }
+    }
+}
+
+SCENARIO_METHOD(Fixture, "Command failures handled by the View") {
+    auto& metric = stats::GetMetric("command/AddBook"sv);
+    metric.Reset();
+
+    WHEN("a command prints a failure message") {
+        const auto lines = Execute("AddBook 2000"s);
+
+        THEN("it is counted as an error of the command") {
+            CHECK(lines == std::vector{"Failed to add book"s});
+            const auto snapshot = metric.GetSnapshot();
+            CHECK(snapshot.count == 1);
+            CHECK(snapshot.errors == 1);
+        }
+    }
+
+    WHEN("a command succeeds") {
+        db.GetAuthors().Save({domain::AuthorId::New(), "Jack London"s});
+        Execute("AddBook 1906 White Fang"s, "Jack London\n\n"s);
+
+        THEN("no error is counted") {
+            const auto snapshot = metric.GetSnapshot();
+            CHECK(snapshot.count == 1);
+            CHECK(snapshot.errors == 0);
+        }
+    }
+}